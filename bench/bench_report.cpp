@@ -0,0 +1,166 @@
+#include "bench_report.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace
+{
+// Reads the "metrics" object of a report written by writeJson(); not a
+// general JSON parser
+std::unordered_map<std::string, double> readBaselineMetrics(
+    const std::string& path
+)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        throw std::runtime_error("failed to open baseline " + path);
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    const std::string text = buffer.str();
+
+    size_t pos = text.find("\"metrics\"");
+    if (pos != std::string::npos)
+    {
+        pos = text.find('{', pos);
+    }
+    if (pos == std::string::npos)
+    {
+        throw std::runtime_error(path + " has no metrics object");
+    }
+
+    std::unordered_map<std::string, double> metrics;
+    const size_t end = text.find('}', pos);
+    while (true)
+    {
+        const size_t keyBegin = text.find('"', pos);
+        if (keyBegin == std::string::npos || keyBegin > end)
+        {
+            break;
+        }
+        const size_t keyEnd = text.find('"', keyBegin + 1);
+        const size_t colon = text.find(':', keyEnd);
+        const std::string key =
+            text.substr(keyBegin + 1, keyEnd - keyBegin - 1);
+        metrics[key] = std::strtod(text.c_str() + colon + 1, nullptr);
+        pos = colon + 1;
+    }
+    return metrics;
+}
+} // namespace
+
+void BenchReport::add(
+    const std::string& name, double value, MetricKind kind, double tolerance
+)
+{
+    metrics.push_back(Metric{
+        .name = name,
+        .value = value,
+        .kind = kind,
+        .tolerance = tolerance,
+    });
+}
+
+bool BenchReport::writeJson(const std::string& path) const
+{
+    std::ofstream out(path, std::ios::trunc);
+    if (!out)
+    {
+        return false;
+    }
+
+    out << "{\n";
+    out << "  \"script\": \"" << script << "\",\n";
+    out << "  \"seed\": " << seed << ",\n";
+    out << "  \"frames\": " << frames << ",\n";
+    out << "  \"metrics\": {\n";
+    char value[64];
+    for (size_t i = 0; i < metrics.size(); i++)
+    {
+        // Counters are written in full so Exact metrics survive the trip
+        const double v = metrics[i].value;
+        const bool integral = v == std::floor(v) && std::abs(v) < 1e15;
+        std::snprintf(value, sizeof(value), integral ? "%.0f" : "%.6g", v);
+        out << "    \"" << metrics[i].name << "\": " << value
+            << (i + 1 < metrics.size() ? ",\n" : "\n");
+    }
+    out << "  }\n";
+    out << "}\n";
+    return static_cast<bool>(out);
+}
+
+double percentile(std::vector<double>& samples, double p)
+{
+    if (samples.empty())
+    {
+        return 0.0;
+    }
+    std::sort(samples.begin(), samples.end());
+    const size_t rank = static_cast<size_t>(
+        std::ceil(p / 100.0 * static_cast<double>(samples.size()))
+    );
+    return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+}
+
+bool compareWithBaseline(
+    const BenchReport& report, const std::string& baselinePath,
+    double toleranceOverride
+)
+{
+    const auto baseline = readBaselineMetrics(baselinePath);
+
+    bool passed = true;
+    char line[192];
+    std::cout << "Comparing against " << baselinePath << ":\n";
+    for (const Metric& metric : report.metrics)
+    {
+        auto it = baseline.find(metric.name);
+        if (it == baseline.end())
+        {
+            std::cout << "  " << metric.name << ": missing from baseline\n";
+            passed = false;
+            continue;
+        }
+
+        const double expected = it->second;
+        const double tolerance =
+            toleranceOverride >= 0.0 ? toleranceOverride : metric.tolerance;
+        const double change =
+            expected != 0.0 ? (metric.value - expected) / std::abs(expected)
+                            : (metric.value != 0.0 ? 1.0 : 0.0);
+
+        bool regressed = false;
+        switch (metric.kind)
+        {
+        case MetricKind::LowerIsBetter:
+            regressed = change > tolerance;
+            break;
+        case MetricKind::HigherIsBetter:
+            regressed = change < -tolerance;
+            break;
+        case MetricKind::Exact:
+            regressed = metric.value != expected;
+            break;
+        }
+        passed = passed && !regressed;
+
+        std::snprintf(
+            line,
+            sizeof(line),
+            "  %-20s %12.6g  baseline %12.6g  %+7.1f%%  %s\n",
+            metric.name.c_str(),
+            metric.value,
+            expected,
+            change * 100.0,
+            regressed ? "REGRESSED" : "ok"
+        );
+        std::cout << line;
+    }
+    return passed;
+}
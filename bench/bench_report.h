@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class MetricKind : uint8_t
+{
+    LowerIsBetter,
+    HigherIsBetter,
+    // Replay outputs that must match the baseline bit for bit; a difference
+    // means the run was not deterministic or the engine's output changed
+    Exact,
+};
+
+struct Metric
+{
+    std::string name;
+    double value{ 0.0 };
+    MetricKind kind{ MetricKind::LowerIsBetter };
+    // Allowed relative change in the bad direction; unused for Exact
+    double tolerance{ 0.10 };
+};
+
+struct BenchReport
+{
+    std::string script;
+    uint64_t seed{ 0 };
+    uint32_t frames{ 0 };
+    std::vector<Metric> metrics;
+
+    void add(
+        const std::string& name, double value, MetricKind kind,
+        double tolerance = 0.10
+    );
+    bool writeJson(const std::string& path) const;
+};
+
+// Nearest-rank percentile, p in [0, 100]; sorts the samples in place
+double percentile(std::vector<double>& samples, double p);
+
+// Prints one line per metric and returns false if any metric regressed
+// beyond its tolerance or is missing from the baseline. A tolerance override
+// below zero keeps the per-metric defaults.
+bool compareWithBaseline(
+    const BenchReport& report, const std::string& baselinePath,
+    double toleranceOverride = -1.0
+);
@@ -0,0 +1,327 @@
+#include "chunk_map_bench.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "core/jobs/epoch.h"
+#include "world/chunk_map.h"
+
+namespace
+{
+// Loaded chunks; lookups also probe a ring just outside for misses
+constexpr int RADIUS{ 8 };
+constexpr int VERTICAL_RADIUS{ 1 };
+constexpr uint32_t LOOKUPS_PER_THREAD{ 2'000'000 };
+// Lookups per EpochGuard, as a mesher job would batch them
+constexpr uint32_t LOOKUPS_PER_GUARD{ 256 };
+constexpr uint32_t MAX_THREADS{ 64 };
+// Writer operations between reclaims
+constexpr uint32_t RECLAIM_INTERVAL{ 64 };
+
+using Clock = std::chrono::steady_clock;
+
+// What World looked like before ChunkMap
+struct LockedMap
+{
+    std::mutex mutex;
+    std::unordered_map<ChunkCoord, Chunk*, ChunkCoordHash> chunks;
+
+    Chunk* find(const ChunkCoord& coord)
+    {
+        std::lock_guard lock(mutex);
+        auto it = chunks.find(coord);
+        return it != chunks.end() ? it->second : nullptr;
+    }
+};
+
+// Cheap per-thread generator; lookups must not wait on a shared one
+struct XorShift
+{
+    uint64_t state;
+
+    uint32_t next()
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return static_cast<uint32_t>(state >> 32);
+    }
+};
+
+std::vector<ChunkCoord> boxCoords(int radius, int verticalRadius)
+{
+    std::vector<ChunkCoord> coords;
+    for (int y = -verticalRadius; y <= verticalRadius; y++)
+    {
+        for (int z = -radius; z <= radius; z++)
+        {
+            for (int x = -radius; x <= radius; x++)
+            {
+                coords.emplace_back(x, y, z);
+            }
+        }
+    }
+    return coords;
+}
+
+// Chunks on the outermost ring, which the writer keeps replacing
+std::vector<ChunkCoord> edgeCoords()
+{
+    std::vector<ChunkCoord> edge;
+    for (const ChunkCoord& coord : boxCoords(RADIUS, VERTICAL_RADIUS))
+    {
+        if (std::max(std::abs(coord.x), std::abs(coord.z)) == RADIUS)
+        {
+            edge.push_back(coord);
+        }
+    }
+    return edge;
+}
+
+// Runs `threads` readers against `lookup` while `write` is called in a loop
+// on one more thread; returns lookups per second over all readers
+template <typename Lookup, typename Write>
+double measureLookups(uint32_t threads, Lookup&& lookup, Write&& write)
+{
+    const std::vector<ChunkCoord> probes =
+        boxCoords(RADIUS + 1, VERTICAL_RADIUS + 1);
+    std::atomic<uint32_t> ready{ 0 };
+    std::atomic<bool> go{ false };
+    std::atomic<bool> readersDone{ false };
+    std::atomic<uint64_t> checksum{ 0 };
+
+    std::thread writer([&] {
+        uint32_t op = 0;
+        while (!readersDone.load(std::memory_order_relaxed))
+        {
+            write(op++);
+        }
+    });
+
+    std::vector<std::thread> readers;
+    for (uint32_t t = 0; t < threads; t++)
+    {
+        readers.emplace_back([&, t] {
+            XorShift rng{ 0x9E3779B97F4A7C15ull * (t + 1) };
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+            uint64_t sum = 0;
+            for (uint32_t i = 0; i < LOOKUPS_PER_THREAD;
+                 i += LOOKUPS_PER_GUARD)
+            {
+                EpochGuard guard;
+                for (uint32_t j = 0; j < LOOKUPS_PER_GUARD; j++)
+                {
+                    const ChunkCoord& coord =
+                        probes[rng.next() % probes.size()];
+                    if (const Chunk* chunk = lookup(coord))
+                    {
+                        sum += static_cast<uint32_t>(chunk->coord().x);
+                    }
+                }
+            }
+            checksum.fetch_add(sum, std::memory_order_relaxed);
+        });
+    }
+
+    while (ready.load() < threads)
+    {
+        std::this_thread::yield();
+    }
+    const auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (std::thread& reader : readers)
+    {
+        reader.join();
+    }
+    const double seconds =
+        std::chrono::duration<double>(Clock::now() - start).count();
+    readersDone.store(true);
+    writer.join();
+
+    // Keeps the lookups from being optimized out
+    if (checksum.load() == 1)
+    {
+        std::cout << '\n';
+    }
+    return static_cast<double>(threads) * LOOKUPS_PER_THREAD / seconds;
+}
+
+// Nanoseconds per 27-chunk gather around every interior chunk
+template <typename Gather> double measureGathers(Gather&& gather)
+{
+    constexpr int ROUNDS{ 20 };
+    const std::vector<ChunkCoord> centers =
+        boxCoords(RADIUS - 1, VERTICAL_RADIUS);
+    std::array<const Chunk*, 27> chunks{};
+    uint64_t found = 0;
+
+    const auto start = Clock::now();
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        for (const ChunkCoord& center : centers)
+        {
+            gather(center, chunks);
+            for (const Chunk* chunk : chunks)
+            {
+                found += chunk != nullptr;
+            }
+        }
+    }
+    const double seconds =
+        std::chrono::duration<double>(Clock::now() - start).count();
+    if (found == 1)
+    {
+        std::cout << '\n';
+    }
+    return seconds * 1e9 / (static_cast<double>(centers.size()) * ROUNDS);
+}
+} // namespace
+
+BenchReport runChunkMapBench()
+{
+    const std::vector<ChunkCoord> coords = boxCoords(RADIUS, VERTICAL_RADIUS);
+    const std::vector<ChunkCoord> edge = edgeCoords();
+    BenchReport report{
+        .script = "chunk_map_contention",
+        .seed = 0,
+        .frames = 0,
+        .metrics = {},
+    };
+
+    std::vector<uint32_t> threadCounts;
+    const uint32_t cores = std::clamp(
+        std::thread::hardware_concurrency(),
+        1u,
+        MAX_THREADS
+    );
+    for (uint32_t threads = 1; threads <= cores; threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+
+    std::cout << "Chunk map contention, " << coords.size() << " chunks\n";
+    for (uint32_t threads : threadCounts)
+    {
+        // Fresh maps per run so earlier writer churn does not carry over
+        ChunkMap map;
+        for (const ChunkCoord& coord : coords)
+        {
+            map.insert(new Chunk(coord));
+        }
+        const double lockFree = measureLookups(
+            threads,
+            [&](const ChunkCoord& coord) { return map.find(coord); },
+            [&](uint32_t op) {
+                const ChunkCoord& coord = edge[op % edge.size()];
+                if (Chunk* chunk = map.remove(coord))
+                {
+                    EpochReclaimer::get().retire(chunk);
+                }
+                map.insert(new Chunk(coord));
+                if (op % RECLAIM_INTERVAL == 0)
+                {
+                    EpochReclaimer::get().reclaim();
+                }
+            }
+        );
+        map.forEach([&](Chunk& chunk) { delete map.remove(chunk.coord()); });
+        EpochReclaimer::get().reclaim();
+
+        // The locked map's writer re-inserts the same chunks; freeing is
+        // not what is being compared
+        std::vector<std::unique_ptr<Chunk>> owned;
+        LockedMap locked;
+        for (const ChunkCoord& coord : coords)
+        {
+            owned.push_back(std::make_unique<Chunk>(coord));
+            locked.chunks[coord] = owned.back().get();
+        }
+        const double mutexed = measureLookups(
+            threads,
+            [&](const ChunkCoord& coord) { return locked.find(coord); },
+            [&](uint32_t op) {
+                const ChunkCoord& coord = edge[op % edge.size()];
+                std::lock_guard lock(locked.mutex);
+                auto it = locked.chunks.find(coord);
+                Chunk* chunk = it->second;
+                locked.chunks.erase(it);
+                locked.chunks[coord] = chunk;
+            }
+        );
+
+        std::cout << "  " << threads << " readers: chunk map "
+                  << lockFree / 1e6 << " M/s, locked map " << mutexed / 1e6
+                  << " M/s\n";
+        const std::string suffix = "_t" + std::to_string(threads);
+        // Thread scheduling makes these noisier than the replay metrics
+        report.add(
+            "chunk_map_mlookups_per_s" + suffix,
+            lockFree / 1e6,
+            MetricKind::HigherIsBetter,
+            0.25
+        );
+        report.add(
+            "locked_map_mlookups_per_s" + suffix,
+            mutexed / 1e6,
+            MetricKind::HigherIsBetter,
+            0.25
+        );
+    }
+
+    ChunkMap map;
+    for (const ChunkCoord& coord : coords)
+    {
+        map.insert(new Chunk(coord));
+    }
+    const double tableNs = measureGathers(
+        [&](const ChunkCoord& center, std::array<const Chunk*, 27>& chunks) {
+            EpochGuard guard;
+            for (int i = 0; i < 27; i++)
+            {
+                chunks[i] = map.find(
+                    center + glm::ivec3(i % 3 - 1, i / 9 - 1, (i / 3) % 3 - 1)
+                );
+            }
+        }
+    );
+    const double cachedNs = measureGathers(
+        [&](const ChunkCoord& center, std::array<const Chunk*, 27>& chunks) {
+            EpochGuard guard;
+            const Chunk* chunk = map.find(center);
+            for (int i = 0; i < 27; i++)
+            {
+                chunks[i] = chunk->neighbor(i);
+            }
+        }
+    );
+    map.forEach([&](Chunk& chunk) { delete map.remove(chunk.coord()); });
+    EpochReclaimer::get().reclaim();
+
+    std::cout << "  27-chunk gather: table " << tableNs << " ns, cached "
+              << cachedNs << " ns\n";
+    report.add(
+        "gather_table_ns",
+        tableNs,
+        MetricKind::LowerIsBetter,
+        0.25
+    );
+    report.add(
+        "gather_cached_ns",
+        cachedNs,
+        MetricKind::LowerIsBetter,
+        0.25
+    );
+    return report;
+}
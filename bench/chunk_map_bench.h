@@ -0,0 +1,10 @@
+#pragma once
+
+#include "bench/bench_report.h"
+
+// Lookup throughput of ChunkMap against a mutex-guarded unordered_map, the
+// setup World used before, with 1, 2, 4, ... reader threads up to the core
+// count while one writer streams chunks in and out at the edge. Also times
+// 27-chunk neighbourhood gathers through the table and through the
+// neighbour cache. Needs no GPU.
+BenchReport runChunkMapBench();
@@ -0,0 +1,171 @@
+#include "replay_script.h"
+#include <algorithm>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+
+namespace
+{
+BlockId parseBlock(const std::string& token)
+{
+    if (const std::optional<BlockId> id = findBlock(token))
+    {
+        return *id;
+    }
+    size_t end{ 0 };
+    const unsigned long id = std::stoul(token, &end);
+    if (end != token.size() || id >= blockCount())
+    {
+        throw std::invalid_argument("unknown block " + token);
+    }
+    return static_cast<BlockId>(id);
+}
+} // namespace
+
+ViewerState ReplayScript::cameraAt(uint32_t frame) const
+{
+    if (cameraKeys.empty())
+    {
+        return ViewerState{};
+    }
+    auto next = std::upper_bound(
+        cameraKeys.begin(),
+        cameraKeys.end(),
+        frame,
+        [](uint32_t f, const CameraKey& key) { return f < key.frame; }
+    );
+    if (next == cameraKeys.begin())
+    {
+        return next->viewer;
+    }
+    if (next == cameraKeys.end())
+    {
+        return cameraKeys.back().viewer;
+    }
+
+    const CameraKey& previous = *(next - 1);
+    const float t = static_cast<float>(frame - previous.frame) /
+                    static_cast<float>(next->frame - previous.frame);
+    return ViewerState{
+        .position =
+            glm::mix(previous.viewer.position, next->viewer.position, t),
+        .yaw = glm::mix(previous.viewer.yaw, next->viewer.yaw, t),
+        .pitch = glm::mix(previous.viewer.pitch, next->viewer.pitch, t),
+    };
+}
+
+ReplayScript loadReplayScript(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        throw std::runtime_error("failed to open replay script " + path);
+    }
+
+    ReplayScript script{
+        .name = path,
+        .seed = 0,
+        .frames = 0,
+        .viewRadius = 4,
+        .cameraKeys = {},
+        .edits = {},
+    };
+    std::string line;
+    for (uint32_t lineNumber = 1; std::getline(file, line); lineNumber++)
+    {
+        line = line.substr(0, line.find('#'));
+        std::istringstream in(line);
+        std::string command;
+        if (!(in >> command))
+        {
+            continue;
+        }
+
+        bool valid = true;
+        try
+        {
+            if (command == "seed")
+            {
+                valid = static_cast<bool>(in >> script.seed);
+            }
+            else if (command == "frames")
+            {
+                valid = static_cast<bool>(in >> script.frames);
+            }
+            else if (command == "radius")
+            {
+                valid = static_cast<bool>(in >> script.viewRadius) &&
+                        script.viewRadius > 0;
+            }
+            else if (command == "camera")
+            {
+                CameraKey key;
+                valid = static_cast<bool>(
+                    in >> key.frame >> key.viewer.position.x >>
+                    key.viewer.position.y >> key.viewer.position.z >>
+                    key.viewer.yaw >> key.viewer.pitch
+                );
+                script.cameraKeys.push_back(key);
+            }
+            else if (command == "edit" || command == "fill")
+            {
+                ScriptEdit edit;
+                std::string block;
+                valid = static_cast<bool>(
+                    in >> edit.frame >> edit.min.x >> edit.min.y >> edit.min.z
+                );
+                edit.max = edit.min;
+                if (valid && command == "fill")
+                {
+                    valid = static_cast<bool>(
+                        in >> edit.max.x >> edit.max.y >> edit.max.z
+                    );
+                }
+                valid = valid && static_cast<bool>(in >> block);
+                if (valid)
+                {
+                    edit.block = parseBlock(block);
+                    const glm::ivec3 corner = edit.min;
+                    edit.min = glm::min(corner, edit.max);
+                    edit.max = glm::max(corner, edit.max);
+                    script.edits.push_back(edit);
+                }
+            }
+            else
+            {
+                valid = false;
+            }
+        }
+        catch (const std::exception&)
+        {
+            valid = false;
+        }
+
+        if (!valid)
+        {
+            throw std::runtime_error(
+                path + ":" + std::to_string(lineNumber) + ": cannot parse '" +
+                line + "'"
+            );
+        }
+    }
+
+    if (script.frames == 0)
+    {
+        throw std::runtime_error(path + ": no frame count given");
+    }
+
+    // Stable, so edits on the same frame keep their script order
+    auto byFrame = [](const auto& a, const auto& b) {
+        return a.frame < b.frame;
+    };
+    std::stable_sort(
+        script.cameraKeys.begin(),
+        script.cameraKeys.end(),
+        byFrame
+    );
+    std::stable_sort(script.edits.begin(), script.edits.end(), byFrame);
+    return script;
+}
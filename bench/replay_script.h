@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "world/block.h"
+#include "world/simulation_thread.h"
+
+// Camera position on a given frame; frames between keys are interpolated
+struct CameraKey
+{
+    uint32_t frame{ 0 };
+    ViewerState viewer;
+};
+
+// Fills the box [min, max] with one block on the given frame
+struct ScriptEdit
+{
+    uint32_t frame{ 0 };
+    glm::ivec3 min{ 0 };
+    glm::ivec3 max{ 0 };
+    BlockId block{ Blocks::AIR };
+};
+
+// A recorded benchmark run. The text format is line based, '#' starts a
+// comment and all coordinates are in blocks:
+//
+//     seed 1337
+//     frames 600
+//     radius 6                         # chunks streamed around the camera
+//     camera <frame> <x> <y> <z> <yaw> <pitch>
+//     edit <frame> <x> <y> <z> <block>
+//     fill <frame> <x0> <y0> <z0> <x1> <y1> <z1> <block>
+//
+// Blocks are given by name (stone, water, ...) or by numeric id.
+struct ReplayScript
+{
+    std::string name;
+    uint64_t seed{ 0 };
+    uint32_t frames{ 0 };
+    int viewRadius{ 4 };
+    std::vector<CameraKey> cameraKeys; // ascending frames
+    std::vector<ScriptEdit> edits;     // ascending frames
+
+    ViewerState cameraAt(uint32_t frame) const;
+};
+
+// Throws std::runtime_error naming the offending line
+ReplayScript loadReplayScript(const std::string& path);
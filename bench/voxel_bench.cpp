@@ -0,0 +1,515 @@
+#include "../bench/bench_report.h"
+#include "../bench/chunk_map_bench.h"
+#include "../bench/replay_script.h"
+#include "../core/jobs/job_system.h"
+#include "../core/platform/process_memory.h"
+#include "../core/profiling/profiler.h"
+#include "../gfx/vulkan/context.h"
+#include "../gfx/vulkan/memory_manager.h"
+#include "../gfx/vulkan/mesh_arena.h"
+#include "../world/block.h"
+#include "../world/lighting.h"
+#include "../world/mesher.h"
+#include "../world/simulation.h"
+#include "../world/terrain.h"
+#include "../world/visibility.h"
+#include "../world/world.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+// Streaming is spread over frames like it would be in the game
+constexpr size_t MAX_GENERATED_PER_FRAME{ 64 };
+// Chunk rows generated above and below the camera
+constexpr int VERTICAL_RADIUS{ 2 };
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+struct BenchOptions
+{
+    std::string scriptPath;
+    std::string reportPath{ "bench_report.json" };
+    std::string baselinePath;
+    uint32_t frames{ 0 };
+    double tolerance{ -1.0 };
+    // Runs the chunk map contention benchmark instead of a script
+    bool chunkMap{ false };
+};
+
+struct BenchTotals
+{
+    std::vector<double> frameMs;
+    uint64_t chunksGenerated{ 0 };
+    uint64_t chunksMeshed{ 0 };
+    uint64_t quadsMeshed{ 0 };
+    uint64_t bytesUploaded{ 0 };
+    uint64_t blocksEdited{ 0 };
+    // Summed over frames
+    uint64_t chunksVisible{ 0 };
+    uint64_t chunksConsidered{ 0 };
+    double generateSeconds{ 0.0 };
+    double meshSeconds{ 0.0 };
+    double uploadSeconds{ 0.0 };
+    double visibilitySeconds{ 0.0 };
+    uint64_t peakGpuBytes{ 0 };
+};
+
+void printUsage()
+{
+    std::cout
+        << "usage: voxel-bench <script> [--frames N] [--report out.json]\n"
+           "                   [--baseline baseline.json] [--tolerance T]\n"
+           "       voxel-bench --chunk-map [--report out.json] ...\n"
+           "Runs a replay script headless and writes a JSON report. With\n"
+           "--baseline the exit code is 1 if any metric regressed.\n"
+           "--chunk-map measures chunk lookups under contention instead.\n";
+}
+
+bool parseOptions(int argc, char** argv, BenchOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--frames") == 0 && hasValue)
+        {
+            options.frames = static_cast<uint32_t>(std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--report") == 0 && hasValue)
+        {
+            options.reportPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--baseline") == 0 && hasValue)
+        {
+            options.baselinePath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--tolerance") == 0 && hasValue)
+        {
+            options.tolerance = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--chunk-map") == 0)
+        {
+            options.chunkMap = true;
+        }
+        else if (argv[i][0] != '-' && options.scriptPath.empty())
+        {
+            options.scriptPath = argv[i];
+        }
+        else
+        {
+            return false;
+        }
+    }
+    // Either a script or --chunk-map
+    return options.chunkMap ? options.scriptPath.empty()
+                            : !options.scriptPath.empty();
+}
+
+// Writes the report and checks it against the baseline; returns the exit
+// code
+int finishReport(const BenchReport& report, const BenchOptions& options)
+{
+    if (!report.writeJson(options.reportPath))
+    {
+        std::cerr << "failed to write " << options.reportPath << '\n';
+        return 2;
+    }
+    std::cout << "Report written to " << options.reportPath << '\n';
+
+    // VOXEL_TRACE=trace.json dumps the run for chrome://tracing/Perfetto
+    if (const char* tracePath = std::getenv("VOXEL_TRACE"))
+    {
+        Profiler::get().writeChromeTrace(tracePath);
+    }
+
+    if (!options.baselinePath.empty() &&
+        !compareWithBaseline(report, options.baselinePath, options.tolerance))
+    {
+        std::cout << "Performance regression against baseline\n";
+        return 1;
+    }
+    return 0;
+}
+
+// Missing chunks around the camera, nearest first; the order only depends
+// on the camera position so replays stream identically
+std::vector<ChunkCoord> missingChunks(
+    const World& world, const ChunkCoord& center, int radius
+)
+{
+    std::vector<ChunkCoord> missing;
+    for (int y = -VERTICAL_RADIUS; y <= VERTICAL_RADIUS; y++)
+    {
+        for (int z = -radius; z <= radius; z++)
+        {
+            for (int x = -radius; x <= radius; x++)
+            {
+                const ChunkCoord coord = center + glm::ivec3(x, y, z);
+                if (!world.getChunk(coord))
+                {
+                    missing.push_back(coord);
+                }
+            }
+        }
+    }
+    auto distance = [&](const ChunkCoord& coord) {
+        const glm::ivec3 d = coord - center;
+        return d.x * d.x + d.y * d.y + d.z * d.z;
+    };
+    std::stable_sort(
+        missing.begin(),
+        missing.end(),
+        [&](const ChunkCoord& a, const ChunkCoord& b) {
+            return distance(a) < distance(b);
+        }
+    );
+    return missing;
+}
+
+BenchReport makeReport(
+    const ReplayScript& script, uint32_t frames, BenchTotals& totals
+)
+{
+    auto perSecond = [](double count, double seconds) {
+        return seconds > 0.0 ? count / seconds : 0.0;
+    };
+    double frameSum = 0.0;
+    for (double ms : totals.frameMs)
+    {
+        frameSum += ms;
+    }
+
+    BenchReport report{
+        .script = script.name,
+        .seed = script.seed,
+        .frames = frames,
+        .metrics = {},
+    };
+    // Tail latencies are noisier than the median and get more headroom
+    report.add(
+        "frame_ms_mean",
+        frameSum / static_cast<double>(std::max<size_t>(1, frames)),
+        MetricKind::LowerIsBetter
+    );
+    report.add(
+        "frame_ms_p50",
+        percentile(totals.frameMs, 50.0),
+        MetricKind::LowerIsBetter
+    );
+    report.add(
+        "frame_ms_p95",
+        percentile(totals.frameMs, 95.0),
+        MetricKind::LowerIsBetter,
+        0.15
+    );
+    report.add(
+        "frame_ms_p99",
+        percentile(totals.frameMs, 99.0),
+        MetricKind::LowerIsBetter,
+        0.25
+    );
+    report.add(
+        "frame_ms_max",
+        percentile(totals.frameMs, 100.0),
+        MetricKind::LowerIsBetter,
+        0.50
+    );
+    report.add(
+        "gen_chunks_per_s",
+        perSecond(
+            static_cast<double>(totals.chunksGenerated),
+            totals.generateSeconds
+        ),
+        MetricKind::HigherIsBetter
+    );
+    report.add(
+        "mesh_chunks_per_s",
+        perSecond(static_cast<double>(totals.chunksMeshed), totals.meshSeconds),
+        MetricKind::HigherIsBetter
+    );
+    report.add(
+        "upload_mb_per_s",
+        perSecond(
+            static_cast<double>(totals.bytesUploaded) / (1024.0 * 1024.0),
+            totals.uploadSeconds
+        ),
+        MetricKind::HigherIsBetter
+    );
+    report.add(
+        "visibility_ms_mean",
+        totals.visibilitySeconds * 1000.0 /
+            static_cast<double>(std::max<size_t>(1, frames)),
+        MetricKind::LowerIsBetter
+    );
+    report.add(
+        "peak_vma_mb",
+        static_cast<double>(totals.peakGpuBytes) / (1024.0 * 1024.0),
+        MetricKind::LowerIsBetter,
+        0.05
+    );
+    report.add(
+        "peak_rss_mb",
+        static_cast<double>(peakResidentBytes()) / (1024.0 * 1024.0),
+        MetricKind::LowerIsBetter,
+        0.05
+    );
+    report.add(
+        "chunks_generated",
+        static_cast<double>(totals.chunksGenerated),
+        MetricKind::Exact
+    );
+    report.add(
+        "chunks_meshed",
+        static_cast<double>(totals.chunksMeshed),
+        MetricKind::Exact
+    );
+    report.add(
+        "quads_meshed",
+        static_cast<double>(totals.quadsMeshed),
+        MetricKind::Exact
+    );
+    report.add(
+        "blocks_edited",
+        static_cast<double>(totals.blocksEdited),
+        MetricKind::Exact
+    );
+    report.add(
+        "chunks_visible",
+        static_cast<double>(totals.chunksVisible),
+        MetricKind::Exact
+    );
+    // Chunks with connectivity per frame, summed; visible / considered is
+    // what connectivity culling kept
+    report.add(
+        "chunks_considered",
+        static_cast<double>(totals.chunksConsidered),
+        MetricKind::Exact
+    );
+    return report;
+}
+} // namespace
+
+// Headless, deterministic replay of a recorded session.
+//
+// Every frame advances the simulation by exactly one tick and streams,
+// lights, meshes and uploads whatever that tick produced, so two runs of the
+// same script do identical work; only the timings differ. Frames are not
+// paced, which makes frame time a measure of CPU cost plus GPU upload.
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 2;
+    }
+
+    try
+    {
+        PROFILE_THREAD_NAME("main");
+        freezeBlockRegistry();
+        if (options.chunkMap)
+        {
+            return finishReport(runChunkMapBench(), options);
+        }
+
+        const ReplayScript script = loadReplayScript(options.scriptPath);
+        const uint32_t frames =
+            options.frames ? options.frames : script.frames;
+
+        JobSystem jobs;
+        VulkanContext ctx;
+        ctx.initHeadless(
+            jobs,
+            VulkanContextConfig{
+                .validation = validationFromEnvironment(),
+                // A warm cache from earlier runs would skew the numbers
+                .pipelineCachePath = "",
+            }
+        );
+
+        GpuMemoryManager gpuMemory;
+        MeshArena meshArena;
+        meshArena.init(ctx.getDevice(), ctx.getAllocator(), &gpuMemory);
+        gpuMemory.init(ctx.getAllocator(), meshArena);
+        ChunkCoord cameraChunk{ 0 };
+        gpuMemory.setEvictionHandler([&](uint64_t bytesToFree) {
+            meshArena.evictFarthest(cameraChunk, bytesToFree);
+        });
+
+        World world;
+        BlockSimulation simulation(world, jobs);
+        LightEngine lighting(world, jobs);
+        const TerrainGenerator terrain(script.seed);
+
+        BenchTotals totals;
+        totals.frameMs.reserve(frames);
+        size_t nextEdit = 0;
+        std::vector<BlockChange> edits;
+        std::vector<Chunk*> generated;
+        std::vector<ChunkMesh> meshes;
+        std::vector<ChunkConnectivity> connectivity;
+        ChunkVisibility visibility;
+        std::vector<ChunkCoord> visibleChunks;
+
+        std::cout << "Replaying " << script.name << " for " << frames
+                  << " frames\n";
+        for (uint32_t frame = 0; frame < frames; frame++)
+        {
+            PROFILE_ZONE("frame");
+            const auto frameStart = Clock::now();
+            VkCommandBuffer cmd = ctx.beginHeadlessFrame();
+            meshArena.beginFrame(ctx.getCurrentFrame());
+
+            const ViewerState camera = script.cameraAt(frame);
+            cameraChunk =
+                toChunkCoord(glm::ivec3(glm::floor(camera.position)));
+
+            // Stream in terrain around the camera
+            auto stageStart = Clock::now();
+            generated.clear();
+            for (const ChunkCoord& coord :
+                 missingChunks(world, cameraChunk, script.viewRadius))
+            {
+                if (generated.size() == MAX_GENERATED_PER_FRAME)
+                {
+                    break;
+                }
+                generated.push_back(&world.createChunk(coord));
+            }
+            jobs.parallelFor(
+                static_cast<uint32_t>(generated.size()),
+                1,
+                [&](uint32_t begin, uint32_t end) {
+                    for (uint32_t i = begin; i < end; i++)
+                    {
+                        terrain.generate(*generated[i]);
+                    }
+                }
+            );
+            for (Chunk* chunk : generated)
+            {
+                lighting.onChunkLoaded(chunk->coord());
+            }
+            totals.chunksGenerated += generated.size();
+            totals.generateSeconds += secondsSince(stageStart);
+
+            // Scripted edits, then one simulation tick
+            edits.clear();
+            for (; nextEdit < script.edits.size() &&
+                   script.edits[nextEdit].frame <= frame;
+                 nextEdit++)
+            {
+                const ScriptEdit& edit = script.edits[nextEdit];
+                for (int y = edit.min.y; y <= edit.max.y; y++)
+                {
+                    for (int z = edit.min.z; z <= edit.max.z; z++)
+                    {
+                        for (int x = edit.min.x; x <= edit.max.x; x++)
+                        {
+                            const glm::ivec3 pos{ x, y, z };
+                            const BlockId previous = world.getBlock(pos);
+                            if (world.setBlock(pos, edit.block))
+                            {
+                                edits.push_back(BlockChange{
+                                    .pos = pos,
+                                    .previous = previous,
+                                    .current = edit.block,
+                                });
+                                simulation.activate(pos);
+                            }
+                        }
+                    }
+                }
+            }
+            totals.blocksEdited += edits.size();
+            simulation.tick();
+            lighting.onBlocksChanged(edits);
+            lighting.onBlocksChanged(simulation.changes());
+            lighting.update();
+
+            // Mesh everything the tick touched. Dirty coords include the
+            // neighbours of border cells, which may never have loaded;
+            // like SimulationThread, skip them rather than count them
+            std::vector<ChunkCoord> dirty = lighting.takeDirtyChunks();
+            std::erase_if(dirty, [&](const ChunkCoord& coord) {
+                return world.getChunk(coord) == nullptr;
+            });
+            std::sort(
+                dirty.begin(),
+                dirty.end(),
+                [](const ChunkCoord& a, const ChunkCoord& b) {
+                    return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+                }
+            );
+            stageStart = Clock::now();
+            meshes.resize(std::max(meshes.size(), dirty.size()));
+            connectivity.resize(dirty.size());
+            jobs.parallelFor(
+                static_cast<uint32_t>(dirty.size()),
+                4,
+                [&](uint32_t begin, uint32_t end) {
+                    ChunkNeighborhood neighborhood;
+                    for (uint32_t i = begin; i < end; i++)
+                    {
+                        neighborhood.gather(world, dirty[i]);
+                        meshChunk(neighborhood, meshes[i]);
+                        connectivity[i] = computeConnectivity(neighborhood);
+                    }
+                }
+            );
+            for (size_t i = 0; i < dirty.size(); i++)
+            {
+                visibility.update(dirty[i], connectivity[i]);
+            }
+            totals.chunksMeshed += dirty.size();
+            totals.meshSeconds += secondsSince(stageStart);
+
+            stageStart = Clock::now();
+            for (size_t i = 0; i < dirty.size(); i++)
+            {
+                totals.quadsMeshed += meshes[i].quadCount();
+                if (meshArena.upload(cmd, dirty[i], meshes[i]))
+                {
+                    totals.bytesUploaded +=
+                        meshes[i].vertices.size() * sizeof(ChunkVertex);
+                }
+            }
+            totals.uploadSeconds += secondsSince(stageStart);
+
+            stageStart = Clock::now();
+            visibility.findVisible(camera.position, visibleChunks);
+            totals.visibilitySeconds += secondsSince(stageStart);
+            totals.chunksVisible += visibleChunks.size();
+            totals.chunksConsidered += visibility.chunkCount();
+
+            gpuMemory.update(cmd);
+            ctx.endHeadlessFrame();
+            totals.peakGpuBytes =
+                std::max(totals.peakGpuBytes, gpuMemory.stats().usage);
+            totals.frameMs.push_back(secondsSince(frameStart) * 1000.0);
+            Profiler::get().collect();
+        }
+        vkDeviceWaitIdle(ctx.getDevice());
+
+        return finishReport(makeReport(script, frames, totals), options);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "voxel-bench: " << e.what() << '\n';
+        return 2;
+    }
+    return 0;
+}
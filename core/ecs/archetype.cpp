@@ -0,0 +1,96 @@
+#include "archetype.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+size_t alignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+} // namespace
+
+Archetype::Archetype(const ComponentMask& mask) : m_mask(mask)
+{
+    m_columnOf.fill(NO_COLUMN);
+
+    size_t rowBytes = sizeof(Entity);
+    size_t worstPadding = 0;
+    for (ComponentId id = 0; id < MAX_COMPONENT_TYPES; id++)
+    {
+        if (!mask.test(id))
+        {
+            continue;
+        }
+        const ComponentInfo& info = componentInfo(id);
+        m_columnOf[id] = static_cast<uint32_t>(m_components.size());
+        m_components.push_back(id);
+        m_sizes.push_back(info.size);
+        rowBytes += info.size;
+        worstPadding += info.alignment;
+    }
+
+    // Very large components still get one row per chunk
+    m_chunkCapacity = static_cast<uint32_t>(std::max<size_t>(
+        1,
+        (CHUNK_BYTES - std::min(CHUNK_BYTES, worstPadding)) / rowBytes
+    ));
+
+    size_t offset = sizeof(Entity) * m_chunkCapacity;
+    for (ComponentId id : m_components)
+    {
+        const ComponentInfo& info = componentInfo(id);
+        offset = alignUp(offset, info.alignment);
+        m_offsets.push_back(offset);
+        offset += info.size * m_chunkCapacity;
+    }
+    m_chunkBytes = offset;
+}
+
+Archetype::Slot Archetype::allocate(Entity entity)
+{
+    if (m_chunks.empty() || m_chunks.back().count == m_chunkCapacity)
+    {
+        m_chunks.push_back(Chunk{
+            .data = std::make_unique<std::byte[]>(m_chunkBytes),
+        });
+    }
+
+    const Slot slot{
+        .chunk = static_cast<uint32_t>(m_chunks.size() - 1),
+        .row = m_chunks.back().count++,
+    };
+    entities(slot.chunk)[slot.row] = entity;
+    m_entityCount++;
+    return slot;
+}
+
+Entity Archetype::remove(Slot slot)
+{
+    const Slot last{
+        .chunk = static_cast<uint32_t>(m_chunks.size() - 1),
+        .row = m_chunks.back().count - 1,
+    };
+
+    Entity moved;
+    if (slot.chunk != last.chunk || slot.row != last.row)
+    {
+        for (ComponentId id : m_components)
+        {
+            std::memcpy(
+                component(id, slot),
+                component(id, last),
+                m_sizes[m_columnOf[id]]
+            );
+        }
+        moved = entities(last.chunk)[last.row];
+        entities(slot.chunk)[slot.row] = moved;
+    }
+
+    if (--m_chunks.back().count == 0)
+    {
+        m_chunks.pop_back();
+    }
+    m_entityCount--;
+    return moved;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "core/ecs/component.h"
+
+// All entities with exactly one set of component types.
+//
+// Entities live in fixed-size chunks. Each chunk holds one array per
+// component plus the entity handles, so a system that touches two
+// components streams through two dense arrays. Rows stay packed: removing
+// an entity moves the archetype's last row into the hole.
+class Archetype
+{
+  public:
+    static constexpr size_t CHUNK_BYTES{ 16 * 1024 };
+    static constexpr uint32_t NO_COLUMN{ UINT32_MAX };
+
+    struct Slot
+    {
+        uint32_t chunk{ 0 };
+        uint32_t row{ 0 };
+    };
+
+  private:
+    struct Chunk
+    {
+        std::unique_ptr<std::byte[]> data;
+        uint32_t count{ 0 };
+    };
+
+    ComponentMask m_mask;
+    std::vector<ComponentId> m_components; // ascending
+    std::array<uint32_t, MAX_COMPONENT_TYPES> m_columnOf;
+    std::vector<size_t> m_offsets;
+    std::vector<size_t> m_sizes;
+    uint32_t m_chunkCapacity{ 0 };
+    size_t m_chunkBytes{ 0 };
+    std::vector<Chunk> m_chunks;
+    size_t m_entityCount{ 0 };
+
+    // Archetype graph, filled in lazily by EntityRegistry
+    std::array<Archetype*, MAX_COMPONENT_TYPES> m_addEdges{};
+    std::array<Archetype*, MAX_COMPONENT_TYPES> m_removeEdges{};
+
+    friend class EntityRegistry;
+
+  public:
+    explicit Archetype(const ComponentMask& mask);
+    Archetype(const Archetype&) = delete;
+    Archetype& operator=(const Archetype&) = delete;
+
+    // Appends a row with uninitialised components
+    Slot allocate(Entity entity);
+    // Fills the hole with the last row and returns the entity that moved
+    // there, or an invalid handle when the removed row was the last one
+    Entity remove(Slot slot);
+
+    const ComponentMask& mask() const
+    {
+        return m_mask;
+    }
+    const std::vector<ComponentId>& components() const
+    {
+        return m_components;
+    }
+    bool has(ComponentId id) const
+    {
+        return m_columnOf[id] != NO_COLUMN;
+    }
+    size_t entityCount() const
+    {
+        return m_entityCount;
+    }
+    uint32_t chunkCount() const
+    {
+        return static_cast<uint32_t>(m_chunks.size());
+    }
+    uint32_t chunkSize(uint32_t chunk) const
+    {
+        return m_chunks[chunk].count;
+    }
+
+    Entity* entities(uint32_t chunk)
+    {
+        return reinterpret_cast<Entity*>(m_chunks[chunk].data.get());
+    }
+    void* component(ComponentId id, Slot slot)
+    {
+        const uint32_t column = m_columnOf[id];
+        return m_chunks[slot.chunk].data.get() + m_offsets[column] +
+               m_sizes[column] * slot.row;
+    }
+    // Dense array of one component in a chunk; the archetype must have it
+    template <Component T> T* column(uint32_t chunk)
+    {
+        const uint32_t column = m_columnOf[componentId<T>()];
+        return reinterpret_cast<T*>(
+            m_chunks[chunk].data.get() + m_offsets[column]
+        );
+    }
+};
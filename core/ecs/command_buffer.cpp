@@ -0,0 +1,32 @@
+#include "command_buffer.h"
+#include <utility>
+
+void CommandBuffer::record(std::function<void(EntityRegistry&)> command)
+{
+    std::lock_guard lock(m_mutex);
+    m_commands.push_back(std::move(command));
+}
+
+void CommandBuffer::destroy(Entity entity)
+{
+    record([=](EntityRegistry& registry) { registry.destroy(entity); });
+}
+
+void CommandBuffer::flush(EntityRegistry& registry)
+{
+    std::vector<std::function<void(EntityRegistry&)>> commands;
+    {
+        std::lock_guard lock(m_mutex);
+        commands = std::exchange(m_commands, {});
+    }
+    for (auto& command : commands)
+    {
+        command(registry);
+    }
+}
+
+bool CommandBuffer::isEmpty()
+{
+    std::lock_guard lock(m_mutex);
+    return m_commands.empty();
+}
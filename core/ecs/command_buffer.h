@@ -0,0 +1,46 @@
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "core/ecs/component.h"
+#include "core/ecs/registry.h"
+
+// Structural changes recorded during iteration and applied afterwards, in
+// recording order. Recording is thread-safe so jobs of a parallel query can
+// share one buffer.
+class CommandBuffer
+{
+  private:
+    std::mutex m_mutex;
+    std::vector<std::function<void(EntityRegistry&)>> m_commands;
+
+    void record(std::function<void(EntityRegistry&)> command);
+
+  public:
+    template <Component... Ts>
+        requires DistinctComponents<Ts...>
+    void create(const Ts&... components)
+    {
+        record([=](EntityRegistry& registry) {
+            registry.create(components...);
+        });
+    }
+    void destroy(Entity entity);
+    template <Component T> void add(Entity entity, const T& value = {})
+    {
+        record([=](EntityRegistry& registry) {
+            registry.add(entity, value);
+        });
+    }
+    template <Component T> void remove(Entity entity)
+    {
+        record([=](EntityRegistry& registry) {
+            registry.template remove<T>(entity);
+        });
+    }
+
+    // Call while no query is iterating the registry
+    void flush(EntityRegistry& registry);
+    bool isEmpty();
+};
@@ -0,0 +1,29 @@
+#include "component.h"
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+std::mutex g_componentMutex;
+std::vector<ComponentInfo> g_components;
+} // namespace
+
+ComponentId registerComponentType(const ComponentInfo& info)
+{
+    std::lock_guard lock(g_componentMutex);
+    if (g_components.size() == MAX_COMPONENT_TYPES)
+    {
+        throw std::runtime_error("Too many ECS component types");
+    }
+    // Reserved up front so references handed out stay valid
+    g_components.reserve(MAX_COMPONENT_TYPES);
+    g_components.push_back(info);
+    return static_cast<ComponentId>(g_components.size() - 1);
+}
+
+const ComponentInfo& componentInfo(ComponentId id)
+{
+    std::lock_guard lock(g_componentMutex);
+    return g_components[id];
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+struct Entity
+{
+    uint32_t index{ UINT32_MAX };
+    // Bumped when the index is reused, so stale handles stop resolving
+    uint32_t generation{ 0 };
+
+    bool isValid() const
+    {
+        return index != UINT32_MAX;
+    }
+    bool operator==(const Entity&) const = default;
+};
+
+constexpr uint32_t MAX_COMPONENT_TYPES{ 64 };
+
+using ComponentId = uint32_t;
+using ComponentMask = std::bitset<MAX_COMPONENT_TYPES>;
+
+struct ComponentInfo
+{
+    size_t size{ 0 };
+    size_t alignment{ 0 };
+};
+
+// Components are plain data. Archetype moves relocate them with memcpy and
+// destroying an entity never runs a destructor.
+template <typename T>
+concept Component =
+    std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T> &&
+    std::is_default_constructible_v<T> && !std::is_const_v<T> &&
+    alignof(T) <= alignof(std::max_align_t);
+
+// A query term is a component, const-qualified when only read
+template <typename T>
+concept QueryTerm = Component<std::remove_const_t<T>>;
+
+template <typename... Ts> constexpr bool DISTINCT_TYPES{ true };
+template <typename T, typename... Rest>
+constexpr bool DISTINCT_TYPES<T, Rest...>{
+    (!std::is_same_v<T, Rest> && ...) && DISTINCT_TYPES<Rest...>
+};
+
+// An entity holds at most one component of each type
+template <typename... Ts>
+concept DistinctComponents =
+    DISTINCT_TYPES<std::remove_const_t<Ts>...>;
+
+ComponentId registerComponentType(const ComponentInfo& info);
+const ComponentInfo& componentInfo(ComponentId id);
+
+// Ids are handed out on first use and are only stable within one run
+template <Component T> ComponentId componentId()
+{
+    static const ComponentId id = registerComponentType(
+        ComponentInfo{ .size = sizeof(T), .alignment = alignof(T) }
+    );
+    return id;
+}
+
+template <Component... Ts> ComponentMask componentMask()
+{
+    ComponentMask mask;
+    (mask.set(componentId<Ts>()), ...);
+    return mask;
+}
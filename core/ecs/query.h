@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include "core/ecs/archetype.h"
+#include "core/ecs/component.h"
+#include "core/ecs/registry.h"
+#include "core/jobs/job_system.h"
+
+// Visits every entity that has all of Ts, handing the callback references
+// straight into the archetype chunks. Terms written as `const T` are read
+// only. The callback takes (Ts&...) or (Entity, Ts&...).
+//
+//     Query<Position, const Velocity> movers(registry);
+//     movers.forEach([](Position& p, const Velocity& v) { p += v; });
+//
+// Matching archetypes are cached and topped up with any created since the
+// last run, so keeping a Query around across ticks makes lookups free.
+template <QueryTerm... Ts>
+    requires(sizeof...(Ts) > 0) && DistinctComponents<Ts...>
+class Query
+{
+  private:
+    struct ChunkRef
+    {
+        Archetype* archetype{ nullptr };
+        uint32_t chunk{ 0 };
+    };
+
+    EntityRegistry& m_registry;
+    ComponentMask m_mask;
+    std::vector<Archetype*> m_matches;
+    size_t m_archetypesSeen{ 0 };
+    std::vector<ChunkRef> m_chunks;
+
+    void refresh()
+    {
+        const auto& archetypes = m_registry.archetypes();
+        for (; m_archetypesSeen < archetypes.size(); m_archetypesSeen++)
+        {
+            Archetype* archetype = archetypes[m_archetypesSeen].get();
+            if ((archetype->mask() & m_mask) == m_mask)
+            {
+                m_matches.push_back(archetype);
+            }
+        }
+    }
+
+    template <typename Fn>
+    static void visitChunk(Archetype& archetype, uint32_t chunk, Fn& fn)
+    {
+        const uint32_t count = archetype.chunkSize(chunk);
+        Entity* entities = archetype.entities(chunk);
+        std::tuple<Ts*...> columns{
+            archetype.template column<std::remove_const_t<Ts>>(chunk)...
+        };
+        std::apply(
+            [&](Ts*... arrays) {
+                for (uint32_t row = 0; row < count; row++)
+                {
+                    if constexpr (std::is_invocable_v<Fn&, Entity, Ts&...>)
+                    {
+                        fn(entities[row], arrays[row]...);
+                    }
+                    else
+                    {
+                        fn(arrays[row]...);
+                    }
+                }
+            },
+            columns
+        );
+    }
+
+  public:
+    explicit Query(EntityRegistry& registry)
+        : m_registry(registry),
+          m_mask(componentMask<std::remove_const_t<Ts>...>())
+    {
+    }
+
+    template <typename Fn> void forEach(Fn&& fn)
+    {
+        refresh();
+        for (Archetype* archetype : m_matches)
+        {
+            for (uint32_t chunk = 0; chunk < archetype->chunkCount(); chunk++)
+            {
+                visitChunk(*archetype, chunk, fn);
+            }
+        }
+    }
+
+    // Spreads chunks across the job system and blocks until all are done.
+    // The callback runs concurrently on different entities, so it may only
+    // write through its own component references; anything structural goes
+    // into a CommandBuffer.
+    template <typename Fn> void parallelForEach(JobSystem& jobs, Fn&& fn)
+    {
+        refresh();
+        m_chunks.clear();
+        for (Archetype* archetype : m_matches)
+        {
+            for (uint32_t chunk = 0; chunk < archetype->chunkCount(); chunk++)
+            {
+                m_chunks.push_back(ChunkRef{ archetype, chunk });
+            }
+        }
+        if (m_chunks.empty())
+        {
+            return;
+        }
+
+        // A chunk is already a few hundred entities, plenty for one job
+        jobs.parallelFor(
+            static_cast<uint32_t>(m_chunks.size()),
+            1,
+            [&](uint32_t begin, uint32_t end) {
+                for (uint32_t i = begin; i < end; i++)
+                {
+                    visitChunk(*m_chunks[i].archetype, m_chunks[i].chunk, fn);
+                }
+            }
+        );
+    }
+
+    size_t count()
+    {
+        refresh();
+        size_t total = 0;
+        for (const Archetype* archetype : m_matches)
+        {
+            total += archetype->entityCount();
+        }
+        return total;
+    }
+};
@@ -0,0 +1,147 @@
+#include "registry.h"
+
+EntityRegistry::EntityRegistry()
+{
+    m_emptyArchetype = findOrCreateArchetype(ComponentMask{});
+}
+
+Archetype* EntityRegistry::findOrCreateArchetype(const ComponentMask& mask)
+{
+    if (auto it = m_archetypeByMask.find(mask); it != m_archetypeByMask.end())
+    {
+        return it->second;
+    }
+    Archetype* archetype =
+        m_archetypes.emplace_back(std::make_unique<Archetype>(mask)).get();
+    m_archetypeByMask.emplace(mask, archetype);
+    return archetype;
+}
+
+Entity EntityRegistry::allocate(Archetype* archetype)
+{
+    uint32_t index;
+    if (!m_freeIndices.empty())
+    {
+        index = m_freeIndices.back();
+        m_freeIndices.pop_back();
+    }
+    else
+    {
+        index = static_cast<uint32_t>(m_records.size());
+        m_records.emplace_back();
+    }
+
+    const Entity entity{
+        .index = index,
+        .generation = m_records[index].generation,
+    };
+    m_records[index].archetype = archetype;
+    m_records[index].slot = archetype->allocate(entity);
+    return entity;
+}
+
+Entity EntityRegistry::create()
+{
+    return allocate(m_emptyArchetype);
+}
+
+void EntityRegistry::destroy(Entity entity)
+{
+    if (!isAlive(entity))
+    {
+        return;
+    }
+    EntityRecord& record = m_records[entity.index];
+    const Entity moved = record.archetype->remove(record.slot);
+    if (moved.isValid())
+    {
+        m_records[moved.index].slot = record.slot;
+    }
+    record.archetype = nullptr;
+    record.generation++;
+    m_freeIndices.push_back(entity.index);
+}
+
+bool EntityRegistry::isAlive(Entity entity) const
+{
+    return entity.index < m_records.size() &&
+           m_records[entity.index].archetype &&
+           m_records[entity.index].generation == entity.generation;
+}
+
+void EntityRegistry::moveEntity(EntityRecord& record, Archetype* target)
+{
+    Archetype* source = record.archetype;
+    const Entity entity = source->entities(record.slot.chunk)[record.slot.row];
+    const Archetype::Slot slot = target->allocate(entity);
+
+    // Components the entity keeps are copied; new ones start zeroed
+    for (ComponentId id : target->components())
+    {
+        void* destination = target->component(id, slot);
+        const size_t size = componentInfo(id).size;
+        if (source->has(id))
+        {
+            std::memcpy(destination, source->component(id, record.slot), size);
+        }
+        else
+        {
+            std::memset(destination, 0, size);
+        }
+    }
+
+    const Entity moved = source->remove(record.slot);
+    if (moved.isValid())
+    {
+        m_records[moved.index].slot = record.slot;
+    }
+    record.archetype = target;
+    record.slot = slot;
+}
+
+void* EntityRegistry::addComponent(Entity entity, ComponentId id)
+{
+    if (!isAlive(entity))
+    {
+        return nullptr;
+    }
+    EntityRecord& record = m_records[entity.index];
+    Archetype* source = record.archetype;
+    if (!source->has(id))
+    {
+        Archetype*& edge = source->m_addEdges[id];
+        if (!edge)
+        {
+            edge = findOrCreateArchetype(ComponentMask(source->mask()).set(id));
+            edge->m_removeEdges[id] = source;
+        }
+        moveEntity(record, edge);
+    }
+    return record.archetype->component(id, record.slot);
+}
+
+void EntityRegistry::removeComponent(Entity entity, ComponentId id)
+{
+    if (!isAlive(entity))
+    {
+        return;
+    }
+    EntityRecord& record = m_records[entity.index];
+    Archetype* source = record.archetype;
+    if (!source->has(id))
+    {
+        return;
+    }
+    Archetype*& edge = source->m_removeEdges[id];
+    if (!edge)
+    {
+        edge = findOrCreateArchetype(ComponentMask(source->mask()).reset(id));
+        edge->m_addEdges[id] = source;
+    }
+    moveEntity(record, edge);
+}
+
+size_t EntityRegistry::entityCount() const
+{
+    return m_records.size() - m_freeIndices.size();
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "core/ecs/archetype.h"
+#include "core/ecs/component.h"
+
+// Owns every entity and the archetypes that store them.
+//
+// Adding or removing a component moves the entity to another archetype, so
+// structural changes must not happen while a Query is iterating; record
+// them in a CommandBuffer instead. Operations on stale handles are ignored,
+// which lets deferred commands race with destruction harmlessly.
+class EntityRegistry
+{
+  private:
+    struct EntityRecord
+    {
+        Archetype* archetype{ nullptr };
+        Archetype::Slot slot;
+        uint32_t generation{ 0 };
+    };
+
+    std::vector<EntityRecord> m_records;
+    std::vector<uint32_t> m_freeIndices;
+    std::vector<std::unique_ptr<Archetype>> m_archetypes;
+    std::unordered_map<ComponentMask, Archetype*> m_archetypeByMask;
+    Archetype* m_emptyArchetype{ nullptr };
+
+    Archetype* findOrCreateArchetype(const ComponentMask& mask);
+    Entity allocate(Archetype* archetype);
+    void moveEntity(EntityRecord& record, Archetype* target);
+    // Storage for the component, moving the entity first if it lacks one
+    void* addComponent(Entity entity, ComponentId id);
+    void removeComponent(Entity entity, ComponentId id);
+
+  public:
+    EntityRegistry();
+    EntityRegistry(const EntityRegistry&) = delete;
+    EntityRegistry& operator=(const EntityRegistry&) = delete;
+
+    Entity create();
+    template <Component... Ts>
+        requires DistinctComponents<Ts...>
+    Entity create(const Ts&... components)
+    {
+        Archetype* archetype = findOrCreateArchetype(componentMask<Ts...>());
+        const Entity entity = allocate(archetype);
+        const Archetype::Slot slot = m_records[entity.index].slot;
+        (std::memcpy(
+             archetype->component(componentId<Ts>(), slot),
+             &components,
+             sizeof(Ts)
+         ),
+         ...);
+        return entity;
+    }
+    void destroy(Entity entity);
+    bool isAlive(Entity entity) const;
+
+    // Overwrites the component if the entity already has one
+    template <Component T> void add(Entity entity, const T& value = {})
+    {
+        if (void* storage = addComponent(entity, componentId<T>()))
+        {
+            std::memcpy(storage, &value, sizeof(T));
+        }
+    }
+    template <Component T> void remove(Entity entity)
+    {
+        removeComponent(entity, componentId<T>());
+    }
+    template <Component T> bool has(Entity entity) const
+    {
+        return isAlive(entity) &&
+               m_records[entity.index].archetype->has(componentId<T>());
+    }
+    // Null when the entity is dead or lacks the component. Invalidated by
+    // the next structural change.
+    template <Component T> T* get(Entity entity)
+    {
+        if (!has<T>(entity))
+        {
+            return nullptr;
+        }
+        const EntityRecord& record = m_records[entity.index];
+        return static_cast<T*>(
+            record.archetype->component(componentId<T>(), record.slot)
+        );
+    }
+
+    // Archetypes are never freed, so queries can cache pointers and only
+    // look at the ones appended since
+    const std::vector<std::unique_ptr<Archetype>>& archetypes() const
+    {
+        return m_archetypes;
+    }
+    size_t entityCount() const;
+};
@@ -0,0 +1,151 @@
+#include "epoch.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+// Hands the thread's slot back when the thread exits
+struct SlotOwner
+{
+    std::atomic<bool>* used{ nullptr };
+
+    ~SlotOwner()
+    {
+        if (used)
+        {
+            used->store(false, std::memory_order_release);
+        }
+    }
+};
+} // namespace
+
+EpochReclaimer& EpochReclaimer::get()
+{
+    static EpochReclaimer reclaimer;
+    return reclaimer;
+}
+
+EpochReclaimer::~EpochReclaimer()
+{
+    // Static destruction: no reader is left
+    for (const Retired& retired : m_retired)
+    {
+        retired.release(retired.object);
+    }
+}
+
+EpochReclaimer::Slot& EpochReclaimer::threadSlot()
+{
+    thread_local Slot* slot = nullptr;
+    thread_local SlotOwner owner;
+    if (slot)
+    {
+        return *slot;
+    }
+
+    for (Slot& candidate : m_slots)
+    {
+        bool expected = false;
+        if (candidate.used.compare_exchange_strong(
+                expected,
+                true,
+                std::memory_order_acq_rel
+            ))
+        {
+            candidate.depth = 0;
+            slot = &candidate;
+            owner.used = &candidate.used;
+            return candidate;
+        }
+    }
+    throw std::runtime_error("More threads than epoch slots");
+}
+
+void EpochReclaimer::enter()
+{
+    Slot& slot = threadSlot();
+    if (slot.depth++ > 0)
+    {
+        return;
+    }
+    // Acquire: a reader that sees a retire's epoch bump also sees the
+    // unlink that preceded it
+    slot.epoch.store(
+        m_epoch.load(std::memory_order_acquire),
+        std::memory_order_relaxed
+    );
+    // The announcement must be visible before the reader loads any pointer
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void EpochReclaimer::leave()
+{
+    Slot& slot = threadSlot();
+    if (--slot.depth > 0)
+    {
+        return;
+    }
+    slot.epoch.store(0, std::memory_order_release);
+}
+
+void EpochReclaimer::retire(void* object, void (*release)(void*))
+{
+    // The object was unlinked before this point, so a reader announcing a
+    // later epoch cannot reach it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const uint64_t epoch = m_epoch.fetch_add(1, std::memory_order_acq_rel);
+
+    std::lock_guard lock(m_retiredMutex);
+    m_retired.push_back(
+        Retired{ .epoch = epoch, .release = release, .object = object }
+    );
+}
+
+uint64_t EpochReclaimer::oldestActiveEpoch() const
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t oldest = std::numeric_limits<uint64_t>::max();
+    for (const Slot& slot : m_slots)
+    {
+        const uint64_t epoch = slot.epoch.load(std::memory_order_acquire);
+        if (epoch != 0)
+        {
+            oldest = std::min(oldest, epoch);
+        }
+    }
+    return oldest;
+}
+
+size_t EpochReclaimer::reclaim()
+{
+    std::vector<Retired> safe;
+    {
+        std::lock_guard lock(m_retiredMutex);
+        if (m_retired.empty())
+        {
+            return 0;
+        }
+        const uint64_t oldest = oldestActiveEpoch();
+        auto firstUnsafe = std::partition(
+            m_retired.begin(),
+            m_retired.end(),
+            [&](const Retired& retired) { return retired.epoch < oldest; }
+        );
+        safe.assign(m_retired.begin(), firstUnsafe);
+        m_retired.erase(m_retired.begin(), firstUnsafe);
+    }
+
+    // Released outside the lock; a release may retire further objects
+    for (const Retired& retired : safe)
+    {
+        retired.release(retired.object);
+    }
+    return safe.size();
+}
+
+size_t EpochReclaimer::pendingCount()
+{
+    std::lock_guard lock(m_retiredMutex);
+    return m_retired.size();
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Epoch-based reclamation for data that readers access without locks.
+//
+// A reader brackets its accesses with an EpochGuard, which publishes the
+// global epoch it started in. A writer that unlinks an object retires it
+// instead of freeing it: the object is tagged with the current epoch and
+// the global epoch advances. reclaim() frees every retired object whose
+// tag is older than the oldest epoch still announced by a reader, so no
+// reader that could have seen the object is still running. Readers pay
+// one store and one fence per guard; nothing they do waits on a writer.
+class EpochReclaimer
+{
+  public:
+    static constexpr uint32_t MAX_THREADS{ 128 };
+
+  private:
+    struct alignas(64) Slot
+    {
+        // Epoch the owning thread's outermost guard started in; 0 when the
+        // thread holds no guard
+        std::atomic<uint64_t> epoch{ 0 };
+        std::atomic<bool> used{ false };
+        // Only touched by the owning thread
+        uint32_t depth{ 0 };
+    };
+
+    struct Retired
+    {
+        uint64_t epoch{ 0 };
+        void (*release)(void*){ nullptr };
+        void* object{ nullptr };
+    };
+
+    std::atomic<uint64_t> m_epoch{ 1 };
+    std::array<Slot, MAX_THREADS> m_slots;
+    std::mutex m_retiredMutex;
+    std::vector<Retired> m_retired;
+
+    EpochReclaimer() = default;
+    ~EpochReclaimer();
+
+    Slot& threadSlot();
+    uint64_t oldestActiveEpoch() const;
+
+  public:
+    static EpochReclaimer& get();
+
+    void enter();
+    void leave();
+
+    // `release` runs once no reader can hold `object` any more, from a
+    // later reclaim() call
+    void retire(void* object, void (*release)(void*));
+    template <typename T> void retire(T* object)
+    {
+        retire(object, [](void* retired) { delete static_cast<T*>(retired); });
+    }
+
+    // Releases what is safe to release; returns how many objects that was
+    size_t reclaim();
+    size_t pendingCount();
+};
+
+class EpochGuard
+{
+  public:
+    EpochGuard()
+    {
+        EpochReclaimer::get().enter();
+    }
+    ~EpochGuard()
+    {
+        EpochReclaimer::get().leave();
+    }
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+};
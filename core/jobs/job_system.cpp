@@ -0,0 +1,135 @@
+#include "job_system.h"
+#include <algorithm>
+#include "core/profiling/profiler.h"
+
+JobSystem::JobSystem(uint32_t workerCount)
+{
+    if (workerCount == 0)
+    {
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    m_workers.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; i++)
+    {
+        m_workers.emplace_back(&JobSystem::workerLoop, this);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+void JobSystem::execute(Job& job)
+{
+    job.fn();
+    if (job.counter)
+    {
+        job.counter->m_pending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+void JobSystem::workerLoop()
+{
+    PROFILE_THREAD_NAME("job worker");
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [this] {
+                return m_stopping || !m_queue.empty();
+            });
+            if (m_queue.empty())
+            {
+                return;
+            }
+            job = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        execute(job);
+    }
+}
+
+bool JobSystem::runOne()
+{
+    Job job;
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_queue.empty())
+        {
+            return false;
+        }
+        job = std::move(m_queue.front());
+        m_queue.pop_front();
+    }
+    execute(job);
+    return true;
+}
+
+void JobSystem::submit(std::function<void()> fn, JobCounter* counter)
+{
+    if (counter)
+    {
+        counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard lock(m_mutex);
+        m_queue.push_back(Job{ .fn = std::move(fn), .counter = counter });
+    }
+    m_wake.notify_one();
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+    while (!counter.isDone())
+    {
+        if (!runOne())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::parallelFor(
+    uint32_t count, uint32_t grain,
+    const std::function<void(uint32_t begin, uint32_t end)>& fn
+)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    grain = std::max(grain, 1u);
+
+    // Small batches are not worth the queue round trip
+    if (count <= grain)
+    {
+        fn(0, count);
+        return;
+    }
+
+    JobCounter counter;
+    for (uint32_t begin = 0; begin < count; begin += grain)
+    {
+        uint32_t end = std::min(begin + grain, count);
+        submit([&fn, begin, end] { fn(begin, end); }, &counter);
+    }
+    wait(counter);
+}
+
+uint32_t JobSystem::workerCount() const
+{
+    return static_cast<uint32_t>(m_workers.size());
+}
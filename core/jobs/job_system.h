@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Tracks a group of submitted jobs; reaches zero once all of them finished.
+class JobCounter
+{
+  private:
+    std::atomic<uint32_t> m_pending{ 0 };
+
+    friend class JobSystem;
+
+  public:
+    bool isDone() const
+    {
+        return m_pending.load(std::memory_order_acquire) == 0;
+    }
+};
+
+class JobSystem
+{
+  private:
+    struct Job
+    {
+        std::function<void()> fn;
+        JobCounter* counter{ nullptr };
+    };
+
+    std::vector<std::thread> m_workers;
+    std::deque<Job> m_queue;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stopping{ false };
+
+    void workerLoop();
+    bool runOne();
+    void execute(Job& job);
+
+  public:
+    // 0 picks hardware_concurrency - 1 so the calling thread keeps a core
+    explicit JobSystem(uint32_t workerCount = 0);
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+    JobSystem(JobSystem&&) = delete;
+    JobSystem& operator=(JobSystem&&) = delete;
+
+    void submit(std::function<void()> fn, JobCounter* counter = nullptr);
+
+    // Blocks until the counter drains, running queued jobs in the meantime
+    void wait(JobCounter& counter);
+
+    // Splits [0, count) into ranges of at most `grain` items and blocks
+    // until every range has been processed
+    void parallelFor(
+        uint32_t count, uint32_t grain,
+        const std::function<void(uint32_t begin, uint32_t end)>& fn
+    );
+
+    uint32_t workerCount() const;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Bounded lock-free queue for exactly one producer and one consumer thread.
+// CAPACITY must be a power of two.
+template <typename T, uint32_t CAPACITY> class SpscQueue
+{
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "capacity must be 2^n");
+
+  private:
+    static constexpr uint32_t MASK{ CAPACITY - 1 };
+
+    std::array<T, CAPACITY> m_items{};
+    alignas(64) std::atomic<uint32_t> m_head{ 0 };
+    alignas(64) std::atomic<uint32_t> m_tail{ 0 };
+
+  public:
+    // Producer side; false when the queue is full
+    bool push(const T& item)
+    {
+        uint32_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) >= CAPACITY)
+        {
+            return false;
+        }
+        m_items[head & MASK] = item;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; false when the queue is empty
+    bool pop(T& item)
+    {
+        uint32_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        item = m_items[tail & MASK];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+};
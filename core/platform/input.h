@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include "core/jobs/spsc_queue.h"
+
+enum class InputAction : uint8_t
+{
+    MoveForward,
+    MoveBack,
+    MoveLeft,
+    MoveRight,
+    MoveUp,
+    MoveDown,
+    Count,
+};
+
+enum class InputEventType : uint8_t
+{
+    ActionPressed,
+    ActionReleased,
+    // Relative mouse motion in x/y
+    Look,
+};
+
+// Timestamps are steady_clock nanoseconds taken from the OS event, not from
+// when the event was polled, so the simulation can place every event in
+// the tick it actually happened in.
+struct InputEvent
+{
+    uint64_t timestampNs{ 0 };
+    InputEventType type{ InputEventType::ActionPressed };
+    InputAction action{ InputAction::Count };
+    float x{ 0.0f };
+    float y{ 0.0f };
+};
+
+// Produced by the window on the render thread, consumed by the simulation
+using InputQueue = SpscQueue<InputEvent, 4096>;
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <cstdint>
+
+// Peak resident set size of this process so far, or 0 where unsupported
+uint64_t peakResidentBytes();
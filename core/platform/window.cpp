@@ -1,15 +1,54 @@
 #include "window.h"
 #include <SDL3/SDL.h>
+#include <chrono>
+#include "core/profiling/startup_timeline.h"
+
+namespace
+{
+bool toAction(SDL_Scancode scancode, InputAction& action)
+{
+    switch (scancode)
+    {
+    case SDL_SCANCODE_W:
+        action = InputAction::MoveForward;
+        return true;
+    case SDL_SCANCODE_S:
+        action = InputAction::MoveBack;
+        return true;
+    case SDL_SCANCODE_A:
+        action = InputAction::MoveLeft;
+        return true;
+    case SDL_SCANCODE_D:
+        action = InputAction::MoveRight;
+        return true;
+    case SDL_SCANCODE_SPACE:
+        action = InputAction::MoveUp;
+        return true;
+    case SDL_SCANCODE_LSHIFT:
+        action = InputAction::MoveDown;
+        return true;
+    default:
+        return false;
+    }
+}
+} // namespace
+
+void Window::initPlatform()
+{
+    STARTUP_STAGE("SDL_Init");
+    SDL_Init(SDL_INIT_VIDEO);
+}
 
 Window::Window(const WindowConfig& config)
 {
+    STARTUP_STAGE("createWindow");
     SDL_Init(SDL_INIT_VIDEO);
     m_shouldClose = false;
     m_window = SDL_CreateWindow(
         config.title,
         config.width,
         config.height,
-        SDL_WINDOW_RESIZABLE
+        SDL_WINDOW_RESIZABLE | SDL_WINDOW_VULKAN
     );
 }
 
@@ -23,17 +62,51 @@ SDL_Window* Window::getSDLWindow() const
     return m_window;
 }
 
-void Window::pollEvents()
+void Window::pollEvents(InputQueue& input)
 {
-    SDL_Event event;
+    // SDL stamps events with SDL_GetTicksNS(); shift them onto steady_clock,
+    // which the simulation and profiler run on
+    const uint64_t steadyNs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        )
+            .count()
+    );
+    const uint64_t clockOffset = steadyNs - SDL_GetTicksNS();
 
+    SDL_Event event;
     while (SDL_PollEvent(&event))
     {
-        if (event.type == SDL_EVENT_QUIT)
+        InputEvent inputEvent{
+            .timestampNs = event.common.timestamp + clockOffset,
+        };
+        switch (event.type)
         {
+        case SDL_EVENT_QUIT:
             m_shouldClose = true;
+            continue;
+        case SDL_EVENT_KEY_DOWN:
+        case SDL_EVENT_KEY_UP:
+            if (event.key.repeat ||
+                !toAction(event.key.scancode, inputEvent.action))
+            {
+                continue;
+            }
+            inputEvent.type = event.type == SDL_EVENT_KEY_DOWN
+                                  ? InputEventType::ActionPressed
+                                  : InputEventType::ActionReleased;
             break;
+        case SDL_EVENT_MOUSE_MOTION:
+            inputEvent.type = InputEventType::Look;
+            inputEvent.x = event.motion.xrel;
+            inputEvent.y = event.motion.yrel;
+            break;
+        default:
+            continue;
         }
+        // The queue holds seconds of input; it only fills up if the
+        // simulation thread has stalled, and then dropping is the lesser evil
+        input.push(inputEvent);
     }
 }
 
@@ -51,3 +124,17 @@ int Window::height() const
 {
     return m_height;
 }
+
+glm::ivec2 Window::displaySizeInPixels() const
+{
+    const SDL_DisplayMode* mode =
+        SDL_GetDesktopDisplayMode(SDL_GetDisplayForWindow(m_window));
+    if (!mode)
+    {
+        int width, height;
+        SDL_GetWindowSizeInPixels(m_window, &width, &height);
+        return { width, height };
+    }
+    return { static_cast<int>(mode->w * mode->pixel_density),
+             static_cast<int>(mode->h * mode->pixel_density) };
+}
@@ -2,6 +2,7 @@
 
 #include <SDL3/SDL.h>
 #include <glm/glm.hpp>
+#include "core/platform/input.h"
 
 struct WindowConfig
 {
@@ -19,13 +20,20 @@ class Window
     bool m_shouldClose;
 
   public:
+    // Brings up SDL video without a window; safe to call more than once
+    static void initPlatform();
+
     Window(const WindowConfig& config);
     ~Window();
 
     SDL_Window* getSDLWindow() const;
-    void pollEvents();
+    // Drains every pending event, forwarding input with its OS timestamp
+    void pollEvents(InputQueue& input);
     bool shouldClose();
 
     int width() const;
     int height() const;
+    // Desktop size in pixels of the display the window is on; the largest
+    // the swapchain gets unless the window moves to a bigger display
+    glm::ivec2 displaySizeInPixels() const;
 };
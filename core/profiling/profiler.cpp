@@ -0,0 +1,180 @@
+#include "profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+thread_local ProfileRing* t_ring{ nullptr };
+
+void writeEscaped(std::ostream& out, const char* text)
+{
+    for (const char* c = text; *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            out << '\\';
+        }
+        out << *c;
+    }
+}
+} // namespace
+
+ProfileRing::ProfileRing(uint32_t threadId) : m_threadId(threadId)
+{
+}
+
+Profiler& Profiler::get()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+uint64_t Profiler::nowNs()
+{
+    // steady_clock is CLOCK_MONOTONIC on Linux and QPC on Windows, which
+    // are the host domains VK_EXT_calibrated_timestamps correlates against
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        )
+            .count()
+    );
+}
+
+ProfileRing& Profiler::registerThread()
+{
+    std::lock_guard lock(m_mutex);
+    uint32_t threadId = static_cast<uint32_t>(m_rings.size());
+    m_rings.push_back(std::make_unique<ProfileRing>(threadId));
+    m_rings.back()->m_threadName = "thread " + std::to_string(threadId);
+    return *m_rings.back();
+}
+
+ProfileRing& Profiler::threadRing()
+{
+    if (!t_ring)
+    {
+        t_ring = &registerThread();
+    }
+    return *t_ring;
+}
+
+void Profiler::setThreadName(const char* name)
+{
+    ProfileRing& ring = threadRing();
+    std::lock_guard lock(m_mutex);
+    ring.m_threadName = name;
+}
+
+void Profiler::collect()
+{
+    std::lock_guard lock(m_mutex);
+    for (auto& ring : m_rings)
+    {
+        uint32_t tail = ring->m_tail.load(std::memory_order_relaxed);
+        uint32_t head = ring->m_head.load(std::memory_order_acquire);
+        for (uint32_t i = tail; i != head; i++)
+        {
+            if (m_collected.size() < MAX_COLLECTED_EVENTS)
+            {
+                m_collected.push_back(CollectedEvent{
+                    .event = ring->m_events[i & ProfileRing::MASK],
+                    .track = ring->m_threadId,
+                });
+            }
+            else
+            {
+                m_droppedEvents++;
+            }
+        }
+        ring->m_tail.store(head, std::memory_order_release);
+        m_droppedEvents +=
+            ring->m_dropped.exchange(0, std::memory_order_relaxed);
+    }
+}
+
+void Profiler::addGpuEvents(const std::vector<ProfileEvent>& events)
+{
+    std::lock_guard lock(m_mutex);
+    for (const auto& event : events)
+    {
+        if (m_collected.size() >= MAX_COLLECTED_EVENTS)
+        {
+            m_droppedEvents++;
+            continue;
+        }
+        m_collected.push_back(
+            CollectedEvent{ .event = event, .track = GPU_TRACK }
+        );
+    }
+}
+
+bool Profiler::writeChromeTrace(const std::string& path)
+{
+    collect();
+
+    std::lock_guard lock(m_mutex);
+    std::ofstream out(path);
+    if (!out)
+    {
+        std::cerr << "failed to open trace file " << path << '\n';
+        return false;
+    }
+
+    uint64_t originNs = UINT64_MAX;
+    for (const auto& collected : m_collected)
+    {
+        originNs = std::min(originNs, collected.event.startNs);
+    }
+    if (m_collected.empty())
+    {
+        originNs = 0;
+    }
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    auto separator = [&]() {
+        if (!first)
+        {
+            out << ",\n";
+        }
+        first = false;
+    };
+
+    for (const auto& ring : m_rings)
+    {
+        separator();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+            << ring->m_threadId << ",\"args\":{\"name\":\"";
+        writeEscaped(out, ring->m_threadName.c_str());
+        out << "\"}}";
+    }
+    separator();
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+        << GPU_TRACK << ",\"args\":{\"name\":\"GPU\"}}";
+
+    // Complete events with microsecond timestamps, as the format expects
+    out.setf(std::ios::fixed);
+    out.precision(3);
+    for (const auto& collected : m_collected)
+    {
+        const ProfileEvent& event = collected.event;
+        separator();
+        out << "{\"name\":\"";
+        writeEscaped(out, event.name);
+        out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << collected.track
+            << ",\"ts\":" << (event.startNs - originNs) / 1000.0
+            << ",\"dur\":" << (event.endNs - event.startNs) / 1000.0 << '}';
+    }
+    out << "\n]}\n";
+
+    if (m_droppedEvents > 0)
+    {
+        std::cerr << "profiler dropped " << m_droppedEvents << " events\n";
+    }
+    std::cout << "Wrote " << m_collected.size() << " profile events to "
+              << path << '\n';
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Zone names must be string literals (or otherwise outlive the profiler);
+// only the pointer is recorded.
+struct ProfileEvent
+{
+    const char* name{ nullptr };
+    uint64_t startNs{ 0 };
+    uint64_t endNs{ 0 };
+};
+
+// Single-producer/single-consumer ring owned by one thread. The owning
+// thread pushes without locks; Profiler::collect drains it from another.
+class ProfileRing
+{
+  private:
+    static constexpr uint32_t CAPACITY{ 1 << 14 };
+    static constexpr uint32_t MASK{ CAPACITY - 1 };
+
+    std::array<ProfileEvent, CAPACITY> m_events{};
+    alignas(64) std::atomic<uint32_t> m_head{ 0 };
+    alignas(64) std::atomic<uint32_t> m_tail{ 0 };
+    std::atomic<uint32_t> m_dropped{ 0 };
+    uint32_t m_threadId;
+    std::string m_threadName;
+
+    friend class Profiler;
+
+  public:
+    explicit ProfileRing(uint32_t threadId);
+
+    // Drops the event when the collector has fallen a full ring behind
+    void push(const ProfileEvent& event)
+    {
+        uint32_t head = m_head.load(std::memory_order_relaxed);
+        uint32_t tail = m_tail.load(std::memory_order_acquire);
+        if (head - tail >= CAPACITY)
+        {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        m_events[head & MASK] = event;
+        m_head.store(head + 1, std::memory_order_release);
+    }
+};
+
+class Profiler
+{
+  public:
+    // Track id used for GPU zones in the exported trace
+    static constexpr uint32_t GPU_TRACK{ 0xFFFF };
+
+  private:
+    struct CollectedEvent
+    {
+        ProfileEvent event;
+        uint32_t track{ 0 };
+    };
+
+    static constexpr size_t MAX_COLLECTED_EVENTS{ 4'000'000 };
+
+    // Only taken when a thread registers and when collecting
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<ProfileRing>> m_rings;
+    std::vector<CollectedEvent> m_collected;
+    uint64_t m_droppedEvents{ 0 };
+
+    Profiler() = default;
+    ProfileRing& registerThread();
+
+  public:
+    static Profiler& get();
+
+    // Same clock as the host time domain used for GPU calibration
+    static uint64_t nowNs();
+
+    ProfileRing& threadRing();
+    void setThreadName(const char* name);
+
+    // Moves finished zones out of every thread ring; call once per frame
+    void collect();
+    void addGpuEvents(const std::vector<ProfileEvent>& events);
+
+    // Chrome trace event format, loadable in chrome://tracing and Perfetto
+    bool writeChromeTrace(const std::string& path);
+};
+
+class ProfileZone
+{
+  private:
+    const char* m_name;
+    uint64_t m_startNs;
+
+  public:
+    explicit ProfileZone(const char* name)
+        : m_name(name), m_startNs(Profiler::nowNs())
+    {
+    }
+    ~ProfileZone()
+    {
+        Profiler::get().threadRing().push(ProfileEvent{
+            .name = m_name,
+            .startNs = m_startNs,
+            .endNs = Profiler::nowNs(),
+        });
+    }
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// PROFILING_ENABLED is set by CMake for Debug and RelWithDebInfo builds
+#ifdef PROFILING_ENABLED
+#define PROFILE_ZONE(name)                                                     \
+    ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_THREAD_NAME(name) Profiler::get().setThreadName(name)
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_THREAD_NAME(name)
+#endif
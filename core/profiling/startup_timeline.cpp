@@ -0,0 +1,73 @@
+#include "startup_timeline.h"
+#include <algorithm>
+#include <cstdio>
+
+StartupTimeline::StartupTimeline()
+    : m_originNs(Profiler::nowNs()), m_mainThread(std::this_thread::get_id())
+{
+}
+
+StartupTimeline& StartupTimeline::get()
+{
+    static StartupTimeline timeline;
+    return timeline;
+}
+
+void StartupTimeline::record(const char* name, uint64_t startNs, uint64_t endNs)
+{
+    std::lock_guard lock(m_mutex);
+    if (m_finishNs)
+    {
+        return;
+    }
+    m_stages.push_back(Stage{
+        .name = name,
+        .startNs = startNs,
+        .endNs = endNs,
+        .mainThread = std::this_thread::get_id() == m_mainThread,
+    });
+}
+
+void StartupTimeline::finish()
+{
+    std::lock_guard lock(m_mutex);
+    if (!m_finishNs)
+    {
+        m_finishNs = Profiler::nowNs();
+    }
+}
+
+void StartupTimeline::report(std::ostream& out)
+{
+    std::lock_guard lock(m_mutex);
+    std::sort(
+        m_stages.begin(),
+        m_stages.end(),
+        [](const Stage& a, const Stage& b) { return a.startNs < b.startNs; }
+    );
+
+    auto ms = [](uint64_t ns) { return static_cast<double>(ns) / 1e6; };
+    char line[160];
+    out << "Startup timeline (start, duration, thread):\n";
+    for (const Stage& stage : m_stages)
+    {
+        std::snprintf(
+            line,
+            sizeof(line),
+            "  %8.1f ms %8.1f ms  %-6s %s\n",
+            ms(stage.startNs - m_originNs),
+            ms(stage.endNs - stage.startNs),
+            stage.mainThread ? "main" : "worker",
+            stage.name
+        );
+        out << line;
+    }
+    const uint64_t endNs = m_finishNs ? m_finishNs : Profiler::nowNs();
+    std::snprintf(
+        line,
+        sizeof(line),
+        "  %8.1f ms total\n",
+        ms(endNs - m_originNs)
+    );
+    out << line;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+#include "core/profiling/profiler.h"
+
+// Wall-clock record of the launch sequence, from the first call to get()
+// until finish(). Unlike profiler zones it is compiled into every build,
+// since release startup is the one that matters.
+class StartupTimeline
+{
+  private:
+    struct Stage
+    {
+        const char* name{ nullptr };
+        uint64_t startNs{ 0 };
+        uint64_t endNs{ 0 };
+        bool mainThread{ false };
+    };
+
+    std::mutex m_mutex;
+    std::vector<Stage> m_stages;
+    uint64_t m_originNs;
+    uint64_t m_finishNs{ 0 };
+    std::thread::id m_mainThread;
+
+    StartupTimeline();
+
+  public:
+    static StartupTimeline& get();
+
+    void record(const char* name, uint64_t startNs, uint64_t endNs);
+    // Marks startup as complete; later stages are ignored
+    void finish();
+    // One line per stage in start order, offsets relative to launch
+    void report(std::ostream& out);
+};
+
+class StartupStage
+{
+  private:
+    const char* m_name;
+    uint64_t m_startNs;
+
+  public:
+    explicit StartupStage(const char* name)
+        : m_name(name), m_startNs(Profiler::nowNs())
+    {
+    }
+    ~StartupStage()
+    {
+        StartupTimeline::get().record(m_name, m_startNs, Profiler::nowNs());
+    }
+    StartupStage(const StartupStage&) = delete;
+    StartupStage& operator=(const StartupStage&) = delete;
+};
+
+// Also opens a profiler zone so stages show up in the Chrome trace
+#define STARTUP_STAGE(name)                                                    \
+    StartupStage PROFILE_CONCAT(startupStage, __LINE__)(name);                 \
+    PROFILE_ZONE(name)
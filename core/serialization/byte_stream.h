@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Little-endian encoding shared by the chunk codec and the network layer.
+// Values are written byte by byte, so the format does not depend on the
+// host's endianness or alignment.
+class ByteWriter
+{
+  private:
+    std::vector<uint8_t>& m_out;
+
+  public:
+    explicit ByteWriter(std::vector<uint8_t>& out) : m_out(out)
+    {
+    }
+
+    void u8(uint8_t value)
+    {
+        m_out.push_back(value);
+    }
+    void u16(uint16_t value)
+    {
+        u8(static_cast<uint8_t>(value));
+        u8(static_cast<uint8_t>(value >> 8));
+    }
+    void u32(uint32_t value)
+    {
+        u16(static_cast<uint16_t>(value));
+        u16(static_cast<uint16_t>(value >> 16));
+    }
+    void u64(uint64_t value)
+    {
+        u32(static_cast<uint32_t>(value));
+        u32(static_cast<uint32_t>(value >> 32));
+    }
+    void i32(int32_t value)
+    {
+        u32(static_cast<uint32_t>(value));
+    }
+    // LEB128: seven bits per byte, high bit set on all but the last
+    void varint(uint32_t value)
+    {
+        while (value >= 0x80)
+        {
+            u8(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        u8(static_cast<uint8_t>(value));
+    }
+    void bytes(const uint8_t* data, size_t size)
+    {
+        m_out.insert(m_out.end(), data, data + size);
+    }
+
+    size_t size() const
+    {
+        return m_out.size();
+    }
+    // For values only known after later fields are written
+    void patchU16(size_t offset, uint16_t value)
+    {
+        m_out[offset] = static_cast<uint8_t>(value);
+        m_out[offset + 1] = static_cast<uint8_t>(value >> 8);
+    }
+};
+
+// Reads never go past the end: once data runs out every read returns zero
+// and ok() turns false, so decoders check once at the end instead of after
+// every field.
+class ByteReader
+{
+  private:
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_pos{ 0 };
+    bool m_ok{ true };
+
+    bool take(size_t count)
+    {
+        if (!m_ok || m_size - m_pos < count)
+        {
+            m_ok = false;
+            return false;
+        }
+        return true;
+    }
+
+  public:
+    ByteReader(const uint8_t* data, size_t size) : m_data(data), m_size(size)
+    {
+    }
+
+    uint8_t u8()
+    {
+        return take(1) ? m_data[m_pos++] : 0;
+    }
+    uint16_t u16()
+    {
+        const uint16_t low = u8();
+        return static_cast<uint16_t>(low | (u8() << 8));
+    }
+    uint32_t u32()
+    {
+        const uint32_t low = u16();
+        return low | (static_cast<uint32_t>(u16()) << 16);
+    }
+    uint64_t u64()
+    {
+        const uint64_t low = u32();
+        return low | (static_cast<uint64_t>(u32()) << 32);
+    }
+    int32_t i32()
+    {
+        return static_cast<int32_t>(u32());
+    }
+    uint32_t varint()
+    {
+        uint32_t value = 0;
+        for (uint32_t shift = 0; shift < 35; shift += 7)
+        {
+            const uint8_t byte = u8();
+            value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+            {
+                return value;
+            }
+        }
+        m_ok = false;
+        return 0;
+    }
+    // Pointer to the next `size` bytes, or null when there are not enough
+    const uint8_t* bytes(size_t size)
+    {
+        if (!take(size))
+        {
+            return nullptr;
+        }
+        const uint8_t* data = m_data + m_pos;
+        m_pos += size;
+        return data;
+    }
+
+    bool ok() const
+    {
+        return m_ok;
+    }
+    size_t remaining() const
+    {
+        return m_ok ? m_size - m_pos : 0;
+    }
+};
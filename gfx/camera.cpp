@@ -0,0 +1,32 @@
+#include "camera.h"
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+
+Camera Camera::perspective(
+    const glm::vec3& position, float yaw, float pitch, float aspect,
+    float verticalFov, float nearPlane, float farPlane
+)
+{
+    // Same heading as SimulationThread::moveViewer()
+    const glm::vec3 forward{ std::sin(yaw) * std::cos(pitch),
+                             std::sin(pitch),
+                             -std::cos(yaw) * std::cos(pitch) };
+
+    Camera camera{
+        .view = glm::lookAt(
+            position,
+            position + forward,
+            glm::vec3(0.0f, 1.0f, 0.0f)
+        ),
+        .projection =
+            glm::perspectiveRH_ZO(verticalFov, aspect, nearPlane, farPlane),
+        .position = position,
+        .nearPlane = nearPlane,
+        .farPlane = farPlane,
+    };
+    camera.projection[1][1] *= -1.0f;
+
+    const float tanHalfY = std::tan(verticalFov * 0.5f);
+    camera.tanHalfFov = glm::vec2(tanHalfY * aspect, tanHalfY);
+    return camera;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Right-handed view looking down -Z, with a Vulkan projection: depth maps
+// to 0..1 and Y is flipped so clip space points down, which keeps the
+// mesher's counter-clockwise winding front facing.
+struct Camera
+{
+    glm::mat4 view{ 1.0f };
+    glm::mat4 projection{ 1.0f };
+    glm::vec3 position{ 0.0f };
+    float nearPlane{ 0.1f };
+    float farPlane{ 1000.0f };
+    // Half extent of the view plane at distance 1, per axis
+    glm::vec2 tanHalfFov{ 1.0f };
+
+    // Yaw turns right from -Z, pitch looks up; both in radians
+    static Camera perspective(
+        const glm::vec3& position, float yaw, float pitch, float aspect,
+        float verticalFov, float nearPlane, float farPlane
+    );
+
+    glm::mat4 viewProjection() const
+    {
+        return projection * view;
+    }
+};
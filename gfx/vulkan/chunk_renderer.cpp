@@ -0,0 +1,410 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include "chunk_renderer.h"
+#include "core/profiling/profiler.h"
+#include "gfx/vulkan/shader.h"
+#include "gfx/vulkan/transparency_pass.h"
+
+namespace
+{
+constexpr uint32_t INDICES_PER_QUAD{ 6 };
+constexpr std::array<uint32_t, INDICES_PER_QUAD> QUAD_INDICES{
+    0, 1, 2, 0, 2, 3
+};
+} // namespace
+
+void ChunkRenderer::init(
+    VkDevice device, VmaAllocator allocator, VkPipelineCache pipelineCache,
+    VkFormat colorFormat, VkFormat depthFormat,
+    VkDescriptorSetLayout shadowLayout
+)
+{
+    PROFILE_ZONE("ChunkRenderer::init");
+    m_device = device;
+    m_allocator = allocator;
+    createIndexBuffer();
+    createPipeline(pipelineCache, colorFormat, depthFormat, shadowLayout);
+}
+
+void ChunkRenderer::shutdown()
+{
+    if (!m_device)
+    {
+        return;
+    }
+
+    vmaDestroyBuffer(m_allocator, m_indexBuffer, m_indexAllocation);
+    m_indexBuffer = VK_NULL_HANDLE;
+    m_indexAllocation = VK_NULL_HANDLE;
+    vkDestroyPipeline(m_device, m_pipeline, nullptr);
+    vkDestroyPipeline(m_device, m_translucentPipeline, nullptr);
+    vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+    m_device = VK_NULL_HANDLE;
+}
+
+void ChunkRenderer::createIndexBuffer()
+{
+    const VkDeviceSize size{ VkDeviceSize{ MAX_QUADS_PER_DRAW } *
+                             INDICES_PER_QUAD * sizeof(uint32_t) };
+    VkBufferCreateInfo bufferCI{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = size,
+        .usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    // Written once, so host-visible memory is fine; VMA still prefers
+    // device-local memory the host can map when there is some
+    VmaAllocationCreateInfo allocCI{
+        .flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
+                 VMA_ALLOCATION_CREATE_MAPPED_BIT,
+        .usage = VMA_MEMORY_USAGE_AUTO,
+    };
+    VmaAllocationInfo info{};
+    if (vmaCreateBuffer(
+            m_allocator,
+            &bufferCI,
+            &allocCI,
+            &m_indexBuffer,
+            &m_indexAllocation,
+            &info
+        ) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to allocate chunk index buffer");
+    }
+
+    auto* indices = static_cast<uint32_t*>(info.pMappedData);
+    for (uint32_t quad = 0; quad < MAX_QUADS_PER_DRAW; quad++)
+    {
+        for (uint32_t i = 0; i < INDICES_PER_QUAD; i++)
+        {
+            *indices++ = quad * 4 + QUAD_INDICES[i];
+        }
+    }
+    vmaFlushAllocation(m_allocator, m_indexAllocation, 0, VK_WHOLE_SIZE);
+}
+
+void ChunkRenderer::createPipeline(
+    VkPipelineCache pipelineCache, VkFormat colorFormat, VkFormat depthFormat,
+    VkDescriptorSetLayout shadowLayout
+)
+{
+    VkPushConstantRange pushConstantRange{
+        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        .offset = 0,
+        .size = sizeof(PushConstants),
+    };
+    VkPipelineLayoutCreateInfo layoutCI{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 1,
+        .pSetLayouts = &shadowLayout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange,
+    };
+    if (vkCreatePipelineLayout(
+            m_device,
+            &layoutCI,
+            nullptr,
+            &m_pipelineLayout
+        ) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create chunk pipeline layout");
+    }
+
+    VkShaderModule vertexModule = loadShaderModule(m_device, "chunk.vert.spv");
+    VkShaderModule fragmentModule =
+        loadShaderModule(m_device, "chunk.frag.spv");
+    std::array<VkPipelineShaderStageCreateInfo, 2> stages{
+        VkPipelineShaderStageCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_VERTEX_BIT,
+            .module = vertexModule,
+            .pName = "main",
+        },
+        VkPipelineShaderStageCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+            .module = fragmentModule,
+            .pName = "main",
+        },
+    };
+
+    // Vertices are pulled in the shader, so there is no vertex input
+    VkPipelineVertexInputStateCreateInfo vertexInput{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+    };
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+        .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+    };
+    VkPipelineViewportStateCreateInfo viewport{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        .viewportCount = 1,
+        .scissorCount = 1,
+    };
+    // The camera flips Y, which keeps the mesher's winding
+    // counter-clockwise on screen
+    VkPipelineRasterizationStateCreateInfo rasterization{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+        .polygonMode = VK_POLYGON_MODE_FILL,
+        .cullMode = VK_CULL_MODE_BACK_BIT,
+        .frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+        .lineWidth = 1.0f,
+    };
+    // A water surface or pane of glass is seen from both sides
+    VkPipelineRasterizationStateCreateInfo translucentRasterization{
+        rasterization
+    };
+    translucentRasterization.cullMode = VK_CULL_MODE_NONE;
+    VkPipelineMultisampleStateCreateInfo multisample{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+    };
+    VkPipelineDepthStencilStateCreateInfo depthStencil{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+        .depthTestEnable = VK_TRUE,
+        .depthWriteEnable = VK_TRUE,
+        .depthCompareOp = VK_COMPARE_OP_LESS,
+    };
+    // Translucent faces are hidden by opaque ones but never by each other
+    VkPipelineDepthStencilStateCreateInfo translucentDepthStencil{
+        depthStencil
+    };
+    translucentDepthStencil.depthWriteEnable = VK_FALSE;
+    VkPipelineColorBlendAttachmentState blendAttachment{
+        .blendEnable = VK_FALSE,
+        .colorWriteMask = VK_COLOR_COMPONENT_R_BIT |
+                          VK_COLOR_COMPONENT_G_BIT |
+                          VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
+    };
+    VkPipelineColorBlendStateCreateInfo colorBlend{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+        .attachmentCount = 1,
+        .pAttachments = &blendAttachment,
+    };
+    // Weighted colours add up in the accumulation target, and every layer
+    // multiplies the revealage by its transmittance
+    const std::array<VkPipelineColorBlendAttachmentState, 2>
+        translucentBlendAttachments{
+            VkPipelineColorBlendAttachmentState{
+                .blendEnable = VK_TRUE,
+                .srcColorBlendFactor = VK_BLEND_FACTOR_ONE,
+                .dstColorBlendFactor = VK_BLEND_FACTOR_ONE,
+                .colorBlendOp = VK_BLEND_OP_ADD,
+                .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+                .dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+                .alphaBlendOp = VK_BLEND_OP_ADD,
+                .colorWriteMask = VK_COLOR_COMPONENT_R_BIT |
+                                  VK_COLOR_COMPONENT_G_BIT |
+                                  VK_COLOR_COMPONENT_B_BIT |
+                                  VK_COLOR_COMPONENT_A_BIT,
+            },
+            VkPipelineColorBlendAttachmentState{
+                .blendEnable = VK_TRUE,
+                .srcColorBlendFactor = VK_BLEND_FACTOR_ZERO,
+                .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_COLOR,
+                .colorBlendOp = VK_BLEND_OP_ADD,
+                .srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
+                .dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+                .alphaBlendOp = VK_BLEND_OP_ADD,
+                .colorWriteMask = VK_COLOR_COMPONENT_R_BIT,
+            },
+        };
+    VkPipelineColorBlendStateCreateInfo translucentColorBlend{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+        .attachmentCount =
+            static_cast<uint32_t>(translucentBlendAttachments.size()),
+        .pAttachments = translucentBlendAttachments.data(),
+    };
+    const std::array<VkDynamicState, 2> dynamicStates{
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR,
+    };
+    VkPipelineDynamicStateCreateInfo dynamicState{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .dynamicStateCount = static_cast<uint32_t>(dynamicStates.size()),
+        .pDynamicStates = dynamicStates.data(),
+    };
+    VkPipelineRenderingCreateInfo renderingCI{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+        .colorAttachmentCount = 1,
+        .pColorAttachmentFormats = &colorFormat,
+        .depthAttachmentFormat = depthFormat,
+    };
+    const std::array<VkFormat, 2> translucentFormats{
+        TransparencyPass::ACCUMULATION_FORMAT,
+        TransparencyPass::REVEALAGE_FORMAT,
+    };
+    VkPipelineRenderingCreateInfo translucentRenderingCI{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+        .colorAttachmentCount =
+            static_cast<uint32_t>(translucentFormats.size()),
+        .pColorAttachmentFormats = translucentFormats.data(),
+        .depthAttachmentFormat = depthFormat,
+    };
+
+    // TRANSLUCENT in chunk.frag
+    const VkBool32 translucent{ VK_TRUE };
+    VkSpecializationMapEntry specializationEntry{
+        .constantID = 0,
+        .offset = 0,
+        .size = sizeof(VkBool32),
+    };
+    VkSpecializationInfo specialization{
+        .mapEntryCount = 1,
+        .pMapEntries = &specializationEntry,
+        .dataSize = sizeof(VkBool32),
+        .pData = &translucent,
+    };
+    std::array<VkPipelineShaderStageCreateInfo, 2> translucentStages{ stages };
+    translucentStages[1].pSpecializationInfo = &specialization;
+
+    VkGraphicsPipelineCreateInfo pipelineCI{
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext = &renderingCI,
+        .stageCount = static_cast<uint32_t>(stages.size()),
+        .pStages = stages.data(),
+        .pVertexInputState = &vertexInput,
+        .pInputAssemblyState = &inputAssembly,
+        .pViewportState = &viewport,
+        .pRasterizationState = &rasterization,
+        .pMultisampleState = &multisample,
+        .pDepthStencilState = &depthStencil,
+        .pColorBlendState = &colorBlend,
+        .pDynamicState = &dynamicState,
+        .layout = m_pipelineLayout,
+    };
+    VkGraphicsPipelineCreateInfo translucentCI{ pipelineCI };
+    translucentCI.pNext = &translucentRenderingCI;
+    translucentCI.pStages = translucentStages.data();
+    translucentCI.pRasterizationState = &translucentRasterization;
+    translucentCI.pDepthStencilState = &translucentDepthStencil;
+    translucentCI.pColorBlendState = &translucentColorBlend;
+    const std::array<VkGraphicsPipelineCreateInfo, 2> pipelineCIs{
+        pipelineCI,
+        translucentCI,
+    };
+
+    std::array<VkPipeline, 2> pipelines{};
+    VkResult result = vkCreateGraphicsPipelines(
+        m_device,
+        pipelineCache,
+        static_cast<uint32_t>(pipelineCIs.size()),
+        pipelineCIs.data(),
+        nullptr,
+        pipelines.data()
+    );
+    vkDestroyShaderModule(m_device, vertexModule, nullptr);
+    vkDestroyShaderModule(m_device, fragmentModule, nullptr);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create chunk pipelines");
+    }
+    m_pipeline = pipelines[0];
+    m_translucentPipeline = pipelines[1];
+}
+
+void ChunkRenderer::draw(
+    VkCommandBuffer cmd, const MeshArena& arena,
+    const std::vector<ChunkCoord>& chunks, const Camera& camera,
+    const ChunkShading& shading
+)
+{
+    PROFILE_ZONE("ChunkRenderer::draw");
+    drawMeshes(cmd, arena, chunks, camera, shading, false);
+}
+
+void ChunkRenderer::drawTranslucent(
+    VkCommandBuffer cmd, const MeshArena& arena,
+    const std::vector<ChunkCoord>& chunks, const Camera& camera,
+    const ChunkShading& shading
+)
+{
+    PROFILE_ZONE("ChunkRenderer::drawTranslucent");
+    drawMeshes(cmd, arena, chunks, camera, shading, true);
+}
+
+void ChunkRenderer::drawMeshes(
+    VkCommandBuffer cmd, const MeshArena& arena,
+    const std::vector<ChunkCoord>& chunks, const Camera& camera,
+    const ChunkShading& shading, bool translucent
+)
+{
+    constexpr VkShaderStageFlags stages{ VK_SHADER_STAGE_VERTEX_BIT |
+                                         VK_SHADER_STAGE_FRAGMENT_BIT };
+    constexpr uint32_t chunkOffset{ offsetof(PushConstants, chunkOrigin) };
+
+    vkCmdBindPipeline(
+        cmd,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        translucent ? m_translucentPipeline : m_pipeline
+    );
+    vkCmdBindIndexBuffer(cmd, m_indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+    vkCmdBindDescriptorSets(
+        cmd,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        m_pipelineLayout,
+        0,
+        1,
+        &shading.shadowMap,
+        0,
+        nullptr
+    );
+
+    PushConstants pushConstants{
+        .viewProjection = camera.viewProjection(),
+        .lights = shading.lights,
+        .shadows = shading.shadows,
+    };
+    vkCmdPushConstants(
+        cmd,
+        m_pipelineLayout,
+        stages,
+        0,
+        chunkOffset,
+        &pushConstants
+    );
+
+    for (const ChunkCoord& coord : chunks)
+    {
+        const MeshAllocation* mesh = arena.find(coord);
+        if (!mesh)
+        {
+            continue;
+        }
+        // The translucent quads follow the opaque ones
+        const uint32_t firstQuad = translucent ? mesh->opaqueQuads() : 0;
+        const uint32_t quadCount =
+            translucent ? mesh->translucentQuads : mesh->opaqueQuads();
+        if (quadCount == 0)
+        {
+            continue;
+        }
+
+        pushConstants.chunkOrigin = coord * CHUNK_SIZE;
+        pushConstants.vertices = mesh->address;
+        vkCmdPushConstants(
+            cmd,
+            m_pipelineLayout,
+            stages,
+            chunkOffset,
+            sizeof(PushConstants) - chunkOffset,
+            &pushConstants.chunkOrigin
+        );
+        for (uint32_t first = 0; first < quadCount;
+             first += MAX_QUADS_PER_DRAW)
+        {
+            const uint32_t quads =
+                std::min(quadCount - first, MAX_QUADS_PER_DRAW);
+            vkCmdDrawIndexed(
+                cmd,
+                quads * INDICES_PER_QUAD,
+                1,
+                0,
+                static_cast<int32_t>((firstQuad + first) * 4),
+                0
+            );
+        }
+    }
+}
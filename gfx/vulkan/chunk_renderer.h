@@ -0,0 +1,102 @@
+#pragma once
+
+#ifndef VK_NO_PROTOTYPES
+#define VK_NO_PROTOTYPES
+#endif
+
+#include <volk/volk.h>
+#include <vma/vk_mem_alloc.h>
+#include <vector>
+#include <glm/glm.hpp>
+#include "gfx/camera.h"
+#include "gfx/vulkan/mesh_arena.h"
+
+// Forward pass over the chunk meshes in MeshArena. Vertices are pulled
+// through each mesh's device address, and every draw shares one index
+// buffer holding the 0-1-2 0-2-3 quad pattern, so nothing is rebound
+// between chunks but two push constants. Shading reads the cluster light
+// lists built by ClusteredLighting and the sun shadows of ShadowCascades;
+// see shaders/chunk.frag. The translucent quads at the end of each mesh
+// go through a second pipeline into TransparencyPass's targets.
+
+// Per-frame inputs of the chunk fragment shader
+struct ChunkShading
+{
+    // ClusteredLighting::frameAddress()
+    VkDeviceAddress lights{ 0 };
+    // ShadowCascades::frameAddress()
+    VkDeviceAddress shadows{ 0 };
+    // ShadowCascades::descriptorSet()
+    VkDescriptorSet shadowMap{ VK_NULL_HANDLE };
+};
+
+class ChunkRenderer
+{
+  public:
+    // Quads covered by the shared index buffer; larger meshes are drawn
+    // in several ranges
+    static constexpr uint32_t MAX_QUADS_PER_DRAW{ 1u << 16 };
+
+  private:
+    struct PushConstants
+    {
+        glm::mat4 viewProjection{ 1.0f };
+        VkDeviceAddress lights{ 0 };
+        VkDeviceAddress shadows{ 0 };
+        // Per chunk from here on
+        glm::ivec3 chunkOrigin{ 0 };
+        uint32_t pad{ 0 };
+        VkDeviceAddress vertices{ 0 };
+    };
+
+    VkDevice m_device{ VK_NULL_HANDLE };
+    VmaAllocator m_allocator{ VK_NULL_HANDLE };
+    VkPipelineLayout m_pipelineLayout{ VK_NULL_HANDLE };
+    VkPipeline m_pipeline{ VK_NULL_HANDLE };
+    VkPipeline m_translucentPipeline{ VK_NULL_HANDLE };
+    VkBuffer m_indexBuffer{ VK_NULL_HANDLE };
+    VmaAllocation m_indexAllocation{ VK_NULL_HANDLE };
+
+    void createIndexBuffer();
+    void createPipeline(
+        VkPipelineCache pipelineCache, VkFormat colorFormat,
+        VkFormat depthFormat, VkDescriptorSetLayout shadowLayout
+    );
+    void drawMeshes(
+        VkCommandBuffer cmd, const MeshArena& arena,
+        const std::vector<ChunkCoord>& chunks, const Camera& camera,
+        const ChunkShading& shading, bool translucent
+    );
+
+  public:
+    ChunkRenderer() = default;
+    ~ChunkRenderer()
+    {
+        shutdown();
+    }
+    ChunkRenderer(const ChunkRenderer&) = delete;
+    ChunkRenderer& operator=(const ChunkRenderer&) = delete;
+
+    // `shadowLayout` is ShadowCascades::descriptorSetLayout()
+    void init(
+        VkDevice device, VmaAllocator allocator, VkPipelineCache pipelineCache,
+        VkFormat colorFormat, VkFormat depthFormat,
+        VkDescriptorSetLayout shadowLayout
+    );
+    void shutdown();
+
+    // Draws the opaque part of the chunks that have a mesh, in list order;
+    // record inside DynamicResolution::beginRendering()
+    void draw(
+        VkCommandBuffer cmd, const MeshArena& arena,
+        const std::vector<ChunkCoord>& chunks, const Camera& camera,
+        const ChunkShading& shading
+    );
+    // Draws the translucent part in any order; record inside
+    // TransparencyPass::beginRendering()
+    void drawTranslucent(
+        VkCommandBuffer cmd, const MeshArena& arena,
+        const std::vector<ChunkCoord>& chunks, const Camera& camera,
+        const ChunkShading& shading
+    );
+};
@@ -0,0 +1,350 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include "clustered_lighting.h"
+#include "core/profiling/profiler.h"
+#include "gfx/vulkan/shader.h"
+
+namespace
+{
+// local_size_x of light_cluster.comp, one invocation per cluster
+constexpr uint32_t WORKGROUP_SIZE{ 64 };
+
+constexpr VkDeviceSize CLUSTER_BUFFER_SIZE{
+    (VkDeviceSize{ ClusteredLighting::CLUSTER_COUNT } +
+     VkDeviceSize{ ClusteredLighting::CLUSTER_COUNT } *
+         ClusteredLighting::MAX_LIGHTS_PER_CLUSTER) *
+    sizeof(uint32_t)
+};
+
+const std::array<glm::ivec3, 6> NEIGHBORS{
+    glm::ivec3{ 1, 0, 0 },  glm::ivec3{ -1, 0, 0 }, glm::ivec3{ 0, 1, 0 },
+    glm::ivec3{ 0, -1, 0 }, glm::ivec3{ 0, 0, 1 },  glm::ivec3{ 0, 0, -1 },
+};
+
+glm::vec3 emissionColor(BlockId id)
+{
+    const uint32_t color = lightColor(id);
+    return glm::vec3(
+               (color >> 16) & 0xFF,
+               (color >> 8) & 0xFF,
+               color & 0xFF
+           ) /
+           255.0f;
+}
+
+void memoryBarrier(
+    VkCommandBuffer cmd, VkPipelineStageFlags2 srcStage,
+    VkAccessFlags2 srcAccess, VkPipelineStageFlags2 dstStage,
+    VkAccessFlags2 dstAccess
+)
+{
+    VkMemoryBarrier2 barrier{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+        .srcStageMask = srcStage,
+        .srcAccessMask = srcAccess,
+        .dstStageMask = dstStage,
+        .dstAccessMask = dstAccess,
+    };
+    VkDependencyInfo dependencyInfo{ .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                     .memoryBarrierCount = 1,
+                                     .pMemoryBarriers = &barrier };
+    vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+}
+} // namespace
+
+void ClusteredLighting::init(
+    VkDevice device, VmaAllocator allocator, VkPipelineCache pipelineCache
+)
+{
+    PROFILE_ZONE("ClusteredLighting::init");
+    m_device = device;
+    m_allocator = allocator;
+    m_pipelineCache = pipelineCache;
+
+    constexpr VkBufferUsageFlags storage{
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+        VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+    };
+    for (auto& slot : m_slots)
+    {
+        slot.frame = createBuffer(
+            sizeof(FrameHeader) + MAX_LIGHTS * sizeof(PointLight),
+            storage,
+            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
+                VMA_ALLOCATION_CREATE_MAPPED_BIT
+        );
+        slot.clusters = createBuffer(CLUSTER_BUFFER_SIZE, storage, 0);
+    }
+
+    createPipeline();
+}
+
+void ClusteredLighting::shutdown()
+{
+    if (!m_device)
+    {
+        return;
+    }
+
+    for (auto& slot : m_slots)
+    {
+        for (Buffer* buffer : { &slot.frame, &slot.clusters })
+        {
+            vmaDestroyBuffer(m_allocator, buffer->buffer, buffer->allocation);
+            *buffer = Buffer{};
+        }
+    }
+    vkDestroyPipeline(m_device, m_pipeline, nullptr);
+    vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+    m_chunkLights.clear();
+    m_device = VK_NULL_HANDLE;
+}
+
+ClusteredLighting::Buffer ClusteredLighting::createBuffer(
+    VkDeviceSize size, VkBufferUsageFlags usage, VmaAllocationCreateFlags flags
+)
+{
+    VkBufferCreateInfo bufferCI{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = size,
+        .usage = usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    VmaAllocationCreateInfo allocCI{
+        .flags = flags,
+        .usage = VMA_MEMORY_USAGE_AUTO,
+    };
+
+    Buffer buffer{};
+    VmaAllocationInfo info{};
+    if (vmaCreateBuffer(
+            m_allocator,
+            &bufferCI,
+            &allocCI,
+            &buffer.buffer,
+            &buffer.allocation,
+            &info
+        ) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to allocate light cluster buffer");
+    }
+    buffer.mapped = info.pMappedData;
+
+    VkBufferDeviceAddressInfo addressInfo{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+        .buffer = buffer.buffer,
+    };
+    buffer.address = vkGetBufferDeviceAddress(m_device, &addressInfo);
+    return buffer;
+}
+
+void ClusteredLighting::createPipeline()
+{
+    VkPushConstantRange pushConstantRange{
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(PushConstants),
+    };
+    VkPipelineLayoutCreateInfo layoutCI{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange,
+    };
+    if (vkCreatePipelineLayout(
+            m_device,
+            &layoutCI,
+            nullptr,
+            &m_pipelineLayout
+        ) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create light cluster layout");
+    }
+
+    VkShaderModule module =
+        loadShaderModule(m_device, "light_cluster.comp.spv");
+    VkComputePipelineCreateInfo pipelineCI{
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage =
+            VkPipelineShaderStageCreateInfo{
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                .module = module,
+                .pName = "main",
+            },
+        .layout = m_pipelineLayout,
+    };
+    VkResult result = vkCreateComputePipelines(
+        m_device,
+        m_pipelineCache,
+        1,
+        &pipelineCI,
+        nullptr,
+        &m_pipeline
+    );
+    vkDestroyShaderModule(m_device, module, nullptr);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create light cluster pipeline");
+    }
+}
+
+void ClusteredLighting::update(
+    const ChunkCoord& coord, const ChunkNeighborhood& neighborhood
+)
+{
+    const glm::vec3 origin = glm::vec3(coord * CHUNK_SIZE) + 0.5f;
+    std::vector<PointLight> lights;
+    for (int y = 0; y < CHUNK_SIZE; y++)
+    {
+        for (int z = 0; z < CHUNK_SIZE; z++)
+        {
+            for (int x = 0; x < CHUNK_SIZE; x++)
+            {
+                const BlockId id = neighborhood.block(x, y, z);
+                const uint8_t emission = lightEmission(id);
+                if (emission == 0)
+                {
+                    continue;
+                }
+                const bool exposed = std::any_of(
+                    NEIGHBORS.begin(),
+                    NEIGHBORS.end(),
+                    [&](const glm::ivec3& offset) {
+                        return !isOpaque(neighborhood.block(
+                            x + offset.x,
+                            y + offset.y,
+                            z + offset.z
+                        ));
+                    }
+                );
+                if (!exposed)
+                {
+                    continue;
+                }
+
+                // Block light loses one level per block, so the flood
+                // fill reaches exactly `emission` blocks out
+                const float strength =
+                    static_cast<float>(emission) / MAX_LIGHT_LEVEL;
+                lights.push_back(PointLight{
+                    .positionRadius = glm::vec4(
+                        origin + glm::vec3(x, y, z),
+                        static_cast<float>(emission)
+                    ),
+                    .color = glm::vec4(emissionColor(id) * strength, 0.0f),
+                });
+            }
+        }
+    }
+
+    if (lights.empty())
+    {
+        m_chunkLights.erase(coord);
+    }
+    else
+    {
+        m_chunkLights[coord] = std::move(lights);
+    }
+}
+
+void ClusteredLighting::remove(const ChunkCoord& coord)
+{
+    m_chunkLights.erase(coord);
+}
+
+void ClusteredLighting::record(
+    VkCommandBuffer cmd, uint32_t frameIndex, const Camera& camera,
+    VkExtent2D extent, const std::vector<ChunkCoord>& chunks
+)
+{
+    PROFILE_ZONE("ClusteredLighting::record");
+    FrameSlot& slot = m_slots[frameIndex];
+
+    // The chunk list is nearest first, so the cap drops distant lights
+    auto* header = static_cast<FrameHeader*>(slot.frame.mapped);
+    auto* lights = reinterpret_cast<PointLight*>(header + 1);
+    uint32_t count{ 0 };
+    for (const ChunkCoord& coord : chunks)
+    {
+        auto it = m_chunkLights.find(coord);
+        if (it == m_chunkLights.end())
+        {
+            continue;
+        }
+        const auto take = std::min<size_t>(
+            it->second.size(),
+            MAX_LIGHTS - count
+        );
+        std::memcpy(
+            lights + count,
+            it->second.data(),
+            take * sizeof(PointLight)
+        );
+        count += static_cast<uint32_t>(take);
+        if (count == MAX_LIGHTS)
+        {
+            break;
+        }
+    }
+    m_lightCount = count;
+
+    const glm::vec2 screenSize{ static_cast<float>(extent.width),
+                                static_cast<float>(extent.height) };
+    const float logDepthRange = std::log(camera.farPlane / camera.nearPlane);
+    *header = FrameHeader{
+        .view = camera.view,
+        .tanHalfFov = camera.tanHalfFov,
+        .tileSize = glm::ceil(
+            screenSize / glm::vec2(CLUSTERS_X, CLUSTERS_Y)
+        ),
+        .screenSize = screenSize,
+        .sliceScale = CLUSTERS_Z / logDepthRange,
+        .sliceBias =
+            -(CLUSTERS_Z * std::log(camera.nearPlane)) / logDepthRange,
+        .lightCount = count,
+        .clusters = slot.clusters.address,
+    };
+    vmaFlushAllocation(
+        m_allocator,
+        slot.frame.allocation,
+        0,
+        sizeof(FrameHeader) + count * sizeof(PointLight)
+    );
+
+    PushConstants pushConstants{ .frame = slot.frame.address };
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+    vkCmdPushConstants(
+        cmd,
+        m_pipelineLayout,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0,
+        sizeof(PushConstants),
+        &pushConstants
+    );
+    vkCmdDispatch(
+        cmd,
+        (CLUSTER_COUNT + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE,
+        1,
+        1
+    );
+
+    memoryBarrier(
+        cmd,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT
+    );
+}
+
+VkDeviceAddress ClusteredLighting::frameAddress(uint32_t frameIndex) const
+{
+    return m_slots[frameIndex].frame.address;
+}
+
+uint32_t ClusteredLighting::lightCount() const
+{
+    return m_lightCount;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#ifndef VK_NO_PROTOTYPES
+#define VK_NO_PROTOTYPES
+#endif
+
+#include <volk/volk.h>
+#include <vma/vk_mem_alloc.h>
+#include <array>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "gfx/camera.h"
+#include "gfx/vulkan/context.h"
+#include "world/mesher.h"
+
+// Matches PointLight in light_cluster.comp and chunk.frag
+struct PointLight
+{
+    glm::vec4 positionRadius{ 0.0f }; // world position, reach in blocks
+    glm::vec4 color{ 0.0f };          // linear rgb times intensity
+};
+
+// Emissive blocks as point lights, binned into a view-space cluster grid.
+//
+// Each frame the lights of the visible chunks are uploaded nearest chunk
+// first, and shaders/light_cluster.comp tests every light's sphere against
+// every cluster's box, one invocation per cluster. The per-cluster light
+// lists live in a device-local buffer whose address is stored in the
+// frame's header, next to the grid parameters, so the forward pass finds
+// both through one pointer and a fragment evaluates only the lights of its
+// own cluster. Depth slices are exponential, keeping clusters roughly cubic
+// from the near plane out.
+class ClusteredLighting
+{
+  public:
+    static constexpr uint32_t CLUSTERS_X{ 16 };
+    static constexpr uint32_t CLUSTERS_Y{ 9 };
+    static constexpr uint32_t CLUSTERS_Z{ 24 };
+    static constexpr uint32_t CLUSTER_COUNT{ CLUSTERS_X * CLUSTERS_Y *
+                                             CLUSTERS_Z };
+    // Lights past these limits are dropped, farthest chunks first
+    static constexpr uint32_t MAX_LIGHTS{ 16384 };
+    static constexpr uint32_t MAX_LIGHTS_PER_CLUSTER{ 128 };
+
+  private:
+    // Matches LightFrame in the shaders; the lights follow the header
+    struct FrameHeader
+    {
+        glm::mat4 view{ 1.0f };
+        glm::vec2 tanHalfFov{ 1.0f };
+        glm::vec2 tileSize{ 1.0f }; // pixels per cluster column and row
+        glm::vec2 screenSize{ 1.0f };
+        // slice = log(depth) * sliceScale + sliceBias
+        float sliceScale{ 0.0f };
+        float sliceBias{ 0.0f };
+        uint32_t lightCount{ 0 };
+        uint32_t pad{ 0 };
+        VkDeviceAddress clusters{ 0 };
+    };
+    static_assert(offsetof(FrameHeader, clusters) == 104);
+    static_assert(sizeof(FrameHeader) == 112);
+
+    struct PushConstants
+    {
+        VkDeviceAddress frame{ 0 };
+    };
+
+    struct Buffer
+    {
+        VkBuffer buffer{ VK_NULL_HANDLE };
+        VmaAllocation allocation{ VK_NULL_HANDLE };
+        VkDeviceAddress address{ 0 };
+        void* mapped{ nullptr };
+    };
+
+    // The GPU of one slot may still shade with its lists while the next
+    // frame bins, so each frame slot has its own copy of both buffers
+    struct FrameSlot
+    {
+        Buffer frame;    // header and lights, written by the host
+        Buffer clusters; // counts then indices, written by the compute pass
+    };
+
+    VkDevice m_device{ VK_NULL_HANDLE };
+    VmaAllocator m_allocator{ VK_NULL_HANDLE };
+    VkPipelineCache m_pipelineCache{ VK_NULL_HANDLE };
+    VkPipelineLayout m_pipelineLayout{ VK_NULL_HANDLE };
+    VkPipeline m_pipeline{ VK_NULL_HANDLE };
+    std::array<FrameSlot, MAX_FRAMES_IN_FLIGHT> m_slots;
+    std::unordered_map<ChunkCoord, std::vector<PointLight>, ChunkCoordHash>
+        m_chunkLights;
+    uint32_t m_lightCount{ 0 };
+
+    Buffer createBuffer(
+        VkDeviceSize size, VkBufferUsageFlags usage,
+        VmaAllocationCreateFlags flags
+    );
+    void createPipeline();
+
+  public:
+    ClusteredLighting() = default;
+    ~ClusteredLighting()
+    {
+        shutdown();
+    }
+    ClusteredLighting(const ClusteredLighting&) = delete;
+    ClusteredLighting& operator=(const ClusteredLighting&) = delete;
+
+    void init(
+        VkDevice device, VmaAllocator allocator, VkPipelineCache pipelineCache
+    );
+    void shutdown();
+
+    // Collects the chunk's emissive blocks that touch a non-opaque voxel;
+    // buried ones cannot light anything
+    void update(const ChunkCoord& coord, const ChunkNeighborhood& neighborhood);
+    void remove(const ChunkCoord& coord);
+
+    // Uploads the lights of `chunks` and records the binning pass, followed
+    // by a barrier for fragment shader reads; call after the frame's fence
+    void record(
+        VkCommandBuffer cmd, uint32_t frameIndex, const Camera& camera,
+        VkExtent2D extent, const std::vector<ChunkCoord>& chunks
+    );
+
+    // Header of the slot's light data, for the forward pass
+    VkDeviceAddress frameAddress(uint32_t frameIndex) const;
+    // Lights uploaded by the last record()
+    uint32_t lightCount() const;
+};
@@ -1,8 +1,13 @@
 #define VOLK_IMPLEMENTATION
 #define VMA_IMPLEMENTATION
 
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <stdexcept>
+#include "core/profiling/profiler.h"
+#include "core/profiling/startup_timeline.h"
 #include "gfx/vulkan/validation.h"
 #include <volk/volk.h>
 #include <SDL3/SDL.h>
@@ -10,41 +15,46 @@
 #include <vma/vk_mem_alloc.h>
 #include "context.h"
 
-void VulkanContext::createInstance()
+void VulkanContext::createInstance(
+    const std::vector<const char*>& windowExtensions
+)
 {
+    STARTUP_STAGE("createInstance");
     VkApplicationInfo appInfo{
         .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
         .pApplicationName = "App",
         .apiVersion = VULKAN_API_VERSION,
     };
 
-    // Get SDL extensions and add debug utils extension
-    uint32_t sdlExtensionCount{ 0 };
-    char const* const* sdlExtensions =
-        SDL_Vulkan_GetInstanceExtensions(&sdlExtensionCount);
+    // Validation costs hundreds of milliseconds at launch and multiplies
+    // the CPU cost of every call, so it is only loaded when asked for
+    m_validation = m_config.validation.enabled;
+    if (m_validation && !isValidationLayerAvailable())
+    {
+        std::cout << "Validation requested but " << VALIDATION_LAYER
+                  << " is not installed\n";
+        m_validation = false;
+    }
 
-    std::vector<const char*> extensions(
-        sdlExtensions,
-        sdlExtensions + sdlExtensionCount
-    );
-    extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+    std::vector<const char*> extensions = windowExtensions;
+    if (m_validation)
+    {
+        extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+    }
 
 #ifdef __APPLE__
     // Required for MoltenVK on macOS
     extensions.push_back(VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME);
 #endif
 
-    // Enable validation layer
-    const char* validationLayer = "VK_LAYER_KHRONOS_validation";
-
     VkInstanceCreateInfo instanceCI{
         .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
 #ifdef __APPLE__
         .flags = VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR,
 #endif
         .pApplicationInfo = &appInfo,
-        .enabledLayerCount = 1,
-        .ppEnabledLayerNames = &validationLayer,
+        .enabledLayerCount = m_validation ? 1u : 0u,
+        .ppEnabledLayerNames = &VALIDATION_LAYER,
         .enabledExtensionCount = static_cast<uint32_t>(extensions.size()),
         .ppEnabledExtensionNames = extensions.data(),
     };
@@ -60,6 +70,7 @@ void VulkanContext::createInstance()
 
 void VulkanContext::createSurface(const Window& window)
 {
+    STARTUP_STAGE("createSurface");
     SDL_Vulkan_CreateSurface(
         window.getSDLWindow(),
         m_instance,
@@ -91,6 +102,20 @@ void VulkanContext::selectPhysicalDevice()
         m_physicalDevice = devices[0];
     }
     m_queueFamily = findQueueFamily();
+
+    // GPU meshing compacts its output with subgroup prefix sums
+    VkPhysicalDeviceSubgroupProperties subgroupProperties{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES,
+    };
+    VkPhysicalDeviceProperties2 properties2{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = &subgroupProperties,
+    };
+    vkGetPhysicalDeviceProperties2(m_physicalDevice, &properties2);
+    m_subgroupArithmetic =
+        (subgroupProperties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) &&
+        (subgroupProperties.supportedOperations &
+         VK_SUBGROUP_FEATURE_ARITHMETIC_BIT);
 }
 
 uint32_t VulkanContext::findQueueFamily()
@@ -111,13 +136,16 @@ uint32_t VulkanContext::findQueueFamily()
     uint32_t queueFamily{ 0 };
     for (uint32_t i = 0; i < queueFamilyCount; i++)
     {
-        VkBool32 presentationSupport{ false };
-        vkGetPhysicalDeviceSurfaceSupportKHR(
-            m_physicalDevice,
-            i,
-            m_surface,
-            &presentationSupport
-        );
+        VkBool32 presentationSupport{ m_headless };
+        if (!m_headless)
+        {
+            vkGetPhysicalDeviceSurfaceSupportKHR(
+                m_physicalDevice,
+                i,
+                m_surface,
+                &presentationSupport
+            );
+        }
         if ((queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) &&
             presentationSupport)
         {
@@ -128,8 +156,35 @@ uint32_t VulkanContext::findQueueFamily()
     return queueFamily;
 }
 
+bool VulkanContext::isDeviceExtensionSupported(const char* name)
+{
+    uint32_t extensionCount{ 0 };
+    vkEnumerateDeviceExtensionProperties(
+        m_physicalDevice,
+        nullptr,
+        &extensionCount,
+        nullptr
+    );
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(
+        m_physicalDevice,
+        nullptr,
+        &extensionCount,
+        extensions.data()
+    );
+    for (const auto& extension : extensions)
+    {
+        if (std::strcmp(extension.extensionName, name) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 void VulkanContext::createLogicalDevice()
 {
+    STARTUP_STAGE("createLogicalDevice");
     const float queueFamilyPriorities{ 1.0f };
     VkDeviceQueueCreateInfo queueCI{
         .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
@@ -148,15 +203,36 @@ void VulkanContext::createLogicalDevice()
     VkPhysicalDeviceVulkan13Features enabledVk13Features{
         .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
         .pNext = &enabledVk12Features, // chain the 1.2 struct
-        .synchronization2 = VK_TRUE,   // better barriers
+        .subgroupSizeControl = VK_TRUE,  // required by 1.3
+        .computeFullSubgroups = VK_TRUE, // deterministic GPU meshing order
+        .synchronization2 = VK_TRUE,     // better barriers
         .dynamicRendering = VK_TRUE    // no render passes
     };
-    const std::vector<const char*> deviceExtensions{
-        VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+    std::vector<const char*> deviceExtensions{
 #ifdef __APPLE__
         "VK_KHR_portability_subset",
 #endif
     };
+    if (!m_headless)
+    {
+        deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    }
+
+    // Optional: lets GPU profiler zones line up with CPU zones exactly
+    m_calibratedTimestamps =
+        isDeviceExtensionSupported(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+    if (m_calibratedTimestamps)
+    {
+        deviceExtensions.push_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+    }
+
+    // Optional: real per-heap budgets instead of VMA's own estimate
+    m_memoryBudget =
+        isDeviceExtensionSupported(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    if (m_memoryBudget)
+    {
+        deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
 
     const VkPhysicalDeviceFeatures enabledVk10Features{
         .fillModeNonSolid = VK_TRUE,  // wireframe
@@ -183,8 +259,16 @@ void VulkanContext::createAllocator()
         .vkGetDeviceProcAddr = vkGetDeviceProcAddr,
     };
 
+    VmaAllocatorCreateFlags allocatorFlags{
+        VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT
+    };
+    if (m_memoryBudget)
+    {
+        allocatorFlags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+    }
+
     VmaAllocatorCreateInfo allocatorCI{
-        .flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT,
+        .flags = allocatorFlags,
         .physicalDevice = m_physicalDevice,
         .device = m_device,
         .pVulkanFunctions = &vulkanFunctions,
@@ -198,6 +282,101 @@ void VulkanContext::createAllocator()
     }
 }
 
+void VulkanContext::loadPipelineCacheData()
+{
+    STARTUP_STAGE("loadPipelineCacheData");
+    if (m_config.pipelineCachePath.empty())
+    {
+        return;
+    }
+    std::ifstream file(
+        m_config.pipelineCachePath,
+        std::ios::binary | std::ios::ate
+    );
+    if (!file)
+    {
+        return;
+    }
+    m_pipelineCacheData.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(
+        m_pipelineCacheData.data(),
+        static_cast<std::streamsize>(m_pipelineCacheData.size())
+    );
+}
+
+void VulkanContext::createPipelineCache()
+{
+    STARTUP_STAGE("createPipelineCache");
+
+    // Some drivers crash on caches from another device or driver version,
+    // so the header is checked before the data is handed over
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_physicalDevice, &properties);
+    VkPipelineCacheHeaderVersionOne header{};
+    if (m_pipelineCacheData.size() >= sizeof(header))
+    {
+        std::memcpy(&header, m_pipelineCacheData.data(), sizeof(header));
+    }
+    const bool compatible =
+        header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+        header.vendorID == properties.vendorID &&
+        header.deviceID == properties.deviceID &&
+        std::memcmp(
+            header.pipelineCacheUUID,
+            properties.pipelineCacheUUID,
+            VK_UUID_SIZE
+        ) == 0;
+    if (!compatible)
+    {
+        m_pipelineCacheData.clear();
+    }
+
+    VkPipelineCacheCreateInfo cacheCI{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = m_pipelineCacheData.size(),
+        .pInitialData = m_pipelineCacheData.data(),
+    };
+    if (vkCreatePipelineCache(m_device, &cacheCI, nullptr, &m_pipelineCache) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create pipeline cache");
+    }
+    m_pipelineCacheData = {};
+}
+
+void VulkanContext::savePipelineCache()
+{
+    if (!m_pipelineCache || m_config.pipelineCachePath.empty())
+    {
+        return;
+    }
+    size_t size{ 0 };
+    vkGetPipelineCacheData(m_device, m_pipelineCache, &size, nullptr);
+    std::vector<char> data(size);
+    if (vkGetPipelineCacheData(
+            m_device,
+            m_pipelineCache,
+            &size,
+            data.data()
+        ) != VK_SUCCESS)
+    {
+        return;
+    }
+
+    // Written aside and renamed so a crash never leaves a torn cache
+    const std::string tempPath = m_config.pipelineCachePath + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), static_cast<std::streamsize>(size));
+        if (!file)
+        {
+            return;
+        }
+    }
+    std::rename(tempPath.c_str(), m_config.pipelineCachePath.c_str());
+}
+
 VkSurfaceFormatKHR VulkanContext::chooseSwapSurfaceFormat(
     const std::vector<VkSurfaceFormatKHR>& availableFormats
 )
@@ -279,6 +458,8 @@ void VulkanContext::createSwapchain(
     const Window& window, const VkSwapchainKHR oldSwapchainHandle
 )
 {
+    PROFILE_ZONE("createSwapchain");
+
     // Query surface capabilities
     VkSurfaceCapabilitiesKHR capabilities;
     vkGetPhysicalDeviceSurfaceCapabilitiesKHR(
@@ -577,22 +758,146 @@ void VulkanContext::createSyncObjects()
     }
 }
 
-void VulkanContext::init(const Window& window)
+void VulkanContext::createFrameQueries()
+{
+    uint32_t queueFamilyCount{ 0 };
+    vkGetPhysicalDeviceQueueFamilyProperties(
+        m_physicalDevice,
+        &queueFamilyCount,
+        nullptr
+    );
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(
+        m_physicalDevice,
+        &queueFamilyCount,
+        queueFamilies.data()
+    );
+    uint32_t validBits = queueFamilies[m_queueFamily].timestampValidBits;
+    if (validBits == 0)
+    {
+        std::cout << "GPU frame timing disabled: queue has no timestamps\n";
+        return;
+    }
+    m_timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_physicalDevice, &properties);
+    m_nsPerTick = properties.limits.timestampPeriod;
+
+    VkQueryPoolCreateInfo queryPoolCI{
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = 2 * MAX_FRAMES_IN_FLIGHT,
+    };
+    if (vkCreateQueryPool(
+            m_device,
+            &queryPoolCI,
+            nullptr,
+            &m_frameQueryPool
+        ) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create frame query pool");
+    }
+}
+
+void VulkanContext::readFrameTime()
 {
-    volkInitialize();
-    createInstance();
+    // Called once the slot's fence has signalled, so the results are
+    // available without waiting
+    if (!m_frameTimed[m_currentFrame])
+    {
+        return;
+    }
+    std::array<uint64_t, 2> ticks{};
+    if (vkGetQueryPoolResults(
+            m_device,
+            m_frameQueryPool,
+            2 * m_currentFrame,
+            2,
+            sizeof(ticks),
+            ticks.data(),
+            sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT
+        ) != VK_SUCCESS)
+    {
+        return;
+    }
+    uint64_t elapsed = (ticks[1] - ticks[0]) & m_timestampMask;
+    m_gpuFrameMs = static_cast<float>(elapsed * m_nsPerTick * 1e-6);
+}
+
+void VulkanContext::beginInit(
+    JobSystem& jobs, const VulkanContextConfig& config
+)
+{
+    m_config = config;
+    m_jobs = &jobs;
+
+    // SDL has to be asked on the thread that owns video
+    if (!SDL_Vulkan_LoadLibrary(nullptr))
+    {
+        throw std::runtime_error("failed to load the Vulkan library");
+    }
+    uint32_t sdlExtensionCount{ 0 };
+    char const* const* sdlExtensions =
+        SDL_Vulkan_GetInstanceExtensions(&sdlExtensionCount);
+    submitInitJobs(std::vector<const char*>(
+        sdlExtensions,
+        sdlExtensions + sdlExtensionCount
+    ));
+}
+
+void VulkanContext::submitInitJobs(std::vector<const char*> windowExtensions)
+{
+    m_jobs->submit(
+        [this, windowExtensions = std::move(windowExtensions)] {
+            try
+            {
+                if (volkInitialize() != VK_SUCCESS)
+                {
+                    throw std::runtime_error(
+                        "failed to load the Vulkan loader"
+                    );
+                }
+                createInstance(windowExtensions);
+                volkLoadInstance(m_instance);
+                if (m_validation)
+                {
+                    m_debugMessenger =
+                        createDebugMessenger(m_instance, m_config.validation);
+                }
+            }
+            catch (...)
+            {
+                m_initError = std::current_exception();
+            }
+        },
+        &m_initJobs
+    );
+    m_jobs->submit([this] { loadPipelineCacheData(); }, &m_initJobs);
+}
+
+void VulkanContext::waitForInitJobs()
+{
+    assert(m_jobs);
+    {
+        STARTUP_STAGE("waitForInstance");
+        m_jobs->wait(m_initJobs);
+    }
+    if (m_initError)
+    {
+        std::rethrow_exception(m_initError);
+    }
     assert(m_instance);
-    volkLoadInstance(m_instance);
-    m_debugMessenger = createDebugMessenger(m_instance);
-    assert(m_debugMessenger);
+}
+
+void VulkanContext::init(const Window& window)
+{
+    PROFILE_ZONE("VulkanContext::init");
+    waitForInitJobs();
     createSurface(window);
     assert(m_surface);
-    selectPhysicalDevice();
-    assert(m_physicalDevice);
-    createLogicalDevice();
-    assert(m_device);
-    createAllocator();
-    assert(m_allocator);
+    createDeviceObjects();
     createSwapchain(window, nullptr);
     assert(m_swapchain.handle);
     createDepthResources();
@@ -600,6 +905,36 @@ void VulkanContext::init(const Window& window)
     assert(m_swapchain.depthImageView);
     assert(m_swapchain.depthFormat);
     assert(m_swapchain.depthImageAllocation);
+    createFrameObjects();
+}
+
+void VulkanContext::initHeadless(
+    JobSystem& jobs, const VulkanContextConfig& config
+)
+{
+    PROFILE_ZONE("VulkanContext::initHeadless");
+    m_config = config;
+    m_jobs = &jobs;
+    m_headless = true;
+    submitInitJobs({});
+    waitForInitJobs();
+    createDeviceObjects();
+    createFrameObjects();
+}
+
+void VulkanContext::createDeviceObjects()
+{
+    selectPhysicalDevice();
+    assert(m_physicalDevice);
+    createLogicalDevice();
+    assert(m_device);
+    createPipelineCache();
+    createAllocator();
+    assert(m_allocator);
+}
+
+void VulkanContext::createFrameObjects()
+{
     createCommandPool();
     assert(m_commandPool);
     createCommandBuffers();
@@ -614,6 +949,14 @@ void VulkanContext::init(const Window& window)
         assert(m_presentationSemaphores[i]);
         assert(m_renderSemaphores[i]);
     }
+    m_gpuProfiler.init(
+        m_physicalDevice,
+        m_device,
+        m_queueFamily,
+        MAX_FRAMES_IN_FLIGHT,
+        m_calibratedTimestamps
+    );
+    createFrameQueries();
 }
 
 void VulkanContext::transitionImageLayout(
@@ -659,49 +1002,282 @@ void recordCommandBuffer(VkCommandBuffer cmd, uint32_t imageIndex)
 {
 }
 
-void VulkanContext::beginFrame(const Window& window)
+VkCommandBuffer VulkanContext::beginCommands(VkPipelineStageFlags2 startStage)
 {
-    vkWaitForFences(m_device, 1, &m_fences[m_currentFrame], true, UINT64_MAX);
+    // Only reset once we know work will be submitted, or the next wait on
+    // this fence would never return
     vkResetFences(m_device, 1, &m_fences[m_currentFrame]);
 
-    uint32_t imageIndex;
+    VkCommandBuffer cmdBuffer = m_commandBuffers[m_currentFrame];
+    vkResetCommandBuffer(cmdBuffer, 0);
+    VkCommandBufferBeginInfo cmdBufferBI{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+
+    };
+    vkBeginCommandBuffer(cmdBuffer, &cmdBufferBI);
+    m_gpuProfiler.beginFrame(cmdBuffer, m_currentFrame);
+
+    if (m_frameQueryPool)
+    {
+        readFrameTime();
+        vkCmdResetQueryPool(
+            cmdBuffer,
+            m_frameQueryPool,
+            2 * m_currentFrame,
+            2
+        );
+        vkCmdWriteTimestamp2(
+            cmdBuffer,
+            startStage,
+            m_frameQueryPool,
+            2 * m_currentFrame
+        );
+        m_frameTimed[m_currentFrame] = true;
+    }
+    return cmdBuffer;
+}
+
+void VulkanContext::endCommands(VkCommandBuffer cmd)
+{
+    if (m_frameQueryPool)
+    {
+        vkCmdWriteTimestamp2(
+            cmd,
+            VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            m_frameQueryPool,
+            2 * m_currentFrame + 1
+        );
+    }
+    vkEndCommandBuffer(cmd);
+}
+
+VkCommandBuffer VulkanContext::beginFrame(const Window& window)
+{
+    PROFILE_ZONE("VulkanContext::beginFrame");
+    vkWaitForFences(m_device, 1, &m_fences[m_currentFrame], true, UINT64_MAX);
+
     VkResult result = vkAcquireNextImageKHR(
         m_device,
         m_swapchain.handle,
         UINT64_MAX,
         m_presentationSemaphores[m_currentFrame],
         VK_NULL_HANDLE,
-        &imageIndex
+        &m_imageIndex
     );
     if (result == VK_ERROR_OUT_OF_DATE_KHR)
     {
         recreateSwapchain(window);
-        return;
+        return VK_NULL_HANDLE;
     }
 
-    VkCommandBuffer cmdBuffer = m_commandBuffers[m_currentFrame];
-    vkResetCommandBuffer(cmdBuffer, 0);
-    VkCommandBufferBeginInfo cmdBufferBI{
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+    // The submit waits for the acquired image at the colour output stage,
+    // and under FIFO that wait lasts until the next vblank when the GPU is
+    // idle. Starting the frame timer in that stage leaves the wait out, so
+    // a frame that fits in the refresh interval does not read as a full one
+    VkCommandBuffer cmdBuffer =
+        beginCommands(VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT);
+    transitionImageLayout(
+        cmdBuffer,
+        m_swapchain.images[m_imageIndex],
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+    );
+    return cmdBuffer;
+}
 
-    };
-    vkBeginCommandBuffer(cmdBuffer, &cmdBufferBI);
+void VulkanContext::endFrame(const Window& window)
+{
+    PROFILE_ZONE("VulkanContext::endFrame");
+    VkCommandBuffer cmdBuffer = m_commandBuffers[m_currentFrame];
 
     transitionImageLayout(
         cmdBuffer,
-        m_swapchain.images[imageIndex],
+        m_swapchain.images[m_imageIndex],
         VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
         VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
     );
+    endCommands(cmdBuffer);
+
+    VkSemaphoreSubmitInfo waitInfo{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+        .semaphore = m_presentationSemaphores[m_currentFrame],
+        .stageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+    };
+    VkSemaphoreSubmitInfo signalInfo{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+        .semaphore = m_renderSemaphores[m_currentFrame],
+        .stageMask = VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT,
+    };
+    VkCommandBufferSubmitInfo cmdBufferInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+        .commandBuffer = cmdBuffer,
+    };
+    VkSubmitInfo2 submitInfo{
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+        .waitSemaphoreInfoCount = 1,
+        .pWaitSemaphoreInfos = &waitInfo,
+        .commandBufferInfoCount = 1,
+        .pCommandBufferInfos = &cmdBufferInfo,
+        .signalSemaphoreInfoCount = 1,
+        .pSignalSemaphoreInfos = &signalInfo,
+    };
+    if (vkQueueSubmit2(m_queue, 1, &submitInfo, m_fences[m_currentFrame]) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to submit frame");
+    }
+    m_gpuProfiler.markSubmitted();
+
+    VkPresentInfoKHR presentInfo{
+        .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+        .waitSemaphoreCount = 1,
+        .pWaitSemaphores = &m_renderSemaphores[m_currentFrame],
+        .swapchainCount = 1,
+        .pSwapchains = &m_swapchain.handle,
+        .pImageIndices = &m_imageIndex,
+    };
+    VkResult result = vkQueuePresentKHR(m_queue, &presentInfo);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+    {
+        recreateSwapchain(window);
+    }
+
+    m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 }
 
-void endFrame()
+VkCommandBuffer VulkanContext::beginHeadlessFrame()
 {
+    PROFILE_ZONE("VulkanContext::beginHeadlessFrame");
+    vkWaitForFences(m_device, 1, &m_fences[m_currentFrame], true, UINT64_MAX);
+    return beginCommands(VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT);
+}
+
+void VulkanContext::endHeadlessFrame()
+{
+    PROFILE_ZONE("VulkanContext::endHeadlessFrame");
+    VkCommandBuffer cmdBuffer = m_commandBuffers[m_currentFrame];
+    endCommands(cmdBuffer);
+
+    VkCommandBufferSubmitInfo cmdBufferInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+        .commandBuffer = cmdBuffer,
+    };
+    VkSubmitInfo2 submitInfo{
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+        .commandBufferInfoCount = 1,
+        .pCommandBufferInfos = &cmdBufferInfo,
+    };
+    if (vkQueueSubmit2(m_queue, 1, &submitInfo, m_fences[m_currentFrame]) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to submit frame");
+    }
+    m_gpuProfiler.markSubmitted();
+    m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+}
+
+void VulkanContext::beginRendering(
+    VkCommandBuffer cmd, const VkClearColorValue& clear
+)
+{
+    // The depth buffer is cleared every frame, so its old contents are
+    // dropped; the barrier only orders this frame's tests after the last
+    // frame's writes
+    const bool hasStencil =
+        m_swapchain.depthFormat == VK_FORMAT_D32_SFLOAT_S8_UINT ||
+        m_swapchain.depthFormat == VK_FORMAT_D24_UNORM_S8_UINT;
+    VkImageMemoryBarrier2 depthBarrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .srcStageMask = VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+        .srcAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+        .dstStageMask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT |
+                        VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+        .dstAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                         VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = m_swapchain.depthImage,
+        .subresourceRange = {
+            .aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT |
+                          (hasStencil ? VK_IMAGE_ASPECT_STENCIL_BIT : 0u),
+            .levelCount = 1,
+            .layerCount = 1,
+        },
+    };
+    VkDependencyInfo dependencyInfo{ .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                     .imageMemoryBarrierCount = 1,
+                                     .pImageMemoryBarriers = &depthBarrier };
+    vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+
+    VkRenderingAttachmentInfo colorAttachment{
+        .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+        .imageView = m_swapchain.imageViews[m_imageIndex],
+        .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+        .clearValue = { .color = clear },
+    };
+    VkRenderingAttachmentInfo depthAttachment{
+        .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+        .imageView = m_swapchain.depthImageView,
+        .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        .clearValue = { .depthStencil = { .depth = 1.0f } },
+    };
+    VkRenderingInfo renderingInfo{
+        .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+        .renderArea = { .offset = { 0, 0 }, .extent = m_swapchain.extent },
+        .layerCount = 1,
+        .colorAttachmentCount = 1,
+        .pColorAttachments = &colorAttachment,
+        .pDepthAttachment = &depthAttachment,
+    };
+    vkCmdBeginRendering(cmd, &renderingInfo);
+
+    VkViewport viewport{
+        .x = 0.0f,
+        .y = 0.0f,
+        .width = static_cast<float>(m_swapchain.extent.width),
+        .height = static_cast<float>(m_swapchain.extent.height),
+        .minDepth = 0.0f,
+        .maxDepth = 1.0f,
+    };
+    VkRect2D scissor{ .offset = { 0, 0 }, .extent = m_swapchain.extent };
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+    vkCmdSetScissor(cmd, 0, 1, &scissor);
+}
+
+void VulkanContext::endRendering(VkCommandBuffer cmd)
+{
+    vkCmdEndRendering(cmd);
 }
 
 void VulkanContext::shutdown()
 {
+    if (m_device)
+    {
+        vkDeviceWaitIdle(m_device);
+    }
+    if (m_jobs)
+    {
+        m_jobs->wait(m_initJobs);
+    }
+    m_gpuProfiler.shutdown();
+    if (m_frameQueryPool)
+    {
+        vkDestroyQueryPool(m_device, m_frameQueryPool, nullptr);
+    }
+
+    if (m_pipelineCache)
+    {
+        savePipelineCache();
+        vkDestroyPipelineCache(m_device, m_pipelineCache, nullptr);
+    }
+
     // Destroy sync objects
     for (auto i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
     {
@@ -767,3 +1343,53 @@ VkInstance VulkanContext::getInstance() const
 {
     return m_instance;
 }
+
+VkDevice VulkanContext::getDevice() const
+{
+    return m_device;
+}
+
+VmaAllocator VulkanContext::getAllocator() const
+{
+    return m_allocator;
+}
+
+uint32_t VulkanContext::getCurrentFrame() const
+{
+    return m_currentFrame;
+}
+
+VkPipelineCache VulkanContext::getPipelineCache() const
+{
+    return m_pipelineCache;
+}
+
+GpuProfiler& VulkanContext::getGpuProfiler()
+{
+    return m_gpuProfiler;
+}
+
+float VulkanContext::getGpuFrameMs() const
+{
+    return m_gpuFrameMs;
+}
+
+VkExtent2D VulkanContext::getSwapchainExtent() const
+{
+    return m_swapchain.extent;
+}
+
+VkFormat VulkanContext::getSwapchainFormat() const
+{
+    return m_swapchain.imageFormat;
+}
+
+VkFormat VulkanContext::getDepthFormat() const
+{
+    return m_swapchain.depthFormat;
+}
+
+bool VulkanContext::supportsSubgroupArithmetic() const
+{
+    return m_subgroupArithmetic;
+}
@@ -9,8 +9,13 @@
 #include <volk/volk.h>
 #include <SDL3/SDL.h>
 #include <vma/vk_mem_alloc.h>
+#include <exception>
+#include <string>
 #include <vector>
+#include "core/jobs/job_system.h"
 #include "core/platform/window.h"
+#include "gfx/vulkan/gpu_profiler.h"
+#include "gfx/vulkan/validation.h"
 
 constexpr uint32_t VULKAN_API_VERSION{ VK_API_VERSION_1_3 };
 constexpr uint32_t MAX_FRAMES_IN_FLIGHT{ 2 };
@@ -62,9 +67,28 @@ struct Swapchain
     }
 };
 
+struct VulkanContextConfig
+{
+    ValidationConfig validation;
+    // Pipeline cache kept between runs; empty disables it. Callers opt in
+    // with an absolute path, a relative one would follow the working
+    // directory
+    std::string pipelineCachePath;
+};
+
 class VulkanContext
 {
   private:
+    VulkanContextConfig m_config;
+    bool m_validation{ false };
+    // No surface or swapchain; frames are submitted without presenting
+    bool m_headless{ false };
+    JobSystem* m_jobs{ nullptr };
+    JobCounter m_initJobs;
+    std::exception_ptr m_initError;
+    std::vector<char> m_pipelineCacheData;
+    VkPipelineCache m_pipelineCache{ VK_NULL_HANDLE };
+
     VkDebugUtilsMessengerEXT m_debugMessenger{ VK_NULL_HANDLE };
     VkInstance m_instance{ VK_NULL_HANDLE };
     VkSurfaceKHR m_surface{ VK_NULL_HANDLE };
@@ -80,9 +104,30 @@ class VulkanContext
     std::array<VkSemaphore, MAX_FRAMES_IN_FLIGHT> m_presentationSemaphores;
     std::array<VkSemaphore, MAX_FRAMES_IN_FLIGHT> m_renderSemaphores;
     uint32_t m_currentFrame{ 0 };
+    uint32_t m_imageIndex{ 0 };
+    bool m_calibratedTimestamps{ false };
+    bool m_memoryBudget{ false };
+    bool m_subgroupArithmetic{ false };
+    GpuProfiler m_gpuProfiler;
+
+    // Two timestamps per frame slot bracketing the command buffer, minus
+    // the wait for the swapchain image; unlike the profiler's zones these
+    // are kept in release builds
+    VkQueryPool m_frameQueryPool{ VK_NULL_HANDLE };
+    std::array<bool, MAX_FRAMES_IN_FLIGHT> m_frameTimed{};
+    uint64_t m_timestampMask{ 0 };
+    double m_nsPerTick{ 1.0 };
+    float m_gpuFrameMs{ 0.0f };
 
     // Instance
-    void createInstance();
+    void submitInitJobs(std::vector<const char*> windowExtensions);
+    void waitForInitJobs();
+    void createInstance(const std::vector<const char*>& windowExtensions);
+
+    // Everything from the physical device up to the allocator, and the
+    // per-frame command buffers and sync objects
+    void createDeviceObjects();
+    void createFrameObjects();
 
     // Surface
     void createSurface(const Window& window);
@@ -90,11 +135,17 @@ class VulkanContext
     // Device selection
     void selectPhysicalDevice();
     uint32_t findQueueFamily();
+    bool isDeviceExtensionSupported(const char* name);
     void createLogicalDevice();
 
     // VMA Allocator
     void createAllocator();
 
+    // Pipeline cache
+    void loadPipelineCacheData();
+    void createPipelineCache();
+    void savePipelineCache();
+
     // Swapchain
     void createSwapchain(
         const Window& window, const VkSwapchainKHR oldSwapchainHandle
@@ -123,7 +174,14 @@ class VulkanContext
     // Fences and semaphores
     void createSyncObjects();
 
+    // GPU frame timestamps
+    void createFrameQueries();
+    void readFrameTime();
+
     // Frame logic
+    // The frame timer starts once startStage is reached
+    VkCommandBuffer beginCommands(VkPipelineStageFlags2 startStage);
+    void endCommands(VkCommandBuffer cmd);
     void recordCommandBuffer(VkCommandBuffer cmd, uint32_t imageIndex);
     void transitionImageLayout(
         VkCommandBuffer cmd, VkImage image, VkImageLayout oldLayout,
@@ -143,10 +201,42 @@ class VulkanContext
     VulkanContext(VulkanContext&&) = delete;
     VulkanContext& operator=(VulkanContext&&) = delete;
 
+    // Startup is split so instance creation and the pipeline cache read run
+    // on workers while the caller creates the window. Call beginInit once
+    // SDL video is up, then init with the window.
+    void beginInit(JobSystem& jobs, const VulkanContextConfig& config);
     void init(const Window& window);
-
-    void beginFrame(const Window& window);
-    void endFrame();
+    // Device without a surface, for offscreen tools such as voxel-bench
+    void initHeadless(JobSystem& jobs, const VulkanContextConfig& config);
+
+    // Returns the frame's command buffer with the swapchain image in
+    // COLOR_ATTACHMENT_OPTIMAL, or VK_NULL_HANDLE when the frame is skipped
+    // because the swapchain had to be recreated
+    VkCommandBuffer beginFrame(const Window& window);
+    void endFrame(const Window& window);
+    // Frame pacing for initHeadless contexts: waits on the slot's fence and
+    // submits without presenting
+    VkCommandBuffer beginHeadlessFrame();
+    void endHeadlessFrame();
+
+    // Dynamic rendering into the frame's swapchain image and the depth
+    // attachment, both cleared; viewport and scissor cover the swapchain
+    void beginRendering(VkCommandBuffer cmd, const VkClearColorValue& clear);
+    void endRendering(VkCommandBuffer cmd);
 
     VkInstance getInstance() const;
+    VkDevice getDevice() const;
+    VmaAllocator getAllocator() const;
+    uint32_t getCurrentFrame() const;
+    VkPipelineCache getPipelineCache() const;
+    GpuProfiler& getGpuProfiler();
+    // GPU time of the latest frame whose results are back, from the
+    // swapchain image becoming available (or the first command, headless)
+    // to the last command; MAX_FRAMES_IN_FLIGHT frames old, 0 until then or
+    // when the queue has no timestamps
+    float getGpuFrameMs() const;
+    VkExtent2D getSwapchainExtent() const;
+    VkFormat getSwapchainFormat() const;
+    VkFormat getDepthFormat() const;
+    bool supportsSubgroupArithmetic() const;
 };
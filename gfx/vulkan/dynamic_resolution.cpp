@@ -0,0 +1,643 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include "dynamic_resolution.h"
+#include "core/profiling/profiler.h"
+#include "gfx/vulkan/shader.h"
+
+namespace
+{
+// Rounds a scaled side up to DynamicResolution::SIZE_STEP, within the
+// swapchain's side
+uint32_t scaledSide(uint32_t side, float scale)
+{
+    constexpr uint32_t step{ DynamicResolution::SIZE_STEP };
+    uint32_t scaled = static_cast<uint32_t>(std::ceil(side * scale));
+    scaled = (scaled + step - 1) / step * step;
+    return std::clamp(scaled, 1u, side);
+}
+
+bool hasStencil(VkFormat format)
+{
+    return format == VK_FORMAT_D32_SFLOAT_S8_UINT ||
+           format == VK_FORMAT_D24_UNORM_S8_UINT;
+}
+
+void colorBarrier(
+    VkCommandBuffer cmd, VkImage image, VkImageLayout oldLayout,
+    VkImageLayout newLayout, VkPipelineStageFlags2 dstStage,
+    VkAccessFlags2 dstAccess
+)
+{
+    VkImageMemoryBarrier2 barrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+        .srcAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+        .dstStageMask = dstStage,
+        .dstAccessMask = dstAccess,
+        .oldLayout = oldLayout,
+        .newLayout = newLayout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = image,
+        .subresourceRange = { .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                              .levelCount = 1,
+                              .layerCount = 1 },
+    };
+    VkDependencyInfo dependencyInfo{ .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                     .imageMemoryBarrierCount = 1,
+                                     .pImageMemoryBarriers = &barrier };
+    vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+}
+
+void setViewport(VkCommandBuffer cmd, VkExtent2D extent)
+{
+    VkViewport viewport{
+        .x = 0.0f,
+        .y = 0.0f,
+        .width = static_cast<float>(extent.width),
+        .height = static_cast<float>(extent.height),
+        .minDepth = 0.0f,
+        .maxDepth = 1.0f,
+    };
+    VkRect2D scissor{ .offset = { 0, 0 }, .extent = extent };
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+    vkCmdSetScissor(cmd, 0, 1, &scissor);
+}
+} // namespace
+
+void DynamicResolution::init(
+    VkDevice device, VmaAllocator allocator, VkPipelineCache pipelineCache,
+    VkFormat colorFormat, VkFormat depthFormat, VkExtent2D maxExtent,
+    const DynamicResolutionConfig& config
+)
+{
+    PROFILE_ZONE("DynamicResolution::init");
+    m_device = device;
+    m_allocator = allocator;
+    m_config = config;
+    m_colorFormat = colorFormat;
+    m_depthFormat = depthFormat;
+    m_scale = m_config.maxScale;
+
+    createTargets(maxExtent);
+    createDescriptors();
+    writeDescriptor();
+    createPipeline(pipelineCache);
+}
+
+void DynamicResolution::shutdown()
+{
+    if (!m_device)
+    {
+        return;
+    }
+
+    vkDestroyPipeline(m_device, m_pipeline, nullptr);
+    vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+    vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(m_device, m_setLayout, nullptr);
+    vkDestroySampler(m_device, m_sampler, nullptr);
+    destroyTarget(m_color);
+    destroyTarget(m_depth);
+    m_device = VK_NULL_HANDLE;
+}
+
+DynamicResolution::Target DynamicResolution::createTarget(
+    VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect
+)
+{
+    VkImageCreateInfo imageCI{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = format,
+        .extent = { .width = m_capacity.width,
+                    .height = m_capacity.height,
+                    .depth = 1 },
+        .mipLevels = 1,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+    VmaAllocationCreateInfo allocCI{
+        .flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT,
+        .usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+    };
+
+    Target target{};
+    if (vmaCreateImage(
+            m_allocator,
+            &imageCI,
+            &allocCI,
+            &target.image,
+            &target.allocation,
+            nullptr
+        ) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to allocate render target");
+    }
+
+    VkImageViewCreateInfo viewCI{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .image = target.image,
+        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .format = format,
+        .subresourceRange = { .aspectMask = aspect,
+                              .baseMipLevel = 0,
+                              .levelCount = 1,
+                              .baseArrayLayer = 0,
+                              .layerCount = 1 },
+    };
+    if (vkCreateImageView(m_device, &viewCI, nullptr, &target.view) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create render target view");
+    }
+    return target;
+}
+
+void DynamicResolution::destroyTarget(Target& target)
+{
+    vkDestroyImageView(m_device, target.view, nullptr);
+    vmaDestroyImage(m_allocator, target.image, target.allocation);
+    target = Target{};
+}
+
+void DynamicResolution::createTargets(VkExtent2D extent)
+{
+    m_capacity = extent;
+    m_color = createTarget(
+        m_colorFormat,
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_IMAGE_ASPECT_COLOR_BIT
+    );
+    m_depth = createTarget(
+        m_depthFormat,
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+        VK_IMAGE_ASPECT_DEPTH_BIT
+    );
+    std::cout << "Render targets allocated: " << extent.width << "x"
+              << extent.height << '\n';
+}
+
+void DynamicResolution::createDescriptors()
+{
+    // Clamped so the bilinear taps at the window's edges stay inside the
+    // image; upscale.frag clamps the far edges of the render extent itself
+    VkSamplerCreateInfo samplerCI{
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter = VK_FILTER_LINEAR,
+        .minFilter = VK_FILTER_LINEAR,
+        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .maxLod = 0.0f,
+    };
+    if (vkCreateSampler(m_device, &samplerCI, nullptr, &m_sampler) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create upscale sampler");
+    }
+
+    VkDescriptorSetLayoutBinding binding{
+        .binding = 0,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .descriptorCount = 1,
+        .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+    };
+    VkDescriptorSetLayoutCreateInfo setLayoutCI{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = 1,
+        .pBindings = &binding,
+    };
+    if (vkCreateDescriptorSetLayout(
+            m_device,
+            &setLayoutCI,
+            nullptr,
+            &m_setLayout
+        ) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create upscale set layout");
+    }
+
+    VkDescriptorPoolSize poolSize{
+        .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .descriptorCount = 1,
+    };
+    VkDescriptorPoolCreateInfo poolCI{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets = 1,
+        .poolSizeCount = 1,
+        .pPoolSizes = &poolSize,
+    };
+    if (vkCreateDescriptorPool(m_device, &poolCI, nullptr, &m_descriptorPool) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create upscale descriptor pool");
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = m_descriptorPool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &m_setLayout,
+    };
+    if (vkAllocateDescriptorSets(m_device, &allocInfo, &m_descriptorSet) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to allocate upscale descriptor set");
+    }
+}
+
+void DynamicResolution::writeDescriptor()
+{
+    VkDescriptorImageInfo imageInfo{
+        .sampler = m_sampler,
+        .imageView = m_color.view,
+        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+    };
+    VkWriteDescriptorSet write{
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = m_descriptorSet,
+        .dstBinding = 0,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .pImageInfo = &imageInfo,
+    };
+    vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+}
+
+void DynamicResolution::createPipeline(VkPipelineCache pipelineCache)
+{
+    VkPushConstantRange pushConstantRange{
+        .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+        .offset = 0,
+        .size = sizeof(PushConstants),
+    };
+    VkPipelineLayoutCreateInfo layoutCI{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 1,
+        .pSetLayouts = &m_setLayout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange,
+    };
+    if (vkCreatePipelineLayout(
+            m_device,
+            &layoutCI,
+            nullptr,
+            &m_pipelineLayout
+        ) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create upscale pipeline layout");
+    }
+
+    VkShaderModule vertexModule =
+        loadShaderModule(m_device, "fullscreen.vert.spv");
+    VkShaderModule fragmentModule =
+        loadShaderModule(m_device, "upscale.frag.spv");
+    std::array<VkPipelineShaderStageCreateInfo, 2> stages{
+        VkPipelineShaderStageCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_VERTEX_BIT,
+            .module = vertexModule,
+            .pName = "main",
+        },
+        VkPipelineShaderStageCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+            .module = fragmentModule,
+            .pName = "main",
+        },
+    };
+
+    // One triangle covering the screen, generated from the vertex index
+    VkPipelineVertexInputStateCreateInfo vertexInput{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+    };
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+        .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+    };
+    VkPipelineViewportStateCreateInfo viewport{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        .viewportCount = 1,
+        .scissorCount = 1,
+    };
+    VkPipelineRasterizationStateCreateInfo rasterization{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+        .polygonMode = VK_POLYGON_MODE_FILL,
+        .cullMode = VK_CULL_MODE_NONE,
+        .frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+        .lineWidth = 1.0f,
+    };
+    VkPipelineMultisampleStateCreateInfo multisample{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+    };
+    // The swapchain pass carries a depth attachment, which the upscale
+    // neither tests nor writes
+    VkPipelineDepthStencilStateCreateInfo depthStencil{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+        .depthTestEnable = VK_FALSE,
+        .depthWriteEnable = VK_FALSE,
+    };
+    VkPipelineColorBlendAttachmentState blendAttachment{
+        .blendEnable = VK_FALSE,
+        .colorWriteMask = VK_COLOR_COMPONENT_R_BIT |
+                          VK_COLOR_COMPONENT_G_BIT |
+                          VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
+    };
+    VkPipelineColorBlendStateCreateInfo colorBlend{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+        .attachmentCount = 1,
+        .pAttachments = &blendAttachment,
+    };
+    const std::array<VkDynamicState, 2> dynamicStates{
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR,
+    };
+    VkPipelineDynamicStateCreateInfo dynamicState{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .dynamicStateCount = static_cast<uint32_t>(dynamicStates.size()),
+        .pDynamicStates = dynamicStates.data(),
+    };
+    VkPipelineRenderingCreateInfo renderingCI{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+        .colorAttachmentCount = 1,
+        .pColorAttachmentFormats = &m_colorFormat,
+        .depthAttachmentFormat = m_depthFormat,
+    };
+
+    VkGraphicsPipelineCreateInfo pipelineCI{
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext = &renderingCI,
+        .stageCount = static_cast<uint32_t>(stages.size()),
+        .pStages = stages.data(),
+        .pVertexInputState = &vertexInput,
+        .pInputAssemblyState = &inputAssembly,
+        .pViewportState = &viewport,
+        .pRasterizationState = &rasterization,
+        .pMultisampleState = &multisample,
+        .pDepthStencilState = &depthStencil,
+        .pColorBlendState = &colorBlend,
+        .pDynamicState = &dynamicState,
+        .layout = m_pipelineLayout,
+    };
+    VkResult result = vkCreateGraphicsPipelines(
+        m_device,
+        pipelineCache,
+        1,
+        &pipelineCI,
+        nullptr,
+        &m_pipeline
+    );
+    vkDestroyShaderModule(m_device, vertexModule, nullptr);
+    vkDestroyShaderModule(m_device, fragmentModule, nullptr);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create upscale pipeline");
+    }
+}
+
+void DynamicResolution::update(float gpuFrameMs, VkExtent2D displayExtent)
+{
+    PROFILE_ZONE("DynamicResolution::update");
+    if (displayExtent.width > m_capacity.width ||
+        displayExtent.height > m_capacity.height)
+    {
+        // Only reachable by moving the window to a larger display
+        vkDeviceWaitIdle(m_device);
+        destroyTarget(m_color);
+        destroyTarget(m_depth);
+        createTargets(VkExtent2D{
+            .width = std::max(displayExtent.width, m_capacity.width),
+            .height = std::max(displayExtent.height, m_capacity.height),
+        });
+        writeDescriptor();
+    }
+
+    if (gpuFrameMs > 0.0f)
+    {
+        m_smoothedMs = m_smoothedMs > 0.0f
+                           ? m_smoothedMs + (gpuFrameMs - m_smoothedMs) *
+                                                SMOOTHING
+                           : gpuFrameMs;
+        const float error = m_smoothedMs / m_config.targetFrameMs - 1.0f;
+        if (std::abs(error) > DEADBAND)
+        {
+            const float ideal =
+                m_scale * std::sqrt(m_config.targetFrameMs / m_smoothedMs);
+            m_scale = std::clamp(
+                m_scale + (ideal - m_scale) * RESPONSE,
+                m_config.minScale,
+                m_config.maxScale
+            );
+        }
+    }
+
+    m_displayExtent = displayExtent;
+    m_renderExtent = VkExtent2D{
+        .width = scaledSide(displayExtent.width, m_scale),
+        .height = scaledSide(displayExtent.height, m_scale),
+    };
+}
+
+void DynamicResolution::beginRendering(
+    VkCommandBuffer cmd, const VkClearColorValue& clear
+)
+{
+    // Both targets are cleared, so their old contents are dropped; the
+    // barriers only order this frame's writes after the last frame's
+    // upscale reads and depth tests
+    std::array<VkImageMemoryBarrier2, 2> barriers{
+        VkImageMemoryBarrier2{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .srcStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+            .srcAccessMask = VK_ACCESS_2_NONE,
+            .dstStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+            .dstAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = m_color.image,
+            .subresourceRange = { .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                  .levelCount = 1,
+                                  .layerCount = 1 },
+        },
+        VkImageMemoryBarrier2{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .srcStageMask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT |
+                            VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+            .srcAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT |
+                            VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+            .dstAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                             VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = m_depth.image,
+            .subresourceRange = {
+                .aspectMask =
+                    VK_IMAGE_ASPECT_DEPTH_BIT |
+                    (hasStencil(m_depthFormat) ? VK_IMAGE_ASPECT_STENCIL_BIT
+                                               : 0u),
+                .levelCount = 1,
+                .layerCount = 1,
+            },
+        },
+    };
+    VkDependencyInfo dependencyInfo{
+        .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .imageMemoryBarrierCount = static_cast<uint32_t>(barriers.size()),
+        .pImageMemoryBarriers = barriers.data(),
+    };
+    vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+
+    VkRenderingAttachmentInfo colorAttachment{
+        .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+        .imageView = m_color.view,
+        .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+        .clearValue = { .color = clear },
+    };
+    VkRenderingAttachmentInfo depthAttachment{
+        .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+        .imageView = m_depth.view,
+        .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+        .clearValue = { .depthStencil = { .depth = 1.0f } },
+    };
+    VkRenderingInfo renderingInfo{
+        .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+        .renderArea = { .offset = { 0, 0 }, .extent = m_renderExtent },
+        .layerCount = 1,
+        .colorAttachmentCount = 1,
+        .pColorAttachments = &colorAttachment,
+        .pDepthAttachment = &depthAttachment,
+    };
+    vkCmdBeginRendering(cmd, &renderingInfo);
+    setViewport(cmd, m_renderExtent);
+}
+
+void DynamicResolution::continueRendering(VkCommandBuffer cmd)
+{
+    VkRenderingAttachmentInfo colorAttachment{
+        .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+        .imageView = m_color.view,
+        .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_LOAD,
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+    };
+    VkRenderingInfo renderingInfo{
+        .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+        .renderArea = { .offset = { 0, 0 }, .extent = m_renderExtent },
+        .layerCount = 1,
+        .colorAttachmentCount = 1,
+        .pColorAttachments = &colorAttachment,
+    };
+    vkCmdBeginRendering(cmd, &renderingInfo);
+    setViewport(cmd, m_renderExtent);
+}
+
+void DynamicResolution::endRendering(VkCommandBuffer cmd)
+{
+    vkCmdEndRendering(cmd);
+
+    // Later passes blend over the colour and test against the depth
+    std::array<VkMemoryBarrier2, 2> barriers{
+        VkMemoryBarrier2{
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+            .srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+            .srcAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+            .dstAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT |
+                             VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+        },
+        VkMemoryBarrier2{
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+            .srcStageMask = VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+            .srcAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT |
+                            VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+            .dstAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+        },
+    };
+    VkDependencyInfo dependencyInfo{
+        .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .memoryBarrierCount = static_cast<uint32_t>(barriers.size()),
+        .pMemoryBarriers = barriers.data(),
+    };
+    vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+}
+
+void DynamicResolution::upscale(VkCommandBuffer cmd, VulkanContext& ctx)
+{
+    colorBarrier(
+        cmd,
+        m_color.image,
+        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+        VK_ACCESS_2_SHADER_SAMPLED_READ_BIT
+    );
+
+    const glm::vec2 capacity{ static_cast<float>(m_capacity.width),
+                              static_cast<float>(m_capacity.height) };
+    const glm::vec2 render{ static_cast<float>(m_renderExtent.width),
+                            static_cast<float>(m_renderExtent.height) };
+    const PushConstants push{
+        .uvScale = render / capacity,
+        .uvMax = (render - 0.5f) / capacity,
+        .texelSize = 1.0f / capacity,
+        .sharpness = m_config.sharpness,
+    };
+    // Every pixel is overwritten, the clear colour never shows
+    ctx.beginRendering(cmd, VkClearColorValue{});
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline);
+    vkCmdBindDescriptorSets(
+        cmd,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        m_pipelineLayout,
+        0,
+        1,
+        &m_descriptorSet,
+        0,
+        nullptr
+    );
+    vkCmdPushConstants(
+        cmd,
+        m_pipelineLayout,
+        VK_SHADER_STAGE_FRAGMENT_BIT,
+        0,
+        sizeof(PushConstants),
+        &push
+    );
+    vkCmdDraw(cmd, 3, 1, 0, 0);
+    ctx.endRendering(cmd);
+}
+
+float DynamicResolution::scale() const
+{
+    return m_scale;
+}
+
+VkExtent2D DynamicResolution::renderExtent() const
+{
+    return m_renderExtent;
+}
+
+VkImageView DynamicResolution::depthView() const
+{
+    return m_depth.view;
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#ifndef VK_NO_PROTOTYPES
+#define VK_NO_PROTOTYPES
+#endif
+
+#include <volk/volk.h>
+#include <vma/vk_mem_alloc.h>
+#include <glm/glm.hpp>
+#include "gfx/vulkan/context.h"
+
+struct DynamicResolutionConfig
+{
+    // GPU frame time the render scale is steered towards
+    float targetFrameMs{ 1000.0f / 60.0f };
+    // Render size per axis as a fraction of the swapchain
+    float minScale{ 0.5f };
+    float maxScale{ 1.0f };
+    // 0 is a plain bilinear upscale, 1 the strongest sharpening
+    float sharpness{ 0.5f };
+};
+
+// Scene rendering at a resolution that follows the GPU frame time.
+//
+// The scene pass draws into internal colour and depth targets allocated
+// once at the largest size the swapchain can reach, and only the top-left
+// render extent of them is used. Each frame the extent is picked from the
+// context's GPU frame time: the frame cost is taken to grow with the pixel
+// count, so the scale moves towards sqrt(target / measured), a fraction of
+// the way per frame and only when the smoothed time leaves a deadband
+// around the target. shaders/upscale.frag then stretches the render extent
+// over the swapchain image with contrast-adaptive sharpening. The depth
+// target outlives the scene pass, so later passes such as
+// TransparencyPass can test against it.
+class DynamicResolution
+{
+  public:
+    // Relative frame time error the scale tolerates before moving
+    static constexpr float DEADBAND{ 0.08f };
+    // Weight of the newest frame in the smoothed GPU time
+    static constexpr float SMOOTHING{ 0.15f };
+    // Fraction of the way to the ideal scale taken per frame
+    static constexpr float RESPONSE{ 0.25f };
+    // Render sizes are rounded up to this many pixels, so small scale
+    // changes do not move the viewport every frame
+    static constexpr uint32_t SIZE_STEP{ 8 };
+
+  private:
+    // Matches the push block in upscale.frag
+    struct PushConstants
+    {
+        glm::vec2 uvScale{ 1.0f };
+        // Last texel centre inside the render extent
+        glm::vec2 uvMax{ 1.0f };
+        glm::vec2 texelSize{ 1.0f };
+        float sharpness{ 0.0f };
+        uint32_t pad{ 0 };
+    };
+
+    struct Target
+    {
+        VkImage image{ VK_NULL_HANDLE };
+        VmaAllocation allocation{ VK_NULL_HANDLE };
+        VkImageView view{ VK_NULL_HANDLE };
+    };
+
+    VkDevice m_device{ VK_NULL_HANDLE };
+    VmaAllocator m_allocator{ VK_NULL_HANDLE };
+    DynamicResolutionConfig m_config;
+    VkFormat m_colorFormat{ VK_FORMAT_UNDEFINED };
+    VkFormat m_depthFormat{ VK_FORMAT_UNDEFINED };
+    Target m_color;
+    Target m_depth;
+    VkExtent2D m_capacity{};
+    VkExtent2D m_displayExtent{};
+    VkExtent2D m_renderExtent{};
+    float m_scale{ 1.0f };
+    float m_smoothedMs{ 0.0f };
+
+    VkSampler m_sampler{ VK_NULL_HANDLE };
+    VkDescriptorSetLayout m_setLayout{ VK_NULL_HANDLE };
+    VkDescriptorPool m_descriptorPool{ VK_NULL_HANDLE };
+    VkDescriptorSet m_descriptorSet{ VK_NULL_HANDLE };
+    VkPipelineLayout m_pipelineLayout{ VK_NULL_HANDLE };
+    VkPipeline m_pipeline{ VK_NULL_HANDLE };
+
+    Target createTarget(
+        VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect
+    );
+    void destroyTarget(Target& target);
+    void createTargets(VkExtent2D extent);
+    void createDescriptors();
+    void writeDescriptor();
+    void createPipeline(VkPipelineCache pipelineCache);
+
+  public:
+    DynamicResolution() = default;
+    ~DynamicResolution()
+    {
+        shutdown();
+    }
+    DynamicResolution(const DynamicResolution&) = delete;
+    DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+    // The colour and depth formats are the swapchain's, which the scene
+    // and upscale pipelines are both built against; maxExtent sizes the
+    // internal targets
+    void init(
+        VkDevice device, VmaAllocator allocator, VkPipelineCache pipelineCache,
+        VkFormat colorFormat, VkFormat depthFormat, VkExtent2D maxExtent,
+        const DynamicResolutionConfig& config = {}
+    );
+    void shutdown();
+
+    // Feeds the latest GPU frame time and picks the render extent for a
+    // swapchain of displayExtent; call once per frame before recording.
+    // Only a swapchain larger than maxExtent reallocates, after a device
+    // wait.
+    void update(float gpuFrameMs, VkExtent2D displayExtent);
+
+    // Dynamic rendering into the internal targets, both cleared; viewport
+    // and scissor cover the render extent
+    void beginRendering(VkCommandBuffer cmd, const VkClearColorValue& clear);
+    // Colour target only, loaded, for full-screen passes over the scene
+    void continueRendering(VkCommandBuffer cmd);
+    // Ends either pass; the depth is kept for later passes to test against
+    void endRendering(VkCommandBuffer cmd);
+
+    // Stretches the scene over the swapchain image with sharpening, in a
+    // pass of its own begun through the context
+    void upscale(VkCommandBuffer cmd, VulkanContext& ctx);
+
+    float scale() const;
+    // Size of the scene pass this frame, also the screen size the light
+    // clusters are binned for
+    VkExtent2D renderExtent() const;
+    // Stays valid until the targets are reallocated by update()
+    VkImageView depthView() const;
+};
@@ -0,0 +1,377 @@
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+#include "gpu_mesher.h"
+#include "core/profiling/profiler.h"
+#include "gfx/vulkan/shader.h"
+
+namespace
+{
+constexpr VkDeviceSize VOXELS_PER_CHUNK{ ChunkNeighborhood::PADDED_VOLUME };
+constexpr VkDeviceSize VERTICES_PER_CHUNK{
+    VkDeviceSize{ GpuMesher::MAX_QUADS_PER_CHUNK } * 4
+};
+
+void memoryBarrier(
+    VkCommandBuffer cmd, VkPipelineStageFlags2 srcStage,
+    VkAccessFlags2 srcAccess, VkPipelineStageFlags2 dstStage,
+    VkAccessFlags2 dstAccess
+)
+{
+    VkMemoryBarrier2 barrier{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+        .srcStageMask = srcStage,
+        .srcAccessMask = srcAccess,
+        .dstStageMask = dstStage,
+        .dstAccessMask = dstAccess,
+    };
+    VkDependencyInfo dependencyInfo{ .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                     .memoryBarrierCount = 1,
+                                     .pMemoryBarriers = &barrier };
+    vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+}
+} // namespace
+
+void GpuMesher::init(
+    VkDevice device, VmaAllocator allocator, VkPipelineCache pipelineCache,
+    MeshArena& arena, const GpuMesherConfig& config
+)
+{
+    PROFILE_ZONE("GpuMesher::init");
+    m_device = device;
+    m_pipelineCache = pipelineCache;
+    m_allocator = allocator;
+    m_arena = &arena;
+    m_config = config;
+
+    // chunk_mesh.comp reads uvec4 masks
+    static_assert(MAX_BLOCKS <= 4 * 32);
+    for (BlockId id = 0; id < blockCount(); id++)
+    {
+        if (isOpaque(id))
+        {
+            m_opaqueMask[id >> 5] |= 1u << (id & 31);
+        }
+        if (isTranslucent(id))
+        {
+            m_translucentMask[id >> 5] |= 1u << (id & 31);
+        }
+    }
+
+    constexpr VkBufferUsageFlags storage{
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+        VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+    };
+    // Verification reads the scratch vertices back on the host
+    const VmaAllocationCreateFlags vertexFlags{
+        m_config.verify ? VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT |
+                              VMA_ALLOCATION_CREATE_MAPPED_BIT
+                        : VmaAllocationCreateFlags{ 0 }
+    };
+    for (auto& slot : m_slots)
+    {
+        slot.voxels = createBuffer(
+            MAX_BATCH_CHUNKS * VOXELS_PER_CHUNK * sizeof(uint32_t),
+            storage,
+            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
+                VMA_ALLOCATION_CREATE_MAPPED_BIT
+        );
+        slot.vertices = createBuffer(
+            MAX_BATCH_CHUNKS * VERTICES_PER_CHUNK * sizeof(ChunkVertex),
+            storage | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            vertexFlags
+        );
+        slot.results = createBuffer(
+            MAX_BATCH_CHUNKS * sizeof(MeshResult),
+            storage | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT |
+                VMA_ALLOCATION_CREATE_MAPPED_BIT
+        );
+    }
+
+    createPipeline();
+}
+
+void GpuMesher::shutdown()
+{
+    if (!m_device)
+    {
+        return;
+    }
+
+    for (auto& slot : m_slots)
+    {
+        for (Buffer* buffer : { &slot.voxels, &slot.vertices, &slot.results })
+        {
+            vmaDestroyBuffer(m_allocator, buffer->buffer, buffer->allocation);
+            *buffer = Buffer{};
+        }
+        slot.chunks.clear();
+    }
+    vkDestroyPipeline(m_device, m_pipeline, nullptr);
+    vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+    m_device = VK_NULL_HANDLE;
+}
+
+GpuMesher::Buffer GpuMesher::createBuffer(
+    VkDeviceSize size, VkBufferUsageFlags usage, VmaAllocationCreateFlags flags
+)
+{
+    VkBufferCreateInfo bufferCI{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = size,
+        .usage = usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    VmaAllocationCreateInfo allocCI{
+        .flags = flags,
+        .usage = VMA_MEMORY_USAGE_AUTO,
+    };
+
+    Buffer buffer{};
+    VmaAllocationInfo info{};
+    if (vmaCreateBuffer(
+            m_allocator,
+            &bufferCI,
+            &allocCI,
+            &buffer.buffer,
+            &buffer.allocation,
+            &info
+        ) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to allocate GPU mesher buffer");
+    }
+    buffer.mapped = info.pMappedData;
+
+    VkBufferDeviceAddressInfo addressInfo{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+        .buffer = buffer.buffer,
+    };
+    buffer.address = vkGetBufferDeviceAddress(m_device, &addressInfo);
+    return buffer;
+}
+
+void GpuMesher::createPipeline()
+{
+    VkPushConstantRange pushConstantRange{
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(PushConstants),
+    };
+    VkPipelineLayoutCreateInfo layoutCI{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange,
+    };
+    if (vkCreatePipelineLayout(
+            m_device,
+            &layoutCI,
+            nullptr,
+            &m_pipelineLayout
+        ) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create GPU mesher layout");
+    }
+
+    VkShaderModule module = loadShaderModule(m_device, "chunk_mesh.comp.spv");
+    VkComputePipelineCreateInfo pipelineCI{
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage =
+            VkPipelineShaderStageCreateInfo{
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                // The shader derives voxel order from subgroup lanes
+                .flags =
+                    VK_PIPELINE_SHADER_STAGE_CREATE_REQUIRE_FULL_SUBGROUPS_BIT,
+                .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                .module = module,
+                .pName = "main",
+            },
+        .layout = m_pipelineLayout,
+    };
+    VkResult result = vkCreateComputePipelines(
+        m_device,
+        m_pipelineCache,
+        1,
+        &pipelineCI,
+        nullptr,
+        &m_pipeline
+    );
+    vkDestroyShaderModule(m_device, module, nullptr);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create GPU mesher pipeline");
+    }
+}
+
+bool GpuMesher::submit(
+    const ChunkCoord& coord, const ChunkNeighborhood& neighborhood
+)
+{
+    if (m_pending.size() >= MAX_BATCH_CHUNKS)
+    {
+        return false;
+    }
+
+    PendingChunk& chunk = m_pending.emplace_back();
+    chunk.coord = coord;
+    chunk.voxels.resize(VOXELS_PER_CHUNK);
+    neighborhood.pack(chunk.voxels.data());
+    if (m_config.verify)
+    {
+        meshChunk(neighborhood, chunk.reference);
+    }
+    return true;
+}
+
+void GpuMesher::record(VkCommandBuffer cmd, uint32_t frameIndex)
+{
+    PROFILE_ZONE("GpuMesher::record");
+    FrameSlot& slot = m_slots[frameIndex];
+    collect(cmd, slot);
+    if (!m_pending.empty())
+    {
+        dispatch(cmd, slot);
+    }
+}
+
+void GpuMesher::collect(VkCommandBuffer cmd, FrameSlot& slot)
+{
+    if (slot.chunks.empty())
+    {
+        return;
+    }
+
+    // The frame's fence has been waited on, so the results are final
+    vmaInvalidateAllocation(
+        m_allocator,
+        slot.results.allocation,
+        0,
+        VK_WHOLE_SIZE
+    );
+    if (m_config.verify)
+    {
+        vmaInvalidateAllocation(
+            m_allocator,
+            slot.vertices.allocation,
+            0,
+            VK_WHOLE_SIZE
+        );
+    }
+    memoryBarrier(
+        cmd,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COPY_BIT,
+        VK_ACCESS_2_TRANSFER_READ_BIT
+    );
+
+    const auto* results = static_cast<const MeshResult*>(slot.results.mapped);
+    for (size_t i = 0; i < slot.chunks.size(); i++)
+    {
+        const ChunkCoord& coord = slot.chunks[i].coord;
+        const uint32_t quadCount = results[i].quadCount;
+        if (quadCount > MAX_QUADS_PER_CHUNK)
+        {
+            m_fallbackNeighborhood.unpack(slot.chunks[i].voxels.data());
+            meshChunk(m_fallbackNeighborhood, m_fallbackMesh);
+            if (!m_arena->upload(cmd, coord, m_fallbackMesh))
+            {
+                m_refused.push_back(coord);
+            }
+            continue;
+        }
+
+        if (m_config.verify)
+        {
+            const ChunkMesh& reference = slot.chunks[i].reference;
+            const auto* vertices =
+                static_cast<const ChunkVertex*>(slot.vertices.mapped) +
+                i * VERTICES_PER_CHUNK;
+            if (quadCount != reference.quadCount() ||
+                results[i].translucentQuads != reference.translucentQuads ||
+                std::memcmp(
+                    vertices,
+                    reference.vertices.data(),
+                    reference.vertices.size() * sizeof(ChunkVertex)
+                ) != 0)
+            {
+                std::cout << "GPU mesher mismatch in chunk (" << coord.x
+                          << ", " << coord.y << ", " << coord.z
+                          << "): " << quadCount << " quads, CPU mesher "
+                          << reference.quadCount() << '\n';
+            }
+        }
+
+        VkDeviceSize offset = i * VERTICES_PER_CHUNK * sizeof(ChunkVertex);
+        if (!m_arena->copyFrom(
+                cmd,
+                coord,
+                slot.vertices.buffer,
+                offset,
+                quadCount,
+                results[i].translucentQuads
+            ))
+        {
+            m_refused.push_back(coord);
+        }
+    }
+    slot.chunks.clear();
+}
+
+void GpuMesher::dispatch(VkCommandBuffer cmd, FrameSlot& slot)
+{
+    auto* voxels = static_cast<uint32_t*>(slot.voxels.mapped);
+    for (size_t i = 0; i < m_pending.size(); i++)
+    {
+        std::memcpy(
+            voxels + i * VOXELS_PER_CHUNK,
+            m_pending[i].voxels.data(),
+            VOXELS_PER_CHUNK * sizeof(uint32_t)
+        );
+    }
+    slot.chunks = std::move(m_pending);
+    vmaFlushAllocation(m_allocator, slot.voxels.allocation, 0, VK_WHOLE_SIZE);
+
+    // The copies recorded by collect() read the scratch this overwrites
+    memoryBarrier(
+        cmd,
+        VK_PIPELINE_STAGE_2_COPY_BIT,
+        VK_ACCESS_2_NONE,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT
+    );
+
+    PushConstants pushConstants{
+        .voxels = slot.voxels.address,
+        .vertices = slot.vertices.address,
+        .results = slot.results.address,
+        .maxQuads = MAX_QUADS_PER_CHUNK,
+        .opaqueMask = m_opaqueMask,
+        .translucentMask = m_translucentMask,
+    };
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+    vkCmdPushConstants(
+        cmd,
+        m_pipelineLayout,
+        VK_SHADER_STAGE_COMPUTE_BIT,
+        0,
+        sizeof(PushConstants),
+        &pushConstants
+    );
+    vkCmdDispatch(cmd, static_cast<uint32_t>(slot.chunks.size()), 1, 1);
+    m_pending.clear();
+
+    memoryBarrier(
+        cmd,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_HOST_BIT,
+        VK_ACCESS_2_HOST_READ_BIT
+    );
+}
+
+std::vector<ChunkCoord> GpuMesher::takeRefused()
+{
+    return std::exchange(m_refused, {});
+}
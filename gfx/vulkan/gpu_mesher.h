@@ -0,0 +1,132 @@
+#pragma once
+
+#ifndef VK_NO_PROTOTYPES
+#define VK_NO_PROTOTYPES
+#endif
+
+#include <volk/volk.h>
+#include <vma/vk_mem_alloc.h>
+#include <array>
+#include <vector>
+#include "gfx/vulkan/context.h"
+#include "gfx/vulkan/mesh_arena.h"
+#include "world/mesher.h"
+
+struct GpuMesherConfig
+{
+    // Keeps a CPU-meshed reference of every chunk and compares it with the
+    // GPU output once it is back; meant for lavapipe and debugging
+    bool verify{ false };
+};
+
+// Compute-shader alternative to meshChunk(). Submitted neighbourhoods are
+// uploaded once per frame and meshed by shaders/chunk_mesh.comp into a
+// scratch buffer, one workgroup per chunk. When the frame slot comes around
+// again the quad counts are read back and each mesh is copied GPU-side into
+// an exactly sized MeshArena allocation. Meshes that do not fit the memory
+// budget are handed back through takeRefused() to be requested again.
+class GpuMesher
+{
+  public:
+    static constexpr uint32_t MAX_BATCH_CHUNKS{ 16 };
+    // Scratch space per chunk; larger meshes are handed back to the CPU
+    static constexpr uint32_t MAX_QUADS_PER_CHUNK{ 16384 };
+
+  private:
+    // Matches MeshResult in chunk_mesh.comp; the leading draw command can be
+    // consumed by vkCmdDrawIndexedIndirect with a 32 byte stride
+    struct MeshResult
+    {
+        VkDrawIndexedIndirectCommand draw;
+        uint32_t quadCount;
+        uint32_t translucentQuads;
+        uint32_t pad;
+    };
+
+    struct PushConstants
+    {
+        VkDeviceAddress voxels{ 0 };
+        VkDeviceAddress vertices{ 0 };
+        VkDeviceAddress results{ 0 };
+        uint32_t maxQuads{ 0 };
+        uint32_t pad{ 0 };
+        std::array<uint32_t, 4> opaqueMask{};
+        std::array<uint32_t, 4> translucentMask{};
+    };
+
+    struct Buffer
+    {
+        VkBuffer buffer{ VK_NULL_HANDLE };
+        VmaAllocation allocation{ VK_NULL_HANDLE };
+        VkDeviceAddress address{ 0 };
+        void* mapped{ nullptr };
+    };
+
+    struct PendingChunk
+    {
+        ChunkCoord coord;
+        // Kept until the results are back, for the CPU fallback
+        std::vector<uint32_t> voxels;
+        ChunkMesh reference;
+    };
+
+    struct FrameSlot
+    {
+        Buffer voxels;
+        Buffer vertices;
+        Buffer results;
+        std::vector<PendingChunk> chunks;
+    };
+
+    VkDevice m_device{ VK_NULL_HANDLE };
+    VmaAllocator m_allocator{ VK_NULL_HANDLE };
+    VkPipelineCache m_pipelineCache{ VK_NULL_HANDLE };
+    MeshArena* m_arena{ nullptr };
+    GpuMesherConfig m_config;
+    VkPipelineLayout m_pipelineLayout{ VK_NULL_HANDLE };
+    VkPipeline m_pipeline{ VK_NULL_HANDLE };
+    std::array<FrameSlot, MAX_FRAMES_IN_FLIGHT> m_slots;
+    std::vector<PendingChunk> m_pending;
+    ChunkNeighborhood m_fallbackNeighborhood;
+    ChunkMesh m_fallbackMesh;
+    std::vector<ChunkCoord> m_refused;
+    std::array<uint32_t, 4> m_opaqueMask{};
+    std::array<uint32_t, 4> m_translucentMask{};
+
+    Buffer createBuffer(
+        VkDeviceSize size, VkBufferUsageFlags usage,
+        VmaAllocationCreateFlags flags
+    );
+    void createPipeline();
+    void collect(VkCommandBuffer cmd, FrameSlot& slot);
+    void dispatch(VkCommandBuffer cmd, FrameSlot& slot);
+
+  public:
+    GpuMesher() = default;
+    ~GpuMesher()
+    {
+        shutdown();
+    }
+    GpuMesher(const GpuMesher&) = delete;
+    GpuMesher& operator=(const GpuMesher&) = delete;
+
+    // Requires subgroup arithmetic in compute shaders
+    void init(
+        VkDevice device, VmaAllocator allocator, VkPipelineCache pipelineCache,
+        MeshArena& arena, const GpuMesherConfig& config = {}
+    );
+    void shutdown();
+
+    // Queues a chunk for the next dispatch; false when this frame's batch
+    // is already full and the chunk should be retried or meshed on the CPU
+    bool submit(const ChunkCoord& coord, const ChunkNeighborhood& neighborhood);
+
+    // Uploads the meshes finished by the slot's previous dispatch and
+    // dispatches everything submitted since; call after the frame's fence.
+    // Chunks that overflowed the scratch space are meshed on the CPU here.
+    void record(VkCommandBuffer cmd, uint32_t frameIndex);
+
+    // Chunks whose meshes the arena refused since the last call; their
+    // previous meshes, if any, are still in place
+    std::vector<ChunkCoord> takeRefused();
+};
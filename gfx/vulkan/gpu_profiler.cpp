@@ -0,0 +1,270 @@
+#include <SDL3/SDL.h>
+#include <array>
+#include <iostream>
+#include <stdexcept>
+#include "gpu_profiler.h"
+
+void GpuProfiler::init(
+    VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily,
+    uint32_t frameCount, bool calibratedTimestamps
+)
+{
+    // GPU zones compile out in release builds, which leave the profiler
+    // inert
+#ifdef PROFILING_ENABLED
+    m_device = device;
+
+    uint32_t queueFamilyCount{ 0 };
+    vkGetPhysicalDeviceQueueFamilyProperties(
+        physicalDevice,
+        &queueFamilyCount,
+        nullptr
+    );
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(
+        physicalDevice,
+        &queueFamilyCount,
+        queueFamilies.data()
+    );
+    uint32_t validBits = queueFamilies[queueFamily].timestampValidBits;
+    if (validBits == 0)
+    {
+        std::cout << "GPU profiler disabled: queue has no timestamps\n";
+        return;
+    }
+    m_timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    m_nsPerTick = properties.limits.timestampPeriod;
+
+    if (calibratedTimestamps)
+    {
+        uint32_t domainCount{ 0 };
+        vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(
+            physicalDevice,
+            &domainCount,
+            nullptr
+        );
+        std::vector<VkTimeDomainEXT> domains(domainCount);
+        vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(
+            physicalDevice,
+            &domainCount,
+            domains.data()
+        );
+
+        bool hasDevice{ false };
+        for (auto domain : domains)
+        {
+            hasDevice |= domain == VK_TIME_DOMAIN_DEVICE_EXT;
+            // Must match the clock behind Profiler::nowNs
+            if (domain == VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT ||
+                domain == VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT)
+            {
+                m_hostDomain = domain;
+            }
+        }
+        m_calibrated = hasDevice && m_hostDomain != VK_TIME_DOMAIN_DEVICE_EXT;
+    }
+
+    VkQueryPoolCreateInfo queryPoolCI{
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = MAX_QUERIES_PER_FRAME * frameCount,
+    };
+    if (vkCreateQueryPool(m_device, &queryPoolCI, nullptr, &m_queryPool) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create timestamp query pool");
+    }
+
+    m_frames.resize(frameCount);
+    m_results.resize(MAX_QUERIES_PER_FRAME);
+
+    std::cout << "GPU profiler: " << (m_calibrated ? "calibrated" : "approx")
+              << " timestamps\n";
+#else
+    (void)physicalDevice;
+    (void)device;
+    (void)queueFamily;
+    (void)frameCount;
+    (void)calibratedTimestamps;
+#endif
+}
+
+void GpuProfiler::shutdown()
+{
+    if (m_queryPool)
+    {
+        vkDestroyQueryPool(m_device, m_queryPool, nullptr);
+        m_queryPool = VK_NULL_HANDLE;
+    }
+}
+
+uint64_t GpuProfiler::hostTicksToNs(uint64_t ticks) const
+{
+    if (m_hostDomain == VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT)
+    {
+        // SDL's performance counter is QPC on Windows
+        double frequency =
+            static_cast<double>(SDL_GetPerformanceFrequency());
+        return static_cast<uint64_t>(ticks * (1e9 / frequency));
+    }
+    return ticks;
+}
+
+void GpuProfiler::readBack(FrameQueries& frame)
+{
+    if (frame.queryCount == 0)
+    {
+        return;
+    }
+
+    uint32_t base = m_frameIndex * MAX_QUERIES_PER_FRAME;
+    if (vkGetQueryPoolResults(
+            m_device,
+            m_queryPool,
+            base,
+            frame.queryCount,
+            frame.queryCount * sizeof(uint64_t),
+            m_results.data(),
+            sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT
+        ) != VK_SUCCESS)
+    {
+        return;
+    }
+
+    // Reference point mapping a GPU tick onto the host clock
+    uint64_t referenceTicks = m_results[0] & m_timestampMask;
+    double referenceNs = static_cast<double>(frame.submitNs);
+    if (m_calibrated)
+    {
+        std::array<VkCalibratedTimestampInfoEXT, 2> infos{
+            VkCalibratedTimestampInfoEXT{
+                .sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT,
+                .timeDomain = VK_TIME_DOMAIN_DEVICE_EXT,
+            },
+            VkCalibratedTimestampInfoEXT{
+                .sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT,
+                .timeDomain = m_hostDomain,
+            },
+        };
+        std::array<uint64_t, 2> timestamps{};
+        uint64_t maxDeviation{ 0 };
+        if (vkGetCalibratedTimestampsEXT(
+                m_device,
+                static_cast<uint32_t>(infos.size()),
+                infos.data(),
+                timestamps.data(),
+                &maxDeviation
+            ) == VK_SUCCESS)
+        {
+            referenceTicks = timestamps[0] & m_timestampMask;
+            referenceNs = static_cast<double>(hostTicksToNs(timestamps[1]));
+        }
+    }
+
+    auto toHostNs = [&](uint64_t ticks) {
+        // Signed distance so timestamps before the reference work too
+        int64_t delta = static_cast<int64_t>(
+            ((ticks & m_timestampMask) - referenceTicks) & m_timestampMask
+        );
+        if (m_timestampMask != ~0ull && delta > int64_t(m_timestampMask >> 1))
+        {
+            delta -= static_cast<int64_t>(m_timestampMask) + 1;
+        }
+        return static_cast<uint64_t>(referenceNs + delta * m_nsPerTick);
+    };
+
+    m_events.clear();
+    for (const auto& zone : frame.zones)
+    {
+        if (zone.endQuery == NO_ZONE)
+        {
+            continue;
+        }
+        m_events.push_back(ProfileEvent{
+            .name = zone.name,
+            .startNs = toHostNs(m_results[zone.beginQuery]),
+            .endNs = toHostNs(m_results[zone.endQuery]),
+        });
+    }
+    Profiler::get().addGpuEvents(m_events);
+}
+
+void GpuProfiler::beginFrame(VkCommandBuffer cmd, uint32_t frameIndex)
+{
+    if (!m_queryPool)
+    {
+        return;
+    }
+
+    m_frameIndex = frameIndex;
+    FrameQueries& frame = m_frames[m_frameIndex];
+    readBack(frame);
+    frame.zones.clear();
+    frame.queryCount = 0;
+
+    vkCmdResetQueryPool(
+        cmd,
+        m_queryPool,
+        m_frameIndex * MAX_QUERIES_PER_FRAME,
+        MAX_QUERIES_PER_FRAME
+    );
+}
+
+void GpuProfiler::markSubmitted()
+{
+    if (m_queryPool)
+    {
+        m_frames[m_frameIndex].submitNs = Profiler::nowNs();
+    }
+}
+
+uint32_t GpuProfiler::beginZone(VkCommandBuffer cmd, const char* name)
+{
+    if (!m_queryPool)
+    {
+        return NO_ZONE;
+    }
+    FrameQueries& frame = m_frames[m_frameIndex];
+    if (frame.queryCount + 2 > MAX_QUERIES_PER_FRAME)
+    {
+        return NO_ZONE;
+    }
+
+    // Both queries are reserved up front so nested zones cannot overflow
+    uint32_t query = frame.queryCount;
+    frame.queryCount += 2;
+    vkCmdWriteTimestamp2(
+        cmd,
+        VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT,
+        m_queryPool,
+        m_frameIndex * MAX_QUERIES_PER_FRAME + query
+    );
+    frame.zones.push_back(Zone{ .name = name, .beginQuery = query });
+    return static_cast<uint32_t>(frame.zones.size() - 1);
+}
+
+void GpuProfiler::endZone(VkCommandBuffer cmd, uint32_t zone)
+{
+    if (zone == NO_ZONE)
+    {
+        return;
+    }
+    FrameQueries& frame = m_frames[m_frameIndex];
+    uint32_t query = frame.zones[zone].beginQuery + 1;
+    vkCmdWriteTimestamp2(
+        cmd,
+        VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT,
+        m_queryPool,
+        m_frameIndex * MAX_QUERIES_PER_FRAME + query
+    );
+    frame.zones[zone].endQuery = query;
+}
+
+bool GpuProfiler::isCalibrated() const
+{
+    return m_calibrated;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#ifndef VK_NO_PROTOTYPES
+#define VK_NO_PROTOTYPES
+#endif
+
+#include <volk/volk.h>
+#include <cstdint>
+#include <vector>
+#include "core/profiling/profiler.h"
+
+// GPU zones recorded with vkCmdWriteTimestamp2. Results are read back when
+// a frame slot is reused and handed to the CPU profiler on its GPU track.
+// With VK_EXT_calibrated_timestamps the GPU clock is mapped onto the host
+// clock exactly; otherwise each frame is pinned to its submit time.
+class GpuProfiler
+{
+  private:
+    static constexpr uint32_t MAX_QUERIES_PER_FRAME{ 256 };
+    static constexpr uint32_t NO_ZONE{ UINT32_MAX };
+
+    struct Zone
+    {
+        const char* name{ nullptr };
+        uint32_t beginQuery{ 0 };
+        uint32_t endQuery{ NO_ZONE };
+    };
+
+    struct FrameQueries
+    {
+        std::vector<Zone> zones;
+        uint32_t queryCount{ 0 };
+        uint64_t submitNs{ 0 };
+    };
+
+    VkDevice m_device{ VK_NULL_HANDLE };
+    VkQueryPool m_queryPool{ VK_NULL_HANDLE };
+    std::vector<FrameQueries> m_frames;
+    uint32_t m_frameIndex{ 0 };
+
+    double m_nsPerTick{ 1.0 };
+    uint64_t m_timestampMask{ ~0ull };
+    bool m_calibrated{ false };
+    VkTimeDomainEXT m_hostDomain{ VK_TIME_DOMAIN_DEVICE_EXT };
+
+    std::vector<uint64_t> m_results;
+    std::vector<ProfileEvent> m_events;
+
+    uint64_t hostTicksToNs(uint64_t ticks) const;
+    void readBack(FrameQueries& frame);
+
+  public:
+    GpuProfiler() = default;
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    void init(
+        VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily,
+        uint32_t frameCount, bool calibratedTimestamps
+    );
+    void shutdown();
+
+    // Reads back the slot's previous results (its fence must have been
+    // waited on) and resets its queries
+    void beginFrame(VkCommandBuffer cmd, uint32_t frameIndex);
+    void markSubmitted();
+
+    uint32_t beginZone(VkCommandBuffer cmd, const char* name);
+    void endZone(VkCommandBuffer cmd, uint32_t zone);
+
+    bool isCalibrated() const;
+};
+
+class GpuProfileZone
+{
+  private:
+    GpuProfiler& m_profiler;
+    VkCommandBuffer m_cmd;
+    uint32_t m_zone;
+
+  public:
+    GpuProfileZone(GpuProfiler& profiler, VkCommandBuffer cmd, const char* name)
+        : m_profiler(profiler), m_cmd(cmd),
+          m_zone(profiler.beginZone(cmd, name))
+    {
+    }
+    ~GpuProfileZone()
+    {
+        m_profiler.endZone(m_cmd, m_zone);
+    }
+    GpuProfileZone(const GpuProfileZone&) = delete;
+    GpuProfileZone& operator=(const GpuProfileZone&) = delete;
+};
+
+#ifdef PROFILING_ENABLED
+#define PROFILE_GPU_ZONE(profiler, cmd, name)                                  \
+    GpuProfileZone PROFILE_CONCAT(gpuProfileZone, __LINE__)(profiler, cmd, name)
+#else
+#define PROFILE_GPU_ZONE(profiler, cmd, name)
+#endif
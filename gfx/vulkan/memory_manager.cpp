@@ -0,0 +1,111 @@
+#include "memory_manager.h"
+#include "gfx/vulkan/mesh_arena.h"
+#include "core/profiling/profiler.h"
+
+void GpuMemoryManager::init(VmaAllocator allocator, MeshArena& meshArena)
+{
+    m_allocator = allocator;
+    m_meshArena = &meshArena;
+
+    const VkPhysicalDeviceMemoryProperties* memoryProperties{ nullptr };
+    vmaGetMemoryProperties(m_allocator, &memoryProperties);
+    for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; i++)
+    {
+        if (memoryProperties->memoryHeaps[i].flags &
+            VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+        {
+            m_deviceHeapMask |= 1u << i;
+        }
+    }
+}
+
+void GpuMemoryManager::track(MemoryCategory category, int64_t bytes)
+{
+    m_categoryBytes[static_cast<size_t>(category)].fetch_add(
+        static_cast<uint64_t>(bytes),
+        std::memory_order_relaxed
+    );
+}
+
+void GpuMemoryManager::setEvictionHandler(
+    std::function<void(uint64_t bytesToFree)> handler
+)
+{
+    m_evictionHandler = std::move(handler);
+}
+
+void GpuMemoryManager::update(VkCommandBuffer cmd)
+{
+    PROFILE_ZONE("GpuMemoryManager::update");
+
+    // Budgets are refreshed by VMA when the frame index changes
+    vmaSetCurrentFrameIndex(m_allocator, ++m_frameIndex);
+
+    std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets{};
+    vmaGetHeapBudgets(m_allocator, budgets.data());
+
+    m_stats.usage = 0;
+    m_stats.budget = 0;
+    m_reservedBytes = 0;
+    const uint64_t refused = m_refusedBytes;
+    m_refusedBytes = 0;
+    for (uint32_t i = 0; i < VK_MAX_MEMORY_HEAPS; i++)
+    {
+        if (m_deviceHeapMask & (1u << i))
+        {
+            m_stats.usage += budgets[i].usage;
+            m_stats.budget += budgets[i].budget;
+        }
+    }
+    for (size_t i = 0; i < m_categoryBytes.size(); i++)
+    {
+        m_stats.categoryBytes[i] =
+            m_categoryBytes[i].load(std::memory_order_relaxed);
+    }
+
+    m_releasingAtSample = m_meshArena->releasingBytes();
+    m_retiredAtSample = m_meshArena->retiredBytes();
+
+    // Usage once pending releases land, plus what was turned away
+    const uint64_t demand = settledUsage() + refused;
+    auto threshold = static_cast<uint64_t>(m_stats.budget * EVICT_THRESHOLD);
+    if (demand > threshold && m_evictionHandler)
+    {
+        auto target = static_cast<uint64_t>(m_stats.budget * EVICT_TARGET);
+        m_evictionHandler(demand - target);
+    }
+
+    m_meshArena->defragmentStep(cmd);
+}
+
+uint64_t GpuMemoryManager::settledUsage() const
+{
+    const uint64_t removed = m_releasingAtSample +
+                             (m_meshArena->retiredBytes() - m_retiredAtSample);
+    return m_stats.usage > removed ? m_stats.usage - removed : 0;
+}
+
+bool GpuMemoryManager::reserve(uint64_t bytes)
+{
+    if (m_stats.budget != 0 &&
+        settledUsage() + m_reservedBytes + bytes >
+            static_cast<uint64_t>(m_stats.budget * EVICT_THRESHOLD))
+    {
+        m_refusedBytes += bytes;
+        return false;
+    }
+    m_reservedBytes += bytes;
+    return true;
+}
+
+bool GpuMemoryManager::hasHeadroom() const
+{
+    return m_stats.budget == 0 ||
+           settledUsage() + m_reservedBytes <
+               static_cast<uint64_t>(m_stats.budget * EVICT_TARGET);
+}
+
+const MemoryStats& GpuMemoryManager::stats() const
+{
+    return m_stats;
+}
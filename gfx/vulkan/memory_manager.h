@@ -0,0 +1,88 @@
+#pragma once
+
+#ifndef VK_NO_PROTOTYPES
+#define VK_NO_PROTOTYPES
+#endif
+
+#include <volk/volk.h>
+#include <vma/vk_mem_alloc.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+class MeshArena;
+
+enum class MemoryCategory : uint8_t
+{
+    Meshes,
+    Textures,
+    Staging,
+    Count,
+};
+
+constexpr size_t MEMORY_CATEGORY_COUNT{
+    static_cast<size_t>(MemoryCategory::Count)
+};
+
+struct MemoryStats
+{
+    // Summed over device-local heaps
+    uint64_t usage{ 0 };
+    uint64_t budget{ 0 };
+    std::array<uint64_t, MEMORY_CATEGORY_COUNT> categoryBytes{};
+};
+
+// Watches VMA heap budgets once per frame. Systems report their own
+// allocations per category; when device-local usage approaches the budget
+// the eviction handler is asked to free memory, so streaming backs off
+// instead of running into VK_ERROR_OUT_OF_DEVICE_MEMORY. Also drives the
+// mesh arena's incremental defragmentation.
+class GpuMemoryManager
+{
+  private:
+    // Start evicting above EVICT_THRESHOLD and free down to EVICT_TARGET,
+    // so eviction does not trigger again on the very next frame
+    static constexpr double EVICT_THRESHOLD{ 0.90 };
+    static constexpr double EVICT_TARGET{ 0.80 };
+
+    VmaAllocator m_allocator{ VK_NULL_HANDLE };
+    MeshArena* m_meshArena{ nullptr };
+    uint32_t m_deviceHeapMask{ 0 };
+    uint32_t m_frameIndex{ 0 };
+    std::array<std::atomic<uint64_t>, MEMORY_CATEGORY_COUNT> m_categoryBytes{};
+    MemoryStats m_stats;
+    // Granted by reserve() since usage was last sampled
+    uint64_t m_reservedBytes{ 0 };
+    // Refused by reserve() since then; the next update() evicts to make
+    // room for them, so refused uploads can be retried
+    uint64_t m_refusedBytes{ 0 };
+    // Arena counters when usage was sampled
+    uint64_t m_releasingAtSample{ 0 };
+    uint64_t m_retiredAtSample{ 0 };
+    std::function<void(uint64_t bytesToFree)> m_evictionHandler;
+
+    // Sampled usage minus the meshes removed but not yet freed, at sample
+    // time and since; update() and reserve() both judge pressure by this
+    uint64_t settledUsage() const;
+
+  public:
+    void init(VmaAllocator allocator, MeshArena& meshArena);
+
+    void track(MemoryCategory category, int64_t bytes);
+    void setEvictionHandler(std::function<void(uint64_t bytesToFree)> handler);
+
+    // Polls vmaGetHeapBudgets, evicts if needed and records this frame's
+    // defragmentation copies into cmd; call once per frame after the fence.
+    // Meshes evicted earlier but still in flight count as freed already, so
+    // the same overshoot is not evicted again while VMA catches up.
+    void update(VkCommandBuffer cmd);
+
+    // Whether `bytes` more device memory fits below the eviction threshold;
+    // if so they count as used until the next update() samples the budget
+    bool reserve(uint64_t bytes);
+    // Whether usage is below the level eviction frees down to, so evicted
+    // meshes can come back without triggering it again
+    bool hasHeadroom() const;
+    const MemoryStats& stats() const;
+};
@@ -0,0 +1,619 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include "mesh_arena.h"
+#include "core/profiling/profiler.h"
+
+namespace
+{
+// TRANSFER_SRC lets defragmentation copy meshes to their new location
+constexpr VkBufferUsageFlags MESH_BUFFER_USAGE{
+    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+    VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+    VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+};
+
+void copyBarrier(
+    VkCommandBuffer cmd, VkPipelineStageFlags2 dstStage,
+    VkAccessFlags2 dstAccess
+)
+{
+    VkMemoryBarrier2 barrier{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+        .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+        .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        .dstStageMask = dstStage,
+        .dstAccessMask = dstAccess,
+    };
+    VkDependencyInfo dependencyInfo{ .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                     .memoryBarrierCount = 1,
+                                     .pMemoryBarriers = &barrier };
+    vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+}
+} // namespace
+
+void MeshArena::init(
+    VkDevice device, VmaAllocator allocator, GpuMemoryManager* memory
+)
+{
+    m_device = device;
+    m_allocator = allocator;
+    m_memory = memory;
+
+    // All chunk meshes share one memory type, found with a representative
+    // buffer description
+    VkBufferCreateInfo sampleBufferCI{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = 64 * 1024,
+        .usage = MESH_BUFFER_USAGE,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    VmaAllocationCreateInfo sampleAllocCI{
+        .usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+    };
+    uint32_t memoryTypeIndex{ 0 };
+    if (vmaFindMemoryTypeIndexForBufferInfo(
+            m_allocator,
+            &sampleBufferCI,
+            &sampleAllocCI,
+            &memoryTypeIndex
+        ) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to find mesh arena memory type");
+    }
+
+    VmaPoolCreateInfo poolCI{
+        .memoryTypeIndex = memoryTypeIndex,
+    };
+    if (vmaCreatePool(m_allocator, &poolCI, &m_pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create mesh arena pool");
+    }
+}
+
+void MeshArena::shutdown()
+{
+    if (!m_pool)
+    {
+        return;
+    }
+
+    // The device is idle by now, so a pending pass can be ended right away
+    if (m_defragPassActive)
+    {
+        endDefragmentPass();
+    }
+    if (m_defragContext)
+    {
+        finishDefragmentation();
+    }
+
+    for (auto& slot : m_retired)
+    {
+        for (const auto& retired : slot)
+        {
+            vmaDestroyBuffer(m_allocator, retired.buffer, retired.allocation);
+        }
+        slot.clear();
+    }
+    m_releasingBytes = 0;
+    for (const auto& [coord, mesh] : m_meshes)
+    {
+        track(MemoryCategory::Meshes, -static_cast<int64_t>(mesh.size));
+        vmaDestroyBuffer(m_allocator, mesh.buffer, mesh.allocation);
+    }
+    m_meshes.clear();
+
+    vmaDestroyPool(m_allocator, m_pool);
+    m_pool = VK_NULL_HANDLE;
+}
+
+void MeshArena::beginFrame(uint32_t frameIndex)
+{
+    m_frameIndex = frameIndex;
+    for (const auto& retired : m_retired[m_frameIndex])
+    {
+        m_releasingBytes -= retired.meshBytes;
+        track(
+            MemoryCategory::Staging,
+            -static_cast<int64_t>(retired.stagingBytes)
+        );
+        vmaDestroyBuffer(m_allocator, retired.buffer, retired.allocation);
+    }
+    m_retired[m_frameIndex].clear();
+}
+
+void MeshArena::track(MemoryCategory category, int64_t bytes)
+{
+    if (m_memory)
+    {
+        m_memory->track(category, bytes);
+    }
+}
+
+void MeshArena::retire(
+    VkBuffer buffer, VmaAllocation allocation, VkDeviceSize stagingBytes,
+    VkDeviceSize meshBytes
+)
+{
+    m_retired[m_frameIndex].push_back(RetiredBuffer{
+        .buffer = buffer,
+        .allocation = allocation,
+        .stagingBytes = stagingBytes,
+        .meshBytes = meshBytes,
+    });
+    m_releasingBytes += meshBytes;
+}
+
+void MeshArena::retireMesh(const MeshAllocation& mesh)
+{
+    track(MemoryCategory::Meshes, -static_cast<int64_t>(mesh.size));
+    // The map node the user data points at is about to be erased or to
+    // hold the replacing mesh; a null pointer marks the allocation retired
+    // for later defragmentation passes
+    vmaSetAllocationUserData(m_allocator, mesh.allocation, nullptr);
+    m_retiredBytes += mesh.size;
+
+    // A mesh being moved by the current pass must not be freed behind
+    // VMA's back: the move becomes a destroy, and both buffers go away when
+    // the pass ends. Restarting the countdown keeps the pass open until
+    // frames drawing this mesh have finished.
+    if (m_defragPassActive)
+    {
+        for (uint32_t i = 0; i < m_defragPass.moveCount; i++)
+        {
+            VmaDefragmentationMove& move = m_defragPass.pMoves[i];
+            if (move.srcAllocation != mesh.allocation)
+            {
+                continue;
+            }
+            move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_DESTROY;
+            m_defragOldBuffers.push_back(mesh.buffer);
+            m_defragFramesLeft = MAX_FRAMES_IN_FLIGHT + 1;
+            m_defragReleasingBytes += mesh.size;
+            return;
+        }
+    }
+    retire(mesh.buffer, mesh.allocation, 0, mesh.size);
+}
+
+bool MeshArena::createMeshBuffer(VkDeviceSize size, MeshAllocation& mesh)
+{
+    VkBufferCreateInfo bufferCI{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = size,
+        .usage = MESH_BUFFER_USAGE,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    // Fail instead of oversubscribing the heap, which some drivers answer
+    // with VK_ERROR_OUT_OF_DEVICE_MEMORY and others with heavy paging
+    VmaAllocationCreateInfo allocCI{
+        .flags = VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT,
+        .pool = m_pool,
+    };
+
+    mesh = MeshAllocation{ .size = size };
+    if (vmaCreateBuffer(
+            m_allocator,
+            &bufferCI,
+            &allocCI,
+            &mesh.buffer,
+            &mesh.allocation,
+            nullptr
+        ) != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    VkBufferDeviceAddressInfo addressInfo{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+        .buffer = mesh.buffer,
+    };
+    mesh.address = vkGetBufferDeviceAddress(m_device, &addressInfo);
+    track(MemoryCategory::Meshes, static_cast<int64_t>(size));
+    return true;
+}
+
+bool MeshArena::upload(
+    VkCommandBuffer cmd, const ChunkCoord& coord, const ChunkMesh& mesh
+)
+{
+    if (mesh.vertices.empty())
+    {
+        remove(coord);
+        return true;
+    }
+
+    VkDeviceSize size = mesh.vertices.size() * sizeof(ChunkVertex);
+    if (m_memory && !m_memory->reserve(size))
+    {
+        return false;
+    }
+
+    MeshAllocation allocation{};
+    if (!createMeshBuffer(size, allocation))
+    {
+        return false;
+    }
+    allocation.quadCount = mesh.quadCount();
+    allocation.translucentQuads = mesh.translucentQuads;
+
+    // Host-visible staging copy, released with the frame that uses it
+    VkBufferCreateInfo stagingCI{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = size,
+        .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    VmaAllocationCreateInfo stagingAllocCI{
+        .flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
+                 VMA_ALLOCATION_CREATE_MAPPED_BIT |
+                 VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT,
+        .usage = VMA_MEMORY_USAGE_AUTO,
+    };
+    VkBuffer stagingBuffer{ VK_NULL_HANDLE };
+    VmaAllocation stagingAllocation{ VK_NULL_HANDLE };
+    VmaAllocationInfo stagingInfo{};
+    if (vmaCreateBuffer(
+            m_allocator,
+            &stagingCI,
+            &stagingAllocCI,
+            &stagingBuffer,
+            &stagingAllocation,
+            &stagingInfo
+        ) != VK_SUCCESS)
+    {
+        // Nothing has been recorded yet, so the mesh buffer can go now
+        track(MemoryCategory::Meshes, -static_cast<int64_t>(size));
+        vmaDestroyBuffer(m_allocator, allocation.buffer, allocation.allocation);
+        return false;
+    }
+    std::memcpy(stagingInfo.pMappedData, mesh.vertices.data(), size);
+    vmaFlushAllocation(m_allocator, stagingAllocation, 0, VK_WHOLE_SIZE);
+    track(MemoryCategory::Staging, static_cast<int64_t>(size));
+    retire(stagingBuffer, stagingAllocation, size);
+
+    commit(cmd, coord, allocation, stagingBuffer, 0);
+    return true;
+}
+
+bool MeshArena::copyFrom(
+    VkCommandBuffer cmd, const ChunkCoord& coord, VkBuffer source,
+    VkDeviceSize sourceOffset, uint32_t quadCount, uint32_t translucentQuads
+)
+{
+    if (quadCount == 0)
+    {
+        remove(coord);
+        return true;
+    }
+
+    VkDeviceSize size = VkDeviceSize{ quadCount } * 4 * sizeof(ChunkVertex);
+    if (m_memory && !m_memory->reserve(size))
+    {
+        return false;
+    }
+
+    MeshAllocation allocation{};
+    if (!createMeshBuffer(size, allocation))
+    {
+        return false;
+    }
+    allocation.quadCount = quadCount;
+    allocation.translucentQuads = translucentQuads;
+    commit(cmd, coord, allocation, source, sourceOffset);
+    return true;
+}
+
+void MeshArena::commit(
+    VkCommandBuffer cmd, const ChunkCoord& coord,
+    const MeshAllocation& allocation, VkBuffer source,
+    VkDeviceSize sourceOffset
+)
+{
+    VkBufferCopy region{
+        .srcOffset = sourceOffset,
+        .dstOffset = 0,
+        .size = allocation.size,
+    };
+    vkCmdCopyBuffer(cmd, source, allocation.buffer, 1, &region);
+
+    VkBufferMemoryBarrier2 barrier{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+        .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+        .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        .dstStageMask = VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = allocation.buffer,
+        .offset = 0,
+        .size = allocation.size,
+    };
+    VkDependencyInfo dependencyInfo{ .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                     .bufferMemoryBarrierCount = 1,
+                                     .pBufferMemoryBarriers = &barrier };
+    vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+
+    // The previous mesh may still be drawn by frames in flight
+    auto it = m_meshes.find(coord);
+    if (it != m_meshes.end())
+    {
+        retireMesh(it->second);
+        it->second = allocation;
+    }
+    else
+    {
+        it = m_meshes.emplace(coord, allocation).first;
+    }
+    // Defragmentation maps moved allocations back to their mesh through
+    // this; map nodes never move, so the pointer stays valid
+    vmaSetAllocationUserData(m_allocator, it->second.allocation, &it->second);
+    m_changed.insert(coord);
+}
+
+void MeshArena::remove(const ChunkCoord& coord)
+{
+    auto it = m_meshes.find(coord);
+    if (it == m_meshes.end())
+    {
+        return;
+    }
+    retireMesh(it->second);
+    m_meshes.erase(it);
+    m_changed.insert(coord);
+}
+
+VkDeviceSize MeshArena::evictFarthest(
+    const ChunkCoord& center, VkDeviceSize bytes,
+    std::vector<ChunkCoord>* evicted
+)
+{
+    PROFILE_ZONE("MeshArena::evictFarthest");
+
+    std::vector<std::pair<int64_t, ChunkCoord>> candidates;
+    candidates.reserve(m_meshes.size());
+    for (const auto& [coord, mesh] : m_meshes)
+    {
+        const glm::ivec3 d = coord - center;
+        candidates.emplace_back(
+            int64_t{ d.x } * d.x + int64_t{ d.y } * d.y + int64_t{ d.z } * d.z,
+            coord
+        );
+    }
+    std::sort(
+        candidates.begin(),
+        candidates.end(),
+        [](const auto& a, const auto& b) { return a.first > b.first; }
+    );
+
+    VkDeviceSize freed{ 0 };
+    for (const auto& [distance, coord] : candidates)
+    {
+        if (freed >= bytes)
+        {
+            break;
+        }
+        freed += m_meshes.at(coord).size;
+        remove(coord);
+        if (evicted)
+        {
+            evicted->push_back(coord);
+        }
+    }
+    return freed;
+}
+
+VkDeviceSize MeshArena::releasingBytes() const
+{
+    return m_releasingBytes + m_defragReleasingBytes;
+}
+
+VkDeviceSize MeshArena::retiredBytes() const
+{
+    return m_retiredBytes;
+}
+
+void MeshArena::defragmentStep(VkCommandBuffer cmd)
+{
+    PROFILE_ZONE("MeshArena::defragmentStep");
+
+    if (m_defragPassActive)
+    {
+        if (--m_defragFramesLeft == 0)
+        {
+            endDefragmentPass();
+        }
+        return;
+    }
+
+    if (!m_defragContext)
+    {
+        VmaStatistics stats{};
+        vmaGetPoolStatistics(m_allocator, m_pool, &stats);
+        if (stats.blockBytes < DEFRAG_MIN_POOL_BYTES ||
+            stats.allocationBytes >=
+                static_cast<VkDeviceSize>(
+                    stats.blockBytes * DEFRAG_MAX_OCCUPANCY
+                ))
+        {
+            return;
+        }
+
+        VmaDefragmentationInfo defragInfo{
+            .flags = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT,
+            .pool = m_pool,
+            .maxBytesPerPass = DEFRAG_BYTES_PER_PASS,
+            .maxAllocationsPerPass = DEFRAG_ALLOCATIONS_PER_PASS,
+        };
+        if (vmaBeginDefragmentation(
+                m_allocator,
+                &defragInfo,
+                &m_defragContext
+            ) != VK_SUCCESS)
+        {
+            return;
+        }
+    }
+
+    beginDefragmentPass(cmd);
+}
+
+void MeshArena::destroyWithPass(VmaAllocation allocation)
+{
+    for (auto& slot : m_retired)
+    {
+        for (auto it = slot.begin(); it != slot.end(); ++it)
+        {
+            if (it->allocation != allocation)
+            {
+                continue;
+            }
+            m_defragOldBuffers.push_back(it->buffer);
+            m_releasingBytes -= it->meshBytes;
+            m_defragReleasingBytes += it->meshBytes;
+            slot.erase(it);
+            return;
+        }
+    }
+}
+
+void MeshArena::beginDefragmentPass(VkCommandBuffer cmd)
+{
+    m_defragPass = VmaDefragmentationPassMoveInfo{};
+    if (vmaBeginDefragmentationPass(
+            m_allocator,
+            m_defragContext,
+            &m_defragPass
+        ) == VK_SUCCESS)
+    {
+        // Nothing left to move
+        finishDefragmentation();
+        return;
+    }
+
+    // Uploads earlier in this command buffer may have written the sources
+    copyBarrier(
+        cmd,
+        VK_PIPELINE_STAGE_2_COPY_BIT,
+        VK_ACCESS_2_TRANSFER_READ_BIT
+    );
+
+    for (uint32_t i = 0; i < m_defragPass.moveCount; i++)
+    {
+        VmaDefragmentationMove& move = m_defragPass.pMoves[i];
+        VmaAllocationInfo info{};
+        vmaGetAllocationInfo(m_allocator, move.srcAllocation, &info);
+        auto* mesh = static_cast<MeshAllocation*>(info.pUserData);
+        if (!mesh)
+        {
+            // Retired, so nothing needs the contents. VMA frees the memory
+            // when the pass ends, which is also when the buffer goes;
+            // frames that drew the mesh have finished by then.
+            move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_DESTROY;
+            destroyWithPass(move.srcAllocation);
+            continue;
+        }
+
+        VkBufferCreateInfo bufferCI{
+            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            .size = mesh->size,
+            .usage = MESH_BUFFER_USAGE,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        };
+        VkBuffer newBuffer{ VK_NULL_HANDLE };
+        if (vkCreateBuffer(m_device, &bufferCI, nullptr, &newBuffer) !=
+            VK_SUCCESS)
+        {
+            move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+            continue;
+        }
+        if (vmaBindBufferMemory(
+                m_allocator,
+                move.dstTmpAllocation,
+                newBuffer
+            ) != VK_SUCCESS)
+        {
+            vkDestroyBuffer(m_device, newBuffer, nullptr);
+            move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+            continue;
+        }
+
+        VkBufferCopy region{
+            .srcOffset = 0,
+            .dstOffset = 0,
+            .size = mesh->size,
+        };
+        vkCmdCopyBuffer(cmd, mesh->buffer, newBuffer, 1, &region);
+
+        // Draws from this frame on read the new copy; the old buffer stays
+        // alive for frames already in flight
+        m_defragOldBuffers.push_back(mesh->buffer);
+        mesh->buffer = newBuffer;
+        VkBufferDeviceAddressInfo addressInfo{
+            .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+            .buffer = newBuffer,
+        };
+        mesh->address = vkGetBufferDeviceAddress(m_device, &addressInfo);
+    }
+
+    copyBarrier(
+        cmd,
+        VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT |
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT
+    );
+
+    m_defragPassActive = true;
+    m_defragFramesLeft = MAX_FRAMES_IN_FLIGHT + 1;
+}
+
+void MeshArena::endDefragmentPass()
+{
+    for (VkBuffer buffer : m_defragOldBuffers)
+    {
+        vkDestroyBuffer(m_device, buffer, nullptr);
+    }
+    m_defragOldBuffers.clear();
+    m_defragPassActive = false;
+    m_defragReleasingBytes = 0;
+
+    // Moved allocations now own the new memory, so the handles stored in
+    // the meshes stay valid
+    if (vmaEndDefragmentationPass(
+            m_allocator,
+            m_defragContext,
+            &m_defragPass
+        ) == VK_SUCCESS)
+    {
+        finishDefragmentation();
+    }
+}
+
+void MeshArena::finishDefragmentation()
+{
+    VmaDefragmentationStats stats{};
+    vmaEndDefragmentation(m_allocator, m_defragContext, &stats);
+    m_defragContext = VK_NULL_HANDLE;
+    std::cout << "Mesh arena defragmented: moved " << stats.bytesMoved
+              << " bytes, freed " << stats.bytesFreed << " bytes\n";
+}
+
+const MeshAllocation* MeshArena::find(const ChunkCoord& coord) const
+{
+    auto it = m_meshes.find(coord);
+    return it != m_meshes.end() ? &it->second : nullptr;
+}
+
+std::vector<ChunkCoord> MeshArena::takeChangedChunks()
+{
+    std::vector<ChunkCoord> changed(m_changed.begin(), m_changed.end());
+    m_changed.clear();
+    return changed;
+}
+
+size_t MeshArena::meshCount() const
+{
+    return m_meshes.size();
+}
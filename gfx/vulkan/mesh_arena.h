@@ -0,0 +1,161 @@
+#pragma once
+
+#ifndef VK_NO_PROTOTYPES
+#define VK_NO_PROTOTYPES
+#endif
+
+#include <volk/volk.h>
+#include <vma/vk_mem_alloc.h>
+#include <array>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "gfx/vulkan/context.h"
+#include "gfx/vulkan/memory_manager.h"
+#include "world/mesher.h"
+
+struct MeshAllocation
+{
+    VkBuffer buffer{ VK_NULL_HANDLE };
+    VmaAllocation allocation{ VK_NULL_HANDLE };
+    VkDeviceAddress address{ 0 };
+    VkDeviceSize size{ 0 };
+    uint32_t quadCount{ 0 };
+    // Trailing quads drawn by the transparency pass; see ChunkMesh
+    uint32_t translucentQuads{ 0 };
+
+    uint32_t opaqueQuads() const
+    {
+        return quadCount - translucentQuads;
+    }
+};
+
+// Device-local storage for chunk meshes (vertices with packed smooth light).
+// Each chunk gets its own buffer from a dedicated VMA pool and is drawn by
+// pulling vertices through the buffer's device address, so meshes can be
+// replaced independently without rebinding anything.
+//
+// Allocations stay within the heap budget: when the pool cannot grow,
+// upload() fails softly and the caller evicts distant meshes. The pool is
+// compacted with incremental VMA defragmentation, a few megabytes per pass.
+class MeshArena
+{
+  private:
+    struct RetiredBuffer
+    {
+        VkBuffer buffer{ VK_NULL_HANDLE };
+        VmaAllocation allocation{ VK_NULL_HANDLE };
+        VkDeviceSize stagingBytes{ 0 };
+        VkDeviceSize meshBytes{ 0 };
+    };
+
+    // Defragment once the pool is large enough to matter and less than
+    // this fraction of its blocks is in use
+    static constexpr VkDeviceSize DEFRAG_MIN_POOL_BYTES{ 64ull << 20 };
+    static constexpr double DEFRAG_MAX_OCCUPANCY{ 0.7 };
+    static constexpr VkDeviceSize DEFRAG_BYTES_PER_PASS{ 8ull << 20 };
+    static constexpr uint32_t DEFRAG_ALLOCATIONS_PER_PASS{ 256 };
+
+    VkDevice m_device{ VK_NULL_HANDLE };
+    VmaAllocator m_allocator{ VK_NULL_HANDLE };
+    VmaPool m_pool{ VK_NULL_HANDLE };
+    GpuMemoryManager* m_memory{ nullptr };
+    std::unordered_map<ChunkCoord, MeshAllocation, ChunkCoordHash> m_meshes;
+    std::unordered_set<ChunkCoord, ChunkCoordHash> m_changed;
+
+    // Buffers the GPU may still be reading, released once the same frame
+    // slot comes around again
+    std::array<std::vector<RetiredBuffer>, MAX_FRAMES_IN_FLIGHT> m_retired;
+    uint32_t m_frameIndex{ 0 };
+    // Mesh bytes removed from the arena but not yet given back to VMA, and
+    // all mesh bytes ever removed
+    VkDeviceSize m_releasingBytes{ 0 };
+    VkDeviceSize m_retiredBytes{ 0 };
+
+    // Incremental defragmentation. A pass records its copies in one frame
+    // and is ended once no frame in flight can still read the old buffers.
+    VmaDefragmentationContext m_defragContext{ VK_NULL_HANDLE };
+    VmaDefragmentationPassMoveInfo m_defragPass{};
+    std::vector<VkBuffer> m_defragOldBuffers;
+    uint32_t m_defragFramesLeft{ 0 };
+    bool m_defragPassActive{ false };
+    // Removed meshes whose memory goes away when the pass ends
+    VkDeviceSize m_defragReleasingBytes{ 0 };
+
+    bool createMeshBuffer(VkDeviceSize size, MeshAllocation& mesh);
+    void retire(
+        VkBuffer buffer, VmaAllocation allocation,
+        VkDeviceSize stagingBytes = 0, VkDeviceSize meshBytes = 0
+    );
+    void retireMesh(const MeshAllocation& mesh);
+    // Records the copy into a new allocation and makes it the chunk's mesh
+    void commit(
+        VkCommandBuffer cmd, const ChunkCoord& coord,
+        const MeshAllocation& allocation, VkBuffer source,
+        VkDeviceSize sourceOffset
+    );
+    void beginDefragmentPass(VkCommandBuffer cmd);
+    // Hands a retired allocation picked as a move source over to the pass,
+    // so the frame slot does not free it while the move is pending
+    void destroyWithPass(VmaAllocation allocation);
+    void endDefragmentPass();
+    void finishDefragmentation();
+    void track(MemoryCategory category, int64_t bytes);
+
+  public:
+    MeshArena() = default;
+    ~MeshArena()
+    {
+        shutdown();
+    }
+    MeshArena(const MeshArena&) = delete;
+    MeshArena& operator=(const MeshArena&) = delete;
+
+    void init(
+        VkDevice device, VmaAllocator allocator,
+        GpuMemoryManager* memory = nullptr
+    );
+    void shutdown();
+
+    // Call after the frame's fence has been waited on
+    void beginFrame(uint32_t frameIndex);
+
+    // Records the staging copy into cmd; empty meshes just free the chunk.
+    // Returns false when the mesh does not fit in the memory budget, in
+    // which case the previous mesh (if any) is kept.
+    bool upload(
+        VkCommandBuffer cmd, const ChunkCoord& coord, const ChunkMesh& mesh
+    );
+    // Same as upload() for a mesh that is already on the GPU, e.g. written
+    // by the compute mesher; the source must stay valid until the copy ran
+    bool copyFrom(
+        VkCommandBuffer cmd, const ChunkCoord& coord, VkBuffer source,
+        VkDeviceSize sourceOffset, uint32_t quadCount,
+        uint32_t translucentQuads
+    );
+    void remove(const ChunkCoord& coord);
+
+    // Frees meshes farthest from center until `bytes` have been released;
+    // returns the number of bytes actually freed. The chunks are appended
+    // to `evicted` so they can be remeshed once there is room again.
+    VkDeviceSize evictFarthest(
+        const ChunkCoord& center, VkDeviceSize bytes,
+        std::vector<ChunkCoord>* evicted = nullptr
+    );
+    // Bytes of removed meshes that frames in flight may still read; VMA's
+    // usage only drops once they are released
+    VkDeviceSize releasingBytes() const;
+    // Running total of removed mesh bytes, for measuring removals between
+    // two points in time
+    VkDeviceSize retiredBytes() const;
+
+    // Starts defragmenting when the pool is sparse, and advances a running
+    // defragmentation by at most one pass; call once per frame
+    void defragmentStep(VkCommandBuffer cmd);
+
+    const MeshAllocation* find(const ChunkCoord& coord) const;
+    // Chunks whose mesh was replaced or removed since the last call, for
+    // caches rendered from the meshes; defragmentation moves do not count
+    std::vector<ChunkCoord> takeChangedChunks();
+    size_t meshCount() const;
+};
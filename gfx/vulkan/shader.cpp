@@ -0,0 +1,35 @@
+#include <volk/volk.h>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+#include "shader.h"
+
+VkShaderModule loadShaderModule(VkDevice device, const std::string& name)
+{
+    const std::string path = std::string(SHADER_BINARY_DIR) + "/" + name;
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        throw std::runtime_error("failed to open shader " + path);
+    }
+
+    // SPIR-V is a stream of 32-bit words
+    std::vector<uint32_t> code(static_cast<size_t>(file.tellg()) / 4);
+    file.seekg(0);
+    file.read(
+        reinterpret_cast<char*>(code.data()),
+        static_cast<std::streamsize>(code.size() * 4)
+    );
+
+    VkShaderModuleCreateInfo moduleCI{
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .codeSize = code.size() * 4,
+        .pCode = code.data(),
+    };
+    VkShaderModule module{ VK_NULL_HANDLE };
+    if (vkCreateShaderModule(device, &moduleCI, nullptr, &module) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create shader module " + path);
+    }
+    return module;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <volk/volk.h>
+#include <string>
+
+// Loads a SPIR-V binary compiled into SHADER_BINARY_DIR by the build
+VkShaderModule loadShaderModule(VkDevice device, const std::string& name);
@@ -0,0 +1,817 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <glm/gtc/matrix_transform.hpp>
+#include "shadow_cascades.h"
+#include "core/profiling/profiler.h"
+#include "gfx/vulkan/shader.h"
+
+namespace
+{
+constexpr uint32_t VERTICES_PER_QUAD{ 6 };
+
+// Rounds towards negative infinity, unlike integer division
+glm::ivec2 floorDiv(glm::ivec2 value, int32_t divisor)
+{
+    auto floorDiv1 = [divisor](int32_t v) {
+        return v >= 0 ? v / divisor : -((-v + divisor - 1) / divisor);
+    };
+    return { floorDiv1(value.x), floorDiv1(value.y) };
+}
+
+void imageBarrier(
+    VkCommandBuffer cmd, VkImage image, uint32_t layerCount,
+    VkImageLayout oldLayout, VkImageLayout newLayout,
+    VkPipelineStageFlags2 srcStage, VkAccessFlags2 srcAccess,
+    VkPipelineStageFlags2 dstStage, VkAccessFlags2 dstAccess
+)
+{
+    VkImageMemoryBarrier2 barrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .srcStageMask = srcStage,
+        .srcAccessMask = srcAccess,
+        .dstStageMask = dstStage,
+        .dstAccessMask = dstAccess,
+        .oldLayout = oldLayout,
+        .newLayout = newLayout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = image,
+        .subresourceRange = { .aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
+                              .levelCount = 1,
+                              .layerCount = layerCount },
+    };
+    VkDependencyInfo dependencyInfo{ .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                     .imageMemoryBarrierCount = 1,
+                                     .pImageMemoryBarriers = &barrier };
+    vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+}
+} // namespace
+
+void ShadowCascades::init(
+    VkDevice device, VmaAllocator allocator, VkPipelineCache pipelineCache
+)
+{
+    PROFILE_ZONE("ShadowCascades::init");
+    m_device = device;
+    m_allocator = allocator;
+
+    for (uint32_t i = 0; i < CASCADE_COUNT; i++)
+    {
+        m_cascades[i].texelSize = SPANS[i] / RESOLUTION;
+    }
+    m_sunDirection = glm::normalize(m_sunDirection);
+    m_lightView = glm::lookAt(
+        glm::vec3(0.0f),
+        -m_sunDirection,
+        glm::vec3(0.0f, 1.0f, 0.0f)
+    );
+
+    createImage();
+    createDescriptors();
+    createPipeline(pipelineCache);
+    for (auto& frame : m_frames)
+    {
+        frame = createFrameBuffer();
+    }
+}
+
+void ShadowCascades::shutdown()
+{
+    if (!m_device)
+    {
+        return;
+    }
+
+    for (auto& frame : m_frames)
+    {
+        vmaDestroyBuffer(m_allocator, frame.buffer, frame.allocation);
+        frame = Buffer{};
+    }
+    vkDestroyPipeline(m_device, m_pipeline, nullptr);
+    vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+    vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(m_device, m_setLayout, nullptr);
+    vkDestroySampler(m_device, m_sampler, nullptr);
+    for (auto& cascade : m_cascades)
+    {
+        vkDestroyImageView(m_device, cascade.view, nullptr);
+        cascade = Cascade{};
+    }
+    vkDestroyImageView(m_device, m_arrayView, nullptr);
+    vmaDestroyImage(m_allocator, m_image, m_imageAllocation);
+    m_casters.clear();
+    m_imageReady = false;
+    m_device = VK_NULL_HANDLE;
+}
+
+void ShadowCascades::createImage()
+{
+    VkImageCreateInfo imageCI{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = DEPTH_FORMAT,
+        .extent = { .width = static_cast<uint32_t>(RESOLUTION),
+                    .height = static_cast<uint32_t>(RESOLUTION),
+                    .depth = 1 },
+        .mipLevels = 1,
+        .arrayLayers = CASCADE_COUNT,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+                 VK_IMAGE_USAGE_SAMPLED_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+    VmaAllocationCreateInfo allocCI{
+        .flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT,
+        .usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+    };
+    if (vmaCreateImage(
+            m_allocator,
+            &imageCI,
+            &allocCI,
+            &m_image,
+            &m_imageAllocation,
+            nullptr
+        ) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to allocate shadow maps");
+    }
+
+    VkImageViewCreateInfo viewCI{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .image = m_image,
+        .viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY,
+        .format = DEPTH_FORMAT,
+        .subresourceRange = { .aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
+                              .baseMipLevel = 0,
+                              .levelCount = 1,
+                              .baseArrayLayer = 0,
+                              .layerCount = CASCADE_COUNT },
+    };
+    if (vkCreateImageView(m_device, &viewCI, nullptr, &m_arrayView) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create shadow map view");
+    }
+
+    // One view per cascade to render into
+    viewCI.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewCI.subresourceRange.layerCount = 1;
+    for (uint32_t i = 0; i < CASCADE_COUNT; i++)
+    {
+        viewCI.subresourceRange.baseArrayLayer = i;
+        if (vkCreateImageView(
+                m_device,
+                &viewCI,
+                nullptr,
+                &m_cascades[i].view
+            ) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create shadow cascade view");
+        }
+    }
+}
+
+void ShadowCascades::createDescriptors()
+{
+    // REPEAT undoes the toroidal wrap; linear filtering with compare gives
+    // 2x2 PCF for free
+    VkSamplerCreateInfo samplerCI{
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter = VK_FILTER_LINEAR,
+        .minFilter = VK_FILTER_LINEAR,
+        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        .addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .compareEnable = VK_TRUE,
+        .compareOp = VK_COMPARE_OP_LESS_OR_EQUAL,
+        .maxLod = 0.0f,
+    };
+    if (vkCreateSampler(m_device, &samplerCI, nullptr, &m_sampler) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create shadow sampler");
+    }
+
+    VkDescriptorSetLayoutBinding binding{
+        .binding = 0,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .descriptorCount = 1,
+        .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+    };
+    VkDescriptorSetLayoutCreateInfo setLayoutCI{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = 1,
+        .pBindings = &binding,
+    };
+    if (vkCreateDescriptorSetLayout(
+            m_device,
+            &setLayoutCI,
+            nullptr,
+            &m_setLayout
+        ) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create shadow set layout");
+    }
+
+    VkDescriptorPoolSize poolSize{
+        .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .descriptorCount = 1,
+    };
+    VkDescriptorPoolCreateInfo poolCI{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets = 1,
+        .poolSizeCount = 1,
+        .pPoolSizes = &poolSize,
+    };
+    if (vkCreateDescriptorPool(m_device, &poolCI, nullptr, &m_descriptorPool) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create shadow descriptor pool");
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = m_descriptorPool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &m_setLayout,
+    };
+    if (vkAllocateDescriptorSets(m_device, &allocInfo, &m_descriptorSet) !=
+        VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to allocate shadow descriptor set");
+    }
+
+    VkDescriptorImageInfo imageInfo{
+        .sampler = m_sampler,
+        .imageView = m_arrayView,
+        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+    };
+    VkWriteDescriptorSet write{
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = m_descriptorSet,
+        .dstBinding = 0,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .pImageInfo = &imageInfo,
+    };
+    vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+}
+
+void ShadowCascades::createPipeline(VkPipelineCache pipelineCache)
+{
+    VkPushConstantRange pushConstantRange{
+        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+        .offset = 0,
+        .size = sizeof(PushConstants),
+    };
+    VkPipelineLayoutCreateInfo layoutCI{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange,
+    };
+    if (vkCreatePipelineLayout(
+            m_device,
+            &layoutCI,
+            nullptr,
+            &m_pipelineLayout
+        ) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create shadow pipeline layout");
+    }
+
+    // Depth only, so there is no fragment stage
+    VkShaderModule vertexModule =
+        loadShaderModule(m_device, "shadow.vert.spv");
+    VkPipelineShaderStageCreateInfo stage{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+        .stage = VK_SHADER_STAGE_VERTEX_BIT,
+        .module = vertexModule,
+        .pName = "main",
+    };
+    VkPipelineVertexInputStateCreateInfo vertexInput{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+    };
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+        .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+    };
+    VkPipelineViewportStateCreateInfo viewport{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        .viewportCount = 1,
+        .scissorCount = 1,
+    };
+    // Chunks only mesh faces next to air, so the sun-facing faces are the
+    // only casters and nothing can be culled
+    VkPipelineRasterizationStateCreateInfo rasterization{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+        .polygonMode = VK_POLYGON_MODE_FILL,
+        .cullMode = VK_CULL_MODE_NONE,
+        .frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+        .depthBiasEnable = VK_TRUE,
+        .depthBiasConstantFactor = 1.0f,
+        .depthBiasSlopeFactor = 1.5f,
+        .lineWidth = 1.0f,
+    };
+    VkPipelineMultisampleStateCreateInfo multisample{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+    };
+    VkPipelineDepthStencilStateCreateInfo depthStencil{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+        .depthTestEnable = VK_TRUE,
+        .depthWriteEnable = VK_TRUE,
+        .depthCompareOp = VK_COMPARE_OP_LESS,
+    };
+    VkPipelineColorBlendStateCreateInfo colorBlend{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+    };
+    const std::array<VkDynamicState, 2> dynamicStates{
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR,
+    };
+    VkPipelineDynamicStateCreateInfo dynamicState{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .dynamicStateCount = static_cast<uint32_t>(dynamicStates.size()),
+        .pDynamicStates = dynamicStates.data(),
+    };
+    VkPipelineRenderingCreateInfo renderingCI{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+        .depthAttachmentFormat = DEPTH_FORMAT,
+    };
+
+    VkGraphicsPipelineCreateInfo pipelineCI{
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext = &renderingCI,
+        .stageCount = 1,
+        .pStages = &stage,
+        .pVertexInputState = &vertexInput,
+        .pInputAssemblyState = &inputAssembly,
+        .pViewportState = &viewport,
+        .pRasterizationState = &rasterization,
+        .pMultisampleState = &multisample,
+        .pDepthStencilState = &depthStencil,
+        .pColorBlendState = &colorBlend,
+        .pDynamicState = &dynamicState,
+        .layout = m_pipelineLayout,
+    };
+    VkResult result = vkCreateGraphicsPipelines(
+        m_device,
+        pipelineCache,
+        1,
+        &pipelineCI,
+        nullptr,
+        &m_pipeline
+    );
+    vkDestroyShaderModule(m_device, vertexModule, nullptr);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create shadow pipeline");
+    }
+}
+
+ShadowCascades::Buffer ShadowCascades::createFrameBuffer()
+{
+    VkBufferCreateInfo bufferCI{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = sizeof(FrameData),
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                 VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    VmaAllocationCreateInfo allocCI{
+        .flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
+                 VMA_ALLOCATION_CREATE_MAPPED_BIT,
+        .usage = VMA_MEMORY_USAGE_AUTO,
+    };
+
+    Buffer buffer{};
+    VmaAllocationInfo info{};
+    if (vmaCreateBuffer(
+            m_allocator,
+            &bufferCI,
+            &allocCI,
+            &buffer.buffer,
+            &buffer.allocation,
+            &info
+        ) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to allocate shadow frame buffer");
+    }
+    buffer.mapped = info.pMappedData;
+
+    VkBufferDeviceAddressInfo addressInfo{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+        .buffer = buffer.buffer,
+    };
+    buffer.address = vkGetBufferDeviceAddress(m_device, &addressInfo);
+    return buffer;
+}
+
+void ShadowCascades::setSunDirection(const glm::vec3& direction)
+{
+    const glm::vec3 sun = glm::normalize(direction);
+    if (glm::dot(sun, m_sunDirection) >= std::cos(SUN_THRESHOLD))
+    {
+        return;
+    }
+
+    m_sunDirection = sun;
+    const glm::vec3 up = std::abs(sun.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f)
+                                                 : glm::vec3(0.0f, 1.0f, 0.0f);
+    m_lightView = glm::lookAt(glm::vec3(0.0f), -sun, up);
+    for (auto& [coord, bounds] : m_casters)
+    {
+        bounds = casterBounds(coord);
+    }
+    for (auto& cascade : m_cascades)
+    {
+        invalidate(cascade);
+    }
+}
+
+ShadowCascades::CasterBounds ShadowCascades::casterBounds(
+    const ChunkCoord& coord
+) const
+{
+    const glm::vec3 origin = glm::vec3(coord * CHUNK_SIZE);
+    CasterBounds bounds{ .min = glm::vec2(INFINITY),
+                         .max = glm::vec2(-INFINITY) };
+    for (int corner = 0; corner < 8; corner++)
+    {
+        const glm::ivec3 offset{ (corner & 1) ? CHUNK_SIZE : 0,
+                                 (corner & 2) ? CHUNK_SIZE : 0,
+                                 (corner & 4) ? CHUNK_SIZE : 0 };
+        const glm::vec2 p = glm::vec2(
+            m_lightView * glm::vec4(origin + glm::vec3(offset), 1.0f)
+        );
+        bounds.min = glm::min(bounds.min, p);
+        bounds.max = glm::max(bounds.max, p);
+    }
+    return bounds;
+}
+
+ShadowCascades::Rect ShadowCascades::casterRect(
+    const Cascade& cascade, const CasterBounds& bounds
+) const
+{
+    // A texel of margin for depth bias and the PCF footprint
+    return Rect{
+        .min = glm::ivec2(glm::floor(bounds.min / cascade.texelSize)) - 1,
+        .max = glm::ivec2(glm::ceil(bounds.max / cascade.texelSize)) + 1,
+    };
+}
+
+void ShadowCascades::invalidate(Cascade& cascade)
+{
+    cascade.valid = false;
+    cascade.dirty.clear();
+}
+
+void ShadowCascades::markDirty(Cascade& cascade, const Rect& rect)
+{
+    const Rect clipped{
+        .min = glm::max(rect.min, cascade.origin),
+        .max = glm::min(rect.max, cascade.origin + RESOLUTION),
+    };
+    if (clipped.empty())
+    {
+        return;
+    }
+    cascade.dirty.push_back(clipped);
+
+    if (cascade.dirty.size() > MAX_DIRTY_RECTS)
+    {
+        Rect merged = cascade.dirty.front();
+        for (const Rect& dirty : cascade.dirty)
+        {
+            merged.min = glm::min(merged.min, dirty.min);
+            merged.max = glm::max(merged.max, dirty.max);
+        }
+        cascade.dirty.assign(1, merged);
+    }
+}
+
+void ShadowCascades::scroll(Cascade& cascade, glm::ivec2 origin)
+{
+    const glm::ivec2 previous = cascade.origin;
+    const glm::ivec2 delta = origin - previous;
+    cascade.origin = origin;
+    if (std::abs(delta.x) >= RESOLUTION || std::abs(delta.y) >= RESOLUTION)
+    {
+        cascade.dirty.assign(1, Rect{ origin, origin + RESOLUTION });
+        return;
+    }
+
+    // Only the strips that entered the window hold stale texels
+    if (delta.x > 0)
+    {
+        markDirty(
+            cascade,
+            Rect{ { previous.x + RESOLUTION, origin.y },
+                  origin + RESOLUTION }
+        );
+    }
+    else if (delta.x < 0)
+    {
+        markDirty(
+            cascade,
+            Rect{ origin, { previous.x, origin.y + RESOLUTION } }
+        );
+    }
+    if (delta.y > 0)
+    {
+        markDirty(
+            cascade,
+            Rect{ { origin.x, previous.y + RESOLUTION },
+                  origin + RESOLUTION }
+        );
+    }
+    else if (delta.y < 0)
+    {
+        markDirty(
+            cascade,
+            Rect{ origin, { origin.x + RESOLUTION, previous.y } }
+        );
+    }
+}
+
+void ShadowCascades::onMeshesChanged(
+    const MeshArena& arena, const std::vector<ChunkCoord>& chunks
+)
+{
+    for (const ChunkCoord& coord : chunks)
+    {
+        auto it = m_casters.find(coord);
+        const CasterBounds bounds =
+            it != m_casters.end() ? it->second : casterBounds(coord);
+        if (arena.find(coord))
+        {
+            m_casters[coord] = bounds;
+        }
+        else if (it != m_casters.end())
+        {
+            m_casters.erase(it);
+        }
+
+        // Cascade 0 is redrawn every frame anyway
+        for (uint32_t i = 1; i < CASCADE_COUNT; i++)
+        {
+            if (m_cascades[i].valid)
+            {
+                markDirty(m_cascades[i], casterRect(m_cascades[i], bounds));
+            }
+        }
+    }
+}
+
+void ShadowCascades::record(
+    VkCommandBuffer cmd, uint32_t frameIndex, const glm::vec3& camera,
+    const MeshArena& arena
+)
+{
+    PROFILE_ZONE("ShadowCascades::record");
+    const glm::vec3 lightCamera =
+        glm::vec3(m_lightView * glm::vec4(camera, 1.0f));
+
+    // Depth values are only comparable while the anchor stays put, so it
+    // moves in coarse steps and every cascade is redrawn when it does
+    const float anchorStep = DEPTH_RANGE / 4.0f;
+    const float anchor = std::round(lightCamera.z / anchorStep) * anchorStep;
+    if (anchor != m_depthAnchor)
+    {
+        m_depthAnchor = anchor;
+        for (auto& cascade : m_cascades)
+        {
+            invalidate(cascade);
+        }
+    }
+
+    for (uint32_t i = 0; i < CASCADE_COUNT; i++)
+    {
+        Cascade& cascade = m_cascades[i];
+        const glm::ivec2 center = glm::ivec2(
+            glm::floor(glm::vec2(lightCamera) / cascade.texelSize)
+        );
+        const glm::ivec2 origin =
+            floorDiv(center, SCROLL_STEP) * SCROLL_STEP - RESOLUTION / 2;
+        if (i == 0 || !cascade.valid)
+        {
+            cascade.origin = origin;
+            cascade.valid = true;
+            cascade.dirty.assign(1, Rect{ origin, origin + RESOLUTION });
+        }
+        else
+        {
+            scroll(cascade, origin);
+        }
+    }
+
+    // Frames in flight may still sample the maps, and cached texels
+    // outside the dirty regions must survive the transition
+    imageBarrier(
+        cmd,
+        m_image,
+        CASCADE_COUNT,
+        m_imageReady ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+                     : VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+        VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+        VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT |
+            VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+        VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+            VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+    );
+    for (Cascade& cascade : m_cascades)
+    {
+        if (!cascade.dirty.empty())
+        {
+            render(cmd, arena, cascade);
+            cascade.dirty.clear();
+        }
+    }
+    imageBarrier(
+        cmd,
+        m_image,
+        CASCADE_COUNT,
+        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+        VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+        VK_ACCESS_2_SHADER_SAMPLED_READ_BIT
+    );
+    m_imageReady = true;
+
+    FrameData data{
+        .lightView = m_lightView,
+        .sunDirection = glm::vec4(m_sunDirection, 0.0f),
+        .depthAnchor = m_depthAnchor,
+        .depthRange = DEPTH_RANGE,
+        .resolution = static_cast<float>(RESOLUTION),
+    };
+    for (uint32_t i = 0; i < CASCADE_COUNT; i++)
+    {
+        data.cascades[i] = glm::vec4(
+            glm::vec2(m_cascades[i].origin),
+            m_cascades[i].texelSize,
+            0.0f
+        );
+    }
+    *static_cast<FrameData*>(m_frames[frameIndex].mapped) = data;
+    vmaFlushAllocation(
+        m_allocator,
+        m_frames[frameIndex].allocation,
+        0,
+        VK_WHOLE_SIZE
+    );
+}
+
+void ShadowCascades::render(
+    VkCommandBuffer cmd, const MeshArena& arena, const Cascade& cascade
+)
+{
+    VkRenderingAttachmentInfo depthAttachment{
+        .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+        .imageView = cascade.view,
+        .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_LOAD,
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+    };
+    VkRenderingInfo renderingInfo{
+        .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+        .renderArea = { .offset = { 0, 0 },
+                        .extent = { static_cast<uint32_t>(RESOLUTION),
+                                    static_cast<uint32_t>(RESOLUTION) } },
+        .layerCount = 1,
+        .pDepthAttachment = &depthAttachment,
+    };
+    vkCmdBeginRendering(cmd, &renderingInfo);
+
+    VkViewport viewport{
+        .x = 0.0f,
+        .y = 0.0f,
+        .width = static_cast<float>(RESOLUTION),
+        .height = static_cast<float>(RESOLUTION),
+        .minDepth = 0.0f,
+        .maxDepth = 1.0f,
+    };
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline);
+
+    // The window straddles at most four tiles of the wrapped map. Each
+    // tile is drawn with a projection that lands its texels at
+    // texel - tileMin, which is the texel modulo RESOLUTION.
+    const glm::ivec2 base = floorDiv(cascade.origin, RESOLUTION) * RESOLUTION;
+    const float scale = 2.0f / (cascade.texelSize * RESOLUTION);
+    for (const Rect& dirty : cascade.dirty)
+    {
+        // Rects are marked before the window scrolls, and merged ones may
+        // span strips that have since left it; texels outside the window
+        // share the map with the ones that entered, so only the window is
+        // drawn
+        const Rect rect{
+            .min = glm::max(dirty.min, cascade.origin),
+            .max = glm::min(dirty.max, cascade.origin + RESOLUTION),
+        };
+        for (int tile = 0; tile < 4; tile++)
+        {
+            const glm::ivec2 tileMin =
+                base + glm::ivec2(tile & 1, tile >> 1) * RESOLUTION;
+            const Rect piece{
+                .min = glm::max(rect.min, tileMin),
+                .max = glm::min(rect.max, tileMin + RESOLUTION),
+            };
+            if (piece.empty())
+            {
+                continue;
+            }
+
+            const VkRect2D scissor{
+                .offset = { piece.min.x - tileMin.x, piece.min.y - tileMin.y },
+                .extent = { static_cast<uint32_t>(piece.max.x - piece.min.x),
+                            static_cast<uint32_t>(piece.max.y - piece.min.y) },
+            };
+            vkCmdSetScissor(cmd, 0, 1, &scissor);
+            const VkClearAttachment clear{
+                .aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
+                .clearValue = { .depthStencil = { .depth = 1.0f } },
+            };
+            const VkClearRect clearRect{
+                .rect = scissor,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            };
+            vkCmdClearAttachments(cmd, 1, &clear, 1, &clearRect);
+
+            // Light space to clip space for this tile; depth 0 faces the
+            // sun at the far end of the range
+            glm::mat4 projection{ 1.0f };
+            projection[0][0] = scale;
+            projection[1][1] = scale;
+            projection[2][2] = -1.0f / (2.0f * DEPTH_RANGE);
+            projection[3][0] = -2.0f * tileMin.x / RESOLUTION - 1.0f;
+            projection[3][1] = -2.0f * tileMin.y / RESOLUTION - 1.0f;
+            projection[3][2] =
+                (m_depthAnchor + DEPTH_RANGE) / (2.0f * DEPTH_RANGE);
+            PushConstants pushConstants{
+                .viewProjection = projection * m_lightView,
+            };
+            vkCmdPushConstants(
+                cmd,
+                m_pipelineLayout,
+                VK_SHADER_STAGE_VERTEX_BIT,
+                0,
+                sizeof(glm::mat4),
+                &pushConstants
+            );
+
+            for (const auto& [coord, bounds] : m_casters)
+            {
+                const Rect caster = casterRect(cascade, bounds);
+                if (caster.max.x <= piece.min.x ||
+                    caster.min.x >= piece.max.x ||
+                    caster.max.y <= piece.min.y || caster.min.y >= piece.max.y)
+                {
+                    continue;
+                }
+                const MeshAllocation* mesh = arena.find(coord);
+                if (!mesh)
+                {
+                    continue;
+                }
+                pushConstants.vertices = mesh->address;
+                pushConstants.chunkOrigin = coord * CHUNK_SIZE;
+                vkCmdPushConstants(
+                    cmd,
+                    m_pipelineLayout,
+                    VK_SHADER_STAGE_VERTEX_BIT,
+                    sizeof(glm::mat4),
+                    sizeof(PushConstants) - sizeof(glm::mat4),
+                    &pushConstants.vertices
+                );
+                vkCmdDraw(cmd, mesh->quadCount * VERTICES_PER_QUAD, 1, 0, 0);
+            }
+        }
+    }
+    vkCmdEndRendering(cmd);
+}
+
+VkDescriptorSetLayout ShadowCascades::descriptorSetLayout() const
+{
+    return m_setLayout;
+}
+
+VkDescriptorSet ShadowCascades::descriptorSet() const
+{
+    return m_descriptorSet;
+}
+
+VkDeviceAddress ShadowCascades::frameAddress(uint32_t frameIndex) const
+{
+    return m_frames[frameIndex].address;
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#ifndef VK_NO_PROTOTYPES
+#define VK_NO_PROTOTYPES
+#endif
+
+#include <volk/volk.h>
+#include <vma/vk_mem_alloc.h>
+#include <array>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "gfx/vulkan/context.h"
+#include "gfx/vulkan/mesh_arena.h"
+
+// Sun shadows from cascaded, cached shadow maps.
+//
+// Every cascade is a square map over a plane facing the sun, addressed
+// toroidally: texel coordinates are anchored to the world, and a map holds
+// whichever texels currently fall in its window, wrapped modulo its size.
+// When the camera moves, the window scrolls in steps of SCROLL_STEP texels
+// and only the strips that came into view are rendered; the sampler's
+// REPEAT addressing undoes the wrap. Cascade 0 is small and rendered in
+// full every frame. The others are rendered once and after that only
+// where a chunk mesh changed, where the window scrolled, or in full when
+// the sun turns past SUN_THRESHOLD or the camera leaves the depth range.
+class ShadowCascades
+{
+  public:
+    static constexpr uint32_t CASCADE_COUNT{ 4 };
+    static constexpr int32_t RESOLUTION{ 2048 };
+    static constexpr VkFormat DEPTH_FORMAT{ VK_FORMAT_D32_SFLOAT };
+    // Blocks covered by each cascade's side
+    static constexpr std::array<float, CASCADE_COUNT> SPANS{ 64.0f,
+                                                             192.0f,
+                                                             576.0f,
+                                                             1728.0f };
+    static constexpr int32_t SCROLL_STEP{ 32 };
+    // Casters are kept within this many blocks of the depth anchor along
+    // the sun direction
+    static constexpr float DEPTH_RANGE{ 512.0f };
+    // Radians the sun may turn before the caches are thrown away
+    static constexpr float SUN_THRESHOLD{ 0.005f };
+
+  private:
+    // Beyond this many dirty regions a cascade redraws their bounds
+    static constexpr size_t MAX_DIRTY_RECTS{ 8 };
+
+    // Texels in the cascade's world-anchored grid; max is exclusive
+    struct Rect
+    {
+        glm::ivec2 min{ 0 };
+        glm::ivec2 max{ 0 };
+
+        bool empty() const
+        {
+            return min.x >= max.x || min.y >= max.y;
+        }
+    };
+
+    struct Cascade
+    {
+        float texelSize{ 1.0f };
+        // First texel of the window
+        glm::ivec2 origin{ 0 };
+        bool valid{ false };
+        std::vector<Rect> dirty;
+        VkImageView view{ VK_NULL_HANDLE };
+    };
+
+    // Chunk extent in light space
+    struct CasterBounds
+    {
+        glm::vec2 min{ 0.0f };
+        glm::vec2 max{ 0.0f };
+    };
+
+    // Matches ShadowFrame in chunk.frag
+    struct FrameData
+    {
+        glm::mat4 lightView{ 1.0f };
+        glm::vec4 sunDirection{ 0.0f };
+        // Window origin in texels, texel size in blocks, unused
+        std::array<glm::vec4, CASCADE_COUNT> cascades{};
+        float depthAnchor{ 0.0f };
+        float depthRange{ 0.0f };
+        float resolution{ 0.0f };
+        uint32_t pad{ 0 };
+    };
+
+    struct PushConstants
+    {
+        glm::mat4 viewProjection{ 1.0f };
+        VkDeviceAddress vertices{ 0 };
+        glm::ivec3 chunkOrigin{ 0 };
+        uint32_t pad{ 0 };
+    };
+
+    struct Buffer
+    {
+        VkBuffer buffer{ VK_NULL_HANDLE };
+        VmaAllocation allocation{ VK_NULL_HANDLE };
+        VkDeviceAddress address{ 0 };
+        void* mapped{ nullptr };
+    };
+
+    VkDevice m_device{ VK_NULL_HANDLE };
+    VmaAllocator m_allocator{ VK_NULL_HANDLE };
+    VkImage m_image{ VK_NULL_HANDLE };
+    VmaAllocation m_imageAllocation{ VK_NULL_HANDLE };
+    VkImageView m_arrayView{ VK_NULL_HANDLE };
+    VkSampler m_sampler{ VK_NULL_HANDLE };
+    VkDescriptorSetLayout m_setLayout{ VK_NULL_HANDLE };
+    VkDescriptorPool m_descriptorPool{ VK_NULL_HANDLE };
+    VkDescriptorSet m_descriptorSet{ VK_NULL_HANDLE };
+    VkPipelineLayout m_pipelineLayout{ VK_NULL_HANDLE };
+    VkPipeline m_pipeline{ VK_NULL_HANDLE };
+    std::array<Buffer, MAX_FRAMES_IN_FLIGHT> m_frames;
+    std::array<Cascade, CASCADE_COUNT> m_cascades;
+    // Layout is undefined until the first record()
+    bool m_imageReady{ false };
+
+    glm::vec3 m_sunDirection{ 0.36f, 0.84f, 0.40f };
+    glm::mat4 m_lightView{ 1.0f };
+    float m_depthAnchor{ 0.0f };
+    std::unordered_map<ChunkCoord, CasterBounds, ChunkCoordHash> m_casters;
+
+    void createImage();
+    void createDescriptors();
+    void createPipeline(VkPipelineCache pipelineCache);
+    Buffer createFrameBuffer();
+
+    CasterBounds casterBounds(const ChunkCoord& coord) const;
+    Rect casterRect(const Cascade& cascade, const CasterBounds& bounds) const;
+    void invalidate(Cascade& cascade);
+    void markDirty(Cascade& cascade, const Rect& rect);
+    void scroll(Cascade& cascade, glm::ivec2 origin);
+    void render(
+        VkCommandBuffer cmd, const MeshArena& arena, const Cascade& cascade
+    );
+
+  public:
+    ShadowCascades() = default;
+    ~ShadowCascades()
+    {
+        shutdown();
+    }
+    ShadowCascades(const ShadowCascades&) = delete;
+    ShadowCascades& operator=(const ShadowCascades&) = delete;
+
+    void init(
+        VkDevice device, VmaAllocator allocator, VkPipelineCache pipelineCache
+    );
+    void shutdown();
+
+    // Points towards the sun; turns smaller than SUN_THRESHOLD are ignored
+    void setSunDirection(const glm::vec3& direction);
+
+    // Redraws the regions the chunks cast into; pass
+    // MeshArena::takeChangedChunks() once per frame
+    void onMeshesChanged(
+        const MeshArena& arena, const std::vector<ChunkCoord>& chunks
+    );
+
+    // Scrolls the cascades to the camera and renders what is out of date,
+    // leaving the maps ready for fragment shader sampling; call after the
+    // frame's fence and outside of dynamic rendering
+    void record(
+        VkCommandBuffer cmd, uint32_t frameIndex, const glm::vec3& camera,
+        const MeshArena& arena
+    );
+
+    // Set 0 of the chunk pipeline: the cascades as a shadow sampler array
+    VkDescriptorSetLayout descriptorSetLayout() const;
+    VkDescriptorSet descriptorSet() const;
+    // Cascade placement for the frame, read by chunk.frag
+    VkDeviceAddress frameAddress(uint32_t frameIndex) const;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#ifndef VK_NO_PROTOTYPES
+#define VK_NO_PROTOTYPES
+#endif
+
+#include <volk/volk.h>
+#include <vma/vk_mem_alloc.h>
+#include "gfx/vulkan/context.h"
+
+// Weighted blended order-independent transparency (McGuire and Bavoil).
+//
+// Translucent faces are drawn in any order after the opaque scene, testing
+// against its depth without writing it. Each fragment adds its
+// premultiplied colour, scaled by a weight that falls off with depth, to
+// the accumulation target, and multiplies the revealage target by
+// 1 - alpha. The composite then blends the weighted average colour over
+// the scene by 1 - revealage. No sorting happens on the CPU or the GPU,
+// so chunk meshes never have to be re-sorted or re-uploaded as the camera
+// moves. Both targets are allocated once at the largest render size, like
+// DynamicResolution's.
+class TransparencyPass
+{
+  public:
+    static constexpr VkFormat ACCUMULATION_FORMAT{
+        VK_FORMAT_R16G16B16A16_SFLOAT
+    };
+    static constexpr VkFormat REVEALAGE_FORMAT{ VK_FORMAT_R16_SFLOAT };
+
+  private:
+    struct Target
+    {
+        VkImage image{ VK_NULL_HANDLE };
+        VmaAllocation allocation{ VK_NULL_HANDLE };
+        VkImageView view{ VK_NULL_HANDLE };
+    };
+
+    VkDevice m_device{ VK_NULL_HANDLE };
+    VmaAllocator m_allocator{ VK_NULL_HANDLE };
+    Target m_accumulation;
+    Target m_revealage;
+    VkExtent2D m_capacity{};
+
+    VkSampler m_sampler{ VK_NULL_HANDLE };
+    VkDescriptorSetLayout m_setLayout{ VK_NULL_HANDLE };
+    VkDescriptorPool m_descriptorPool{ VK_NULL_HANDLE };
+    VkDescriptorSet m_descriptorSet{ VK_NULL_HANDLE };
+    VkPipelineLayout m_pipelineLayout{ VK_NULL_HANDLE };
+    VkPipeline m_pipeline{ VK_NULL_HANDLE };
+
+    Target createTarget(VkFormat format);
+    void destroyTarget(Target& target);
+    void createTargets(VkExtent2D extent);
+    void createDescriptors();
+    void writeDescriptors();
+    void createPipeline(VkPipelineCache pipelineCache, VkFormat sceneFormat);
+
+  public:
+    TransparencyPass() = default;
+    ~TransparencyPass()
+    {
+        shutdown();
+    }
+    TransparencyPass(const TransparencyPass&) = delete;
+    TransparencyPass& operator=(const TransparencyPass&) = delete;
+
+    // `sceneFormat` is the colour target the composite blends into
+    void init(
+        VkDevice device, VmaAllocator allocator, VkPipelineCache pipelineCache,
+        VkFormat sceneFormat, VkExtent2D maxExtent
+    );
+    void shutdown();
+
+    // Dynamic rendering into both targets, cleared, with the scene's depth
+    // loaded for testing; viewport and scissor cover `extent`. Call after
+    // the opaque pass has ended. A larger extent than ever before
+    // reallocates the targets after a device wait.
+    void beginRendering(
+        VkCommandBuffer cmd, VkImageView depthView, VkExtent2D extent
+    );
+    // Leaves both targets for the composite to read
+    void endRendering(VkCommandBuffer cmd);
+
+    // Blends the translucent layers over the scene; record inside
+    // DynamicResolution::continueRendering()
+    void composite(VkCommandBuffer cmd);
+};
@@ -1,5 +1,8 @@
 #include <volk/volk.h>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <vector>
 #include "validation.h"
 
 VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
@@ -12,14 +15,57 @@ VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
     return VK_FALSE;
 }
 
-VkDebugUtilsMessengerEXT createDebugMessenger(VkInstance instance)
+ValidationConfig validationFromEnvironment()
 {
+    // DEBUG_BUILD is the only configuration macro the build defines;
+    // NDEBUG is not set for the default -O3 build
+    ValidationConfig config{
+#ifdef DEBUG_BUILD
+        .enabled = true,
+#else
+        .enabled = false,
+#endif
+    };
+    if (const char* value = std::getenv("VOXEL_VALIDATION"))
+    {
+        config.verbose = std::strcmp(value, "verbose") == 0;
+        config.enabled = config.verbose || std::strcmp(value, "0") != 0;
+    }
+    return config;
+}
+
+bool isValidationLayerAvailable()
+{
+    uint32_t layerCount{ 0 };
+    vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+    std::vector<VkLayerProperties> layers(layerCount);
+    vkEnumerateInstanceLayerProperties(&layerCount, layers.data());
+    for (const auto& layer : layers)
+    {
+        if (std::strcmp(layer.layerName, VALIDATION_LAYER) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+VkDebugUtilsMessengerEXT
+createDebugMessenger(VkInstance instance, const ValidationConfig& config)
+{
+    VkDebugUtilsMessageSeverityFlagsEXT severity{
+        VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT |
+        VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT
+    };
+    if (config.verbose)
+    {
+        severity |= VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT |
+                    VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT;
+    }
+
     VkDebugUtilsMessengerCreateInfoEXT messengerCI{
         .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT,
-        .messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT |
-                           VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT |
-                           VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT |
-                           VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT,
+        .messageSeverity = severity,
         .messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT |
                        VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT |
                        VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT,
@@ -2,7 +2,24 @@
 
 #include <volk/volk.h>
 
-VkDebugUtilsMessengerEXT createDebugMessenger(VkInstance instance);
+constexpr const char* VALIDATION_LAYER{ "VK_LAYER_KHRONOS_validation" };
+
+struct ValidationConfig
+{
+    bool enabled{ false };
+    // Also forwards INFO and VERBOSE messages, which are mostly loader noise
+    bool verbose{ false };
+};
+
+// On in debug builds and off otherwise; VOXEL_VALIDATION=0, 1 or verbose
+// overrides the build default
+ValidationConfig validationFromEnvironment();
+
+// False when the Khronos validation layer is not installed
+bool isValidationLayerAvailable();
+
+VkDebugUtilsMessengerEXT
+createDebugMessenger(VkInstance instance, const ValidationConfig& config);
 
 void destroyDebugMessenger(
     VkInstance instance, VkDebugUtilsMessengerEXT messenger
@@ -0,0 +1,63 @@
+#include "loopback_transport.h"
+
+LoopbackTransport::LoopbackTransport(
+    std::shared_ptr<Queue> inbox, std::shared_ptr<Queue> outbox,
+    float lossRate, uint64_t seed
+)
+    : m_inbox(std::move(inbox)), m_outbox(std::move(outbox)),
+      m_lossRate(lossRate), m_random(seed | 1)
+{
+}
+
+std::pair<
+    std::unique_ptr<LoopbackTransport>, std::unique_ptr<LoopbackTransport>>
+LoopbackTransport::createPair(float lossRate, uint64_t seed)
+{
+    auto toFirst = std::make_shared<Queue>();
+    auto toSecond = std::make_shared<Queue>();
+    return {
+        std::make_unique<LoopbackTransport>(toFirst, toSecond, lossRate, seed),
+        std::make_unique<LoopbackTransport>(
+            toSecond,
+            toFirst,
+            lossRate,
+            seed * 0x9E3779B97F4A7C15ull
+        ),
+    };
+}
+
+bool LoopbackTransport::dropNext()
+{
+    if (m_lossRate <= 0.0f)
+    {
+        return false;
+    }
+    // xorshift64
+    m_random ^= m_random << 13;
+    m_random ^= m_random >> 7;
+    m_random ^= m_random << 17;
+    return static_cast<float>(m_random >> 40) / static_cast<float>(1 << 24) <
+           m_lossRate;
+}
+
+void LoopbackTransport::send(const uint8_t* data, size_t size)
+{
+    if (dropNext())
+    {
+        return;
+    }
+    std::lock_guard lock(m_outbox->mutex);
+    m_outbox->packets.emplace_back(data, data + size);
+}
+
+bool LoopbackTransport::receive(std::vector<uint8_t>& packet)
+{
+    std::lock_guard lock(m_inbox->mutex);
+    if (m_inbox->packets.empty())
+    {
+        return false;
+    }
+    packet = std::move(m_inbox->packets.front());
+    m_inbox->packets.pop_front();
+    return true;
+}
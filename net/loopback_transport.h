@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "net/transport.h"
+
+// In-process transport for tests and single-player: the two ends of a pair
+// share packet queues. A loss rate drops packets with a deterministic,
+// seeded sequence so lossy runs reproduce.
+class LoopbackTransport : public Transport
+{
+  private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::vector<uint8_t>> packets;
+    };
+
+    std::shared_ptr<Queue> m_inbox;
+    std::shared_ptr<Queue> m_outbox;
+    float m_lossRate{ 0.0f };
+    uint64_t m_random{ 0 };
+
+    bool dropNext();
+
+  public:
+    LoopbackTransport(
+        std::shared_ptr<Queue> inbox, std::shared_ptr<Queue> outbox,
+        float lossRate, uint64_t seed
+    );
+
+    // Both directions drop `lossRate` of their packets
+    static std::pair<
+        std::unique_ptr<LoopbackTransport>, std::unique_ptr<LoopbackTransport>>
+    createPair(float lossRate = 0.0f, uint64_t seed = 1);
+
+    void send(const uint8_t* data, size_t size) override;
+    bool receive(std::vector<uint8_t>& packet) override;
+};
@@ -0,0 +1,239 @@
+#include "reliable_channel.h"
+#include <algorithm>
+#include <cstdint>
+#include "core/serialization/byte_stream.h"
+
+namespace
+{
+constexpr uint8_t FLAG_DATA{ 1 << 0 };
+constexpr uint8_t FLAG_LAST{ 1 << 1 };
+
+// Sequence numbers wrap; differences are taken in 16 bits
+int16_t sequenceDelta(uint16_t a, uint16_t b)
+{
+    return static_cast<int16_t>(static_cast<uint16_t>(a - b));
+}
+} // namespace
+
+ReliableChannel::ReliableChannel(Transport& transport) : m_transport(transport)
+{
+}
+
+void ReliableChannel::send(std::vector<uint8_t> message)
+{
+    m_queuedBytes += message.size();
+    m_outgoing.push_back(std::move(message));
+}
+
+bool ReliableChannel::receive(std::vector<uint8_t>& message)
+{
+    if (m_delivered.empty())
+    {
+        return false;
+    }
+    message = std::move(m_delivered.front());
+    m_delivered.pop_front();
+    return true;
+}
+
+size_t ReliableChannel::update(size_t byteBudget)
+{
+    m_tick++;
+    while (m_transport.receive(m_packet))
+    {
+        handlePacket(m_packet);
+    }
+
+    size_t sent = 0;
+    const auto fits = [&](size_t fragmentSize) {
+        return sent == 0 || sent + HEADER_SIZE + fragmentSize <= byteBudget;
+    };
+
+    // Resends first so a lost fragment does not stall delivery behind newer
+    // ones
+    for (OutgoingPacket& packet : m_inFlight)
+    {
+        if (packet.acked || packet.sentTick + RESEND_TICKS > m_tick)
+        {
+            continue;
+        }
+        if (!fits(packet.fragment.size()))
+        {
+            break;
+        }
+        sent += transmit(&packet);
+    }
+
+    while (!m_outgoing.empty() && m_inFlight.size() < WINDOW)
+    {
+        const size_t remaining = m_outgoing.front().size() - m_outgoingOffset;
+        if (!fits(std::min(remaining, MAX_FRAGMENT_SIZE)))
+        {
+            break;
+        }
+        OutgoingPacket& packet = m_inFlight.emplace_back();
+        takeFragment(packet);
+        sent += transmit(&packet);
+    }
+
+    if (m_ackPending)
+    {
+        transmit(nullptr);
+    }
+    m_bytesSent += sent;
+    return sent;
+}
+
+void ReliableChannel::takeFragment(OutgoingPacket& packet)
+{
+    const std::vector<uint8_t>& message = m_outgoing.front();
+    const size_t size =
+        std::min(message.size() - m_outgoingOffset, MAX_FRAGMENT_SIZE);
+    packet.sequence = m_nextSequence++;
+    packet.fragment.assign(
+        message.begin() + m_outgoingOffset,
+        message.begin() + m_outgoingOffset + size
+    );
+    m_outgoingOffset += size;
+    m_queuedBytes -= size;
+
+    packet.last = m_outgoingOffset == message.size();
+    if (packet.last)
+    {
+        m_outgoing.pop_front();
+        m_outgoingOffset = 0;
+    }
+}
+
+size_t ReliableChannel::transmit(OutgoingPacket* packet)
+{
+    m_packet.clear();
+    ByteWriter writer(m_packet);
+    uint8_t flags = 0;
+    if (packet)
+    {
+        flags = FLAG_DATA | (packet->last ? FLAG_LAST : 0);
+    }
+    writer.u8(flags);
+    writer.u16(m_nextExpected);
+    writer.u64(receivedBits());
+    if (packet)
+    {
+        writer.u16(packet->sequence);
+        writer.bytes(packet->fragment.data(), packet->fragment.size());
+    }
+    m_transport.send(m_packet.data(), m_packet.size());
+    m_ackPending = false;
+
+    if (!packet)
+    {
+        return 0;
+    }
+    // The resend timer restarts on every transmission
+    packet->sentTick = m_tick;
+    return m_packet.size();
+}
+
+uint64_t ReliableChannel::receivedBits() const
+{
+    // Bit i is set when sequence m_nextExpected + 1 + i is buffered
+    uint64_t bits = 0;
+    for (uint32_t i = 0; i + 1 < WINDOW; i++)
+    {
+        const uint16_t sequence = static_cast<uint16_t>(m_nextExpected + 1 + i);
+        const IncomingPacket& slot = m_reorder[sequence % WINDOW];
+        if (slot.received && slot.sequence == sequence)
+        {
+            bits |= 1ull << i;
+        }
+    }
+    return bits;
+}
+
+void ReliableChannel::handlePacket(const std::vector<uint8_t>& packet)
+{
+    ByteReader reader(packet.data(), packet.size());
+    const uint8_t flags = reader.u8();
+    const uint16_t ack = reader.u16();
+    const uint64_t ackBits = reader.u64();
+    const uint16_t sequence = (flags & FLAG_DATA) ? reader.u16() : 0;
+    if (!reader.ok())
+    {
+        return;
+    }
+    handleAck(ack, ackBits);
+    if (!(flags & FLAG_DATA))
+    {
+        return;
+    }
+
+    // Duplicates are acked again in case the first ack was lost
+    m_ackPending = true;
+    const int16_t ahead = sequenceDelta(sequence, m_nextExpected);
+    if (ahead < 0 || ahead >= static_cast<int16_t>(WINDOW))
+    {
+        return;
+    }
+    IncomingPacket& slot = m_reorder[sequence % WINDOW];
+    if (slot.received)
+    {
+        return;
+    }
+    const size_t size = reader.remaining();
+    const uint8_t* fragment = reader.bytes(size);
+    slot.sequence = sequence;
+    slot.received = true;
+    slot.last = (flags & FLAG_LAST) != 0;
+    slot.fragment.assign(fragment, fragment + size);
+    deliverInOrder();
+}
+
+void ReliableChannel::handleAck(uint16_t ack, uint64_t ackBits)
+{
+    for (OutgoingPacket& packet : m_inFlight)
+    {
+        const int16_t delta = sequenceDelta(packet.sequence, ack);
+        if (delta < 0 || (delta > 0 && delta < 64 &&
+                          (ackBits >> (delta - 1)) & 1))
+        {
+            packet.acked = true;
+        }
+    }
+    while (!m_inFlight.empty() && m_inFlight.front().acked)
+    {
+        m_inFlight.pop_front();
+    }
+}
+
+void ReliableChannel::deliverInOrder()
+{
+    for (;;)
+    {
+        IncomingPacket& slot = m_reorder[m_nextExpected % WINDOW];
+        if (!slot.received || slot.sequence != m_nextExpected)
+        {
+            return;
+        }
+        slot.received = false;
+        m_nextExpected++;
+
+        if (!m_discarding)
+        {
+            m_assembling.insert(
+                m_assembling.end(),
+                slot.fragment.begin(),
+                slot.fragment.end()
+            );
+            m_discarding = m_assembling.size() > MAX_MESSAGE_SIZE;
+        }
+        if (slot.last)
+        {
+            if (!m_discarding)
+            {
+                m_delivered.push_back(std::move(m_assembling));
+            }
+            m_assembling.clear();
+            m_discarding = false;
+        }
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "net/transport.h"
+
+// Reliable, ordered messages over an unreliable Transport.
+//
+// Messages are split into fragments of one packet each. Every data packet
+// carries a 16-bit sequence number and every packet, data or not, carries
+// the receiver's cumulative ack (next sequence it expects) plus a 64-bit
+// field of the packets received past it, so acks ride on regular traffic
+// and survive individual losses. Unacked packets are resent after
+// RESEND_TICKS updates; at most WINDOW are in flight. The receiver keeps
+// out-of-order packets in a WINDOW sized buffer and releases fragments in
+// sequence order.
+class ReliableChannel
+{
+  public:
+    static constexpr uint32_t WINDOW{ 64 };
+    static constexpr uint32_t RESEND_TICKS{ 5 };
+    // flags, ack, ack bits, sequence
+    static constexpr size_t HEADER_SIZE{ 1 + 2 + 8 + 2 };
+    static constexpr size_t MAX_FRAGMENT_SIZE{ Transport::MAX_PACKET_SIZE -
+                                               HEADER_SIZE };
+    // Larger incoming messages are discarded
+    static constexpr size_t MAX_MESSAGE_SIZE{ 16 << 20 };
+
+  private:
+    struct OutgoingPacket
+    {
+        uint16_t sequence{ 0 };
+        bool last{ false };
+        bool acked{ false };
+        uint64_t sentTick{ 0 };
+        std::vector<uint8_t> fragment;
+    };
+
+    struct IncomingPacket
+    {
+        uint16_t sequence{ 0 };
+        bool received{ false };
+        bool last{ false };
+        std::vector<uint8_t> fragment;
+    };
+
+    Transport& m_transport;
+    uint64_t m_tick{ 0 };
+
+    // Sending; m_inFlight is in sequence order, oldest unacked first
+    std::deque<std::vector<uint8_t>> m_outgoing;
+    size_t m_outgoingOffset{ 0 };
+    size_t m_queuedBytes{ 0 };
+    uint16_t m_nextSequence{ 0 };
+    std::deque<OutgoingPacket> m_inFlight;
+    uint64_t m_bytesSent{ 0 };
+
+    // Receiving
+    uint16_t m_nextExpected{ 0 };
+    std::array<IncomingPacket, WINDOW> m_reorder;
+    std::vector<uint8_t> m_assembling;
+    bool m_discarding{ false };
+    std::deque<std::vector<uint8_t>> m_delivered;
+    bool m_ackPending{ false };
+
+    std::vector<uint8_t> m_packet;
+
+    void handlePacket(const std::vector<uint8_t>& packet);
+    void handleAck(uint16_t ack, uint64_t ackBits);
+    void deliverInOrder();
+    uint64_t receivedBits() const;
+    size_t transmit(OutgoingPacket* packet);
+    void takeFragment(OutgoingPacket& packet);
+
+  public:
+    explicit ReliableChannel(Transport& transport);
+    ReliableChannel(const ReliableChannel&) = delete;
+    ReliableChannel& operator=(const ReliableChannel&) = delete;
+
+    void send(std::vector<uint8_t> message);
+    // Pops the next complete message in send order
+    bool receive(std::vector<uint8_t>& message);
+
+    // Call once per tick: reads all waiting packets, then sends resends and
+    // new fragments, never more than `byteBudget` bytes of data packets
+    // (one packet is always allowed). Acks go out even when the budget is
+    // spent. Returns the bytes sent.
+    size_t update(size_t byteBudget = SIZE_MAX);
+
+    // Message bytes not yet sent for the first time
+    size_t queuedBytes() const
+    {
+        return m_queuedBytes;
+    }
+    size_t inFlightPackets() const
+    {
+        return m_inFlight.size();
+    }
+    uint64_t bytesSent() const
+    {
+        return m_bytesSent;
+    }
+};
@@ -0,0 +1,375 @@
+#include "replication.h"
+#include <algorithm>
+#include <stdexcept>
+#include "core/profiling/profiler.h"
+#include "core/serialization/byte_stream.h"
+#include "world/chunk_codec.h"
+
+namespace
+{
+void writeCoord(ByteWriter& writer, const ChunkCoord& coord)
+{
+    writer.i32(coord.x);
+    writer.i32(coord.y);
+    writer.i32(coord.z);
+}
+
+ChunkCoord readCoord(ByteReader& reader)
+{
+    const int32_t x = reader.i32();
+    const int32_t y = reader.i32();
+    const int32_t z = reader.i32();
+    return { x, y, z };
+}
+
+int lengthSquared(const glm::ivec3& v)
+{
+    return v.x * v.x + v.y * v.y + v.z * v.z;
+}
+
+int chebyshevDistance(const ChunkCoord& a, const ChunkCoord& b)
+{
+    const glm::ivec3 d = glm::abs(a - b);
+    return std::max(d.x, std::max(d.y, d.z));
+}
+} // namespace
+
+ReplicationServer::ReplicationServer(
+    World& world, const ReplicationConfig& config
+)
+    : m_world(world), m_config(config)
+{
+    const int radius = m_config.viewRadius;
+    for (int y = -radius; y <= radius; y++)
+    {
+        for (int z = -radius; z <= radius; z++)
+        {
+            for (int x = -radius; x <= radius; x++)
+            {
+                m_offsets.push_back({ x, y, z });
+            }
+        }
+    }
+    // Stable so equal distances keep a deterministic order
+    std::stable_sort(
+        m_offsets.begin(),
+        m_offsets.end(),
+        [](const glm::ivec3& a, const glm::ivec3& b) {
+            return lengthSquared(a) < lengthSquared(b);
+        }
+    );
+}
+
+ReplicationServer::ClientId ReplicationServer::addClient(Transport& transport)
+{
+    const ClientId id = m_nextClient++;
+    m_clients[id].channel = std::make_unique<ReliableChannel>(transport);
+    return id;
+}
+
+void ReplicationServer::removeClient(ClientId client)
+{
+    m_clients.erase(client);
+}
+
+void ReplicationServer::setViewer(ClientId client, const glm::vec3& position)
+{
+    auto it = m_clients.find(client);
+    if (it != m_clients.end())
+    {
+        it->second.viewer = toChunkCoord(glm::ivec3(glm::floor(position)));
+    }
+}
+
+void ReplicationServer::onBlocksChanged(const std::vector<BlockChange>& changes)
+{
+    for (const BlockChange& change : changes)
+    {
+        m_edits[toChunkCoord(change.pos)].push_back(
+            localIndex(toLocalPos(change.pos))
+        );
+    }
+}
+
+void ReplicationServer::update()
+{
+    PROFILE_ZONE("ReplicationServer::update");
+    collectEdits();
+    for (auto& [id, client] : m_clients)
+    {
+        sendDeltas(client);
+        sendUnloads(client);
+        sendNewChunks(client);
+        client.channel->update(m_config.bytesPerTick);
+    }
+    m_tickEdits.clear();
+}
+
+void ReplicationServer::collectEdits()
+{
+    for (auto& [coord, indices] : m_edits)
+    {
+        const Chunk* chunk = m_world.getChunk(coord);
+        if (!chunk)
+        {
+            continue;
+        }
+        // A block edited several times in a tick is sent once, as it is now
+        std::sort(indices.begin(), indices.end());
+        indices.erase(
+            std::unique(indices.begin(), indices.end()),
+            indices.end()
+        );
+
+        ChunkEdits& edits = m_tickEdits.emplace_back();
+        edits.coord = coord;
+        edits.count = static_cast<uint16_t>(
+            std::min(indices.size(), FULL_RESEND_EDITS + 1)
+        );
+        if (indices.size() > FULL_RESEND_EDITS)
+        {
+            continue;
+        }
+        ByteWriter writer(edits.entries);
+        for (uint16_t index : indices)
+        {
+            writer.u16(index);
+            writer.u16(chunk->getBlock(index));
+            writer.u8(chunk->getMeta(index));
+        }
+    }
+    m_edits.clear();
+}
+
+void ReplicationServer::sendChunk(
+    Client& client, const ChunkCoord& coord, const Chunk& chunk
+)
+{
+    std::vector<uint8_t> message;
+    ByteWriter writer(message);
+    writer.u8(static_cast<uint8_t>(ReplicationMessage::ChunkData));
+    writeCoord(writer, coord);
+    encodeChunk(chunk.data(), message);
+    client.channel->send(std::move(message));
+    client.known.insert(coord);
+}
+
+void ReplicationServer::sendDeltas(Client& client)
+{
+    std::vector<uint8_t> message;
+    ByteWriter writer(message);
+    writer.u8(static_cast<uint8_t>(ReplicationMessage::BlockDeltas));
+    writer.u16(0);
+    uint16_t chunkCount = 0;
+
+    for (const ChunkEdits& edits : m_tickEdits)
+    {
+        if (!client.known.contains(edits.coord))
+        {
+            // Sent whole once it comes into view
+            continue;
+        }
+        if (edits.entries.empty())
+        {
+            sendChunk(client, edits.coord, *m_world.getChunk(edits.coord));
+            continue;
+        }
+        writeCoord(writer, edits.coord);
+        writer.u16(edits.count);
+        writer.bytes(edits.entries.data(), edits.entries.size());
+        chunkCount++;
+    }
+    if (chunkCount > 0)
+    {
+        writer.patchU16(1, chunkCount);
+        client.channel->send(std::move(message));
+    }
+}
+
+void ReplicationServer::sendUnloads(Client& client)
+{
+    std::vector<uint8_t> message;
+    ByteWriter writer(message);
+    writer.u8(static_cast<uint8_t>(ReplicationMessage::ChunkUnload));
+    writer.u16(0);
+    uint16_t chunkCount = 0;
+
+    for (auto it = client.known.begin();
+         it != client.known.end() && chunkCount < UINT16_MAX;)
+    {
+        if (chebyshevDistance(*it, client.viewer) <= m_config.viewRadius + 1 &&
+            m_world.getChunk(*it))
+        {
+            ++it;
+            continue;
+        }
+        writeCoord(writer, *it);
+        chunkCount++;
+        it = client.known.erase(it);
+    }
+    if (chunkCount > 0)
+    {
+        writer.patchU16(1, chunkCount);
+        client.channel->send(std::move(message));
+    }
+}
+
+void ReplicationServer::sendNewChunks(Client& client)
+{
+    for (const glm::ivec3& offset : m_offsets)
+    {
+        if (client.channel->queuedBytes() >= m_config.bytesPerTick)
+        {
+            return;
+        }
+        const ChunkCoord coord = client.viewer + offset;
+        if (client.known.contains(coord))
+        {
+            continue;
+        }
+        if (const Chunk* chunk = m_world.getChunk(coord))
+        {
+            sendChunk(client, coord, *chunk);
+        }
+    }
+}
+
+size_t ReplicationServer::clientCount() const
+{
+    return m_clients.size();
+}
+
+uint64_t ReplicationServer::bytesSent(ClientId client) const
+{
+    auto it = m_clients.find(client);
+    return it != m_clients.end() ? it->second.channel->bytesSent() : 0;
+}
+
+ReplicationClient::ReplicationClient(World& world, Transport& transport)
+    : m_world(world), m_channel(transport)
+{
+}
+
+void ReplicationClient::update()
+{
+    PROFILE_ZONE("ReplicationClient::update");
+    m_loadedChunks.clear();
+    m_unloadedChunks.clear();
+    m_changes.clear();
+
+    // Incoming data is applied before acks go out with this update's sends
+    m_channel.update();
+    while (m_channel.receive(m_message))
+    {
+        ByteReader reader(m_message.data(), m_message.size());
+        switch (static_cast<ReplicationMessage>(reader.u8()))
+        {
+        case ReplicationMessage::ChunkData:
+            applyChunkData(reader);
+            break;
+        case ReplicationMessage::BlockDeltas:
+            applyDeltas(reader);
+            break;
+        case ReplicationMessage::ChunkUnload:
+            applyUnloads(reader);
+            break;
+        default:
+            throw std::runtime_error("Unknown replication message");
+        }
+    }
+}
+
+void ReplicationClient::applyChunkData(ByteReader& reader)
+{
+    const ChunkCoord coord = readCoord(reader);
+    const size_t size = reader.remaining();
+    const uint8_t* data = reader.bytes(size);
+    if (!reader.ok())
+    {
+        throw std::runtime_error("Truncated chunk data");
+    }
+
+    Chunk* chunk = m_world.getChunk(coord);
+    const bool created = !chunk;
+    if (created)
+    {
+        chunk = &m_world.createChunk(coord);
+    }
+    if (!decodeChunk(data, size, *chunk))
+    {
+        if (created)
+        {
+            m_world.removeChunk(coord);
+        }
+        throw std::runtime_error("Malformed chunk data");
+    }
+    m_loadedChunks.push_back(coord);
+}
+
+void ReplicationClient::applyDeltas(ByteReader& reader)
+{
+    const uint16_t chunkCount = reader.u16();
+    for (uint16_t c = 0; c < chunkCount && reader.ok(); c++)
+    {
+        const glm::ivec3 origin = readCoord(reader) * CHUNK_SIZE;
+        const uint16_t editCount = reader.u16();
+        for (uint16_t e = 0; e < editCount && reader.ok(); e++)
+        {
+            const uint16_t index = reader.u16();
+            const BlockId id = reader.u16();
+            const uint8_t meta = reader.u8();
+            if (index >= CHUNK_VOLUME || id >= blockCount())
+            {
+                throw std::runtime_error("Malformed block delta");
+            }
+
+            const glm::ivec3 pos = origin + localPosFromIndex(index);
+            const BlockId previous = m_world.getBlock(pos);
+            if (m_world.setBlock(pos, id, meta))
+            {
+                m_changes.push_back(BlockChange{
+                    .pos = pos,
+                    .previous = previous,
+                    .current = id,
+                });
+            }
+        }
+    }
+    if (!reader.ok())
+    {
+        throw std::runtime_error("Truncated block deltas");
+    }
+}
+
+void ReplicationClient::applyUnloads(ByteReader& reader)
+{
+    const uint16_t chunkCount = reader.u16();
+    for (uint16_t c = 0; c < chunkCount && reader.ok(); c++)
+    {
+        const ChunkCoord coord = readCoord(reader);
+        if (reader.ok() && m_world.getChunk(coord))
+        {
+            m_world.removeChunk(coord);
+            m_unloadedChunks.push_back(coord);
+        }
+    }
+    if (!reader.ok())
+    {
+        throw std::runtime_error("Truncated chunk unload");
+    }
+}
+
+const std::vector<ChunkCoord>& ReplicationClient::loadedChunks() const
+{
+    return m_loadedChunks;
+}
+
+const std::vector<ChunkCoord>& ReplicationClient::unloadedChunks() const
+{
+    return m_unloadedChunks;
+}
+
+const std::vector<BlockChange>& ReplicationClient::changes() const
+{
+    return m_changes;
+}
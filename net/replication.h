@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "net/reliable_channel.h"
+#include "world/chunk.h"
+#include "world/world.h"
+
+class ByteReader;
+
+// Server-authoritative world replication.
+//
+// A client receives every loaded chunk within the view radius of its viewer
+// once, palette encoded with encodeChunk(), nearest first. After that only
+// the blocks edited during a tick are sent, batched into one delta message
+// per client and tick. Chunks leaving the radius (plus one chunk of
+// hysteresis) or unloaded on the server are dropped on the client.
+//
+// Messages go over a ReliableChannel, so deltas always arrive after the
+// chunk data they apply to. Each client gets bytesPerTick of uplink per
+// tick: deltas are always queued, chunk data only while the channel's
+// backlog is under one tick's budget, so a fast-moving viewer cannot build
+// an unbounded queue and nearer chunks discovered later jump ahead of
+// farther ones.
+enum class ReplicationMessage : uint8_t
+{
+    // i32 x, y, z, then the encodeChunk() payload
+    ChunkData,
+    // u16 chunk count, per chunk i32 x, y, z, u16 edit count, then per
+    // edit u16 local index, u16 block id, u8 meta
+    BlockDeltas,
+    // u16 chunk count, then i32 x, y, z each
+    ChunkUnload,
+};
+
+struct ReplicationConfig
+{
+    int viewRadius{ 8 };
+    size_t bytesPerTick{ 64 * 1024 };
+};
+
+class ReplicationServer
+{
+  public:
+    using ClientId = uint32_t;
+
+    // Chunks with more edits than this in one tick are resent whole; the
+    // encoded chunk is smaller than that many 5 byte delta entries
+    static constexpr size_t FULL_RESEND_EDITS{ 1024 };
+
+  private:
+    // One tick's edits of a chunk, encoded once for all clients
+    struct ChunkEdits
+    {
+        ChunkCoord coord{ 0, 0, 0 };
+        uint16_t count{ 0 };
+        // Encoded entries, or empty when the chunk is resent whole
+        std::vector<uint8_t> entries;
+    };
+
+    struct Client
+    {
+        std::unique_ptr<ReliableChannel> channel;
+        ChunkCoord viewer{ 0, 0, 0 };
+        // Chunks sent to the client and not unloaded since
+        std::unordered_set<ChunkCoord, ChunkCoordHash> known;
+    };
+
+    World& m_world;
+    ReplicationConfig m_config;
+    std::unordered_map<ClientId, Client> m_clients;
+    ClientId m_nextClient{ 0 };
+    // Chunk offsets within the view radius, nearest first
+    std::vector<glm::ivec3> m_offsets;
+    // Local indices edited since the last update, per chunk
+    std::unordered_map<ChunkCoord, std::vector<uint16_t>, ChunkCoordHash>
+        m_edits;
+    std::vector<ChunkEdits> m_tickEdits;
+
+    void collectEdits();
+    void sendChunk(Client& client, const ChunkCoord& coord, const Chunk& chunk);
+    void sendDeltas(Client& client);
+    void sendUnloads(Client& client);
+    void sendNewChunks(Client& client);
+
+  public:
+    ReplicationServer(World& world, const ReplicationConfig& config = {});
+    ReplicationServer(const ReplicationServer&) = delete;
+    ReplicationServer& operator=(const ReplicationServer&) = delete;
+
+    // The transport must outlive the client
+    ClientId addClient(Transport& transport);
+    void removeClient(ClientId client);
+    void setViewer(ClientId client, const glm::vec3& position);
+
+    // Feed every authoritative edit, e.g. BlockSimulation::changes() and
+    // player edits, before update()
+    void onBlocksChanged(const std::vector<BlockChange>& changes);
+
+    // Once per server tick, after the world was updated
+    void update();
+
+    size_t clientCount() const;
+    uint64_t bytesSent(ClientId client) const;
+};
+
+// Applies replicated chunks and edits to a client-side world. The lists
+// below cover the last update() and feed lighting and remeshing the same
+// way the server's own streaming and simulation do.
+class ReplicationClient
+{
+  private:
+    World& m_world;
+    ReliableChannel m_channel;
+    std::vector<ChunkCoord> m_loadedChunks;
+    std::vector<ChunkCoord> m_unloadedChunks;
+    std::vector<BlockChange> m_changes;
+    std::vector<uint8_t> m_message;
+
+    void applyChunkData(ByteReader& reader);
+    void applyDeltas(ByteReader& reader);
+    void applyUnloads(ByteReader& reader);
+
+  public:
+    ReplicationClient(World& world, Transport& transport);
+    ReplicationClient(const ReplicationClient&) = delete;
+    ReplicationClient& operator=(const ReplicationClient&) = delete;
+
+    // Once per client tick; throws on malformed messages
+    void update();
+
+    const std::vector<ChunkCoord>& loadedChunks() const;
+    const std::vector<ChunkCoord>& unloadedChunks() const;
+    const std::vector<BlockChange>& changes() const;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Unreliable, unordered datagrams between two endpoints. Packets may be
+// dropped, duplicated or reordered; ReliableChannel builds ordered delivery
+// on top. Implementations never block.
+class Transport
+{
+  public:
+    // Stays under the common 1280 byte IPv6 minimum MTU after headers
+    static constexpr size_t MAX_PACKET_SIZE{ 1200 };
+
+    virtual ~Transport() = default;
+
+    virtual void send(const uint8_t* data, size_t size) = 0;
+    // Pops the next received packet into `packet`; false when none is
+    // waiting
+    virtual bool receive(std::vector<uint8_t>& packet) = 0;
+};
@@ -0,0 +1,161 @@
+#include "udp_transport.h"
+#include <stdexcept>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#if defined(_WIN32)
+constexpr uintptr_t INVALID_SOCKET_HANDLE{ INVALID_SOCKET };
+
+void closeSocket(uintptr_t socket)
+{
+    closesocket(static_cast<SOCKET>(socket));
+}
+#else
+constexpr int INVALID_SOCKET_HANDLE{ -1 };
+
+void closeSocket(int socket)
+{
+    close(socket);
+}
+#endif
+} // namespace
+
+UdpTransport::UdpTransport(uint16_t localPort)
+{
+#if defined(_WIN32)
+    WSADATA wsaData{};
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+    {
+        throw std::runtime_error("Failed to initialize Winsock");
+    }
+#endif
+
+    m_socket = static_cast<Socket>(socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP));
+    if (m_socket == INVALID_SOCKET_HANDLE)
+    {
+        throw std::runtime_error("Failed to create UDP socket");
+    }
+
+#if defined(_WIN32)
+    u_long nonBlocking = 1;
+    const bool configured = ioctlsocket(
+                                static_cast<SOCKET>(m_socket),
+                                FIONBIO,
+                                &nonBlocking
+                            ) == 0;
+#else
+    const bool configured =
+        fcntl(m_socket, F_SETFL, fcntl(m_socket, F_GETFL) | O_NONBLOCK) == 0;
+#endif
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(localPort);
+    if (!configured ||
+        bind(
+            m_socket,
+            reinterpret_cast<const sockaddr*>(&address),
+            sizeof(address)
+        ) != 0)
+    {
+        closeSocket(m_socket);
+        throw std::runtime_error("Failed to bind UDP socket");
+    }
+}
+
+UdpTransport::~UdpTransport()
+{
+    closeSocket(m_socket);
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+}
+
+void UdpTransport::connect(const std::string& host, uint16_t port)
+{
+    in_addr address{};
+    if (inet_pton(AF_INET, host.c_str(), &address) != 1)
+    {
+        throw std::runtime_error("Invalid IPv4 address: " + host);
+    }
+    m_remoteAddress = address.s_addr;
+    m_remotePort = htons(port);
+}
+
+uint16_t UdpTransport::localPort() const
+{
+    sockaddr_in address{};
+    socklen_t length = sizeof(address);
+    if (getsockname(
+            m_socket,
+            reinterpret_cast<sockaddr*>(&address),
+            &length
+        ) != 0)
+    {
+        throw std::runtime_error("Failed to query UDP socket address");
+    }
+    return ntohs(address.sin_port);
+}
+
+void UdpTransport::send(const uint8_t* data, size_t size)
+{
+    if (m_remotePort == 0)
+    {
+        return;
+    }
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = m_remoteAddress;
+    address.sin_port = m_remotePort;
+    // A full send buffer or an unreachable peer is just a lost packet
+    sendto(
+        m_socket,
+        reinterpret_cast<const char*>(data),
+        static_cast<int>(size),
+        0,
+        reinterpret_cast<const sockaddr*>(&address),
+        sizeof(address)
+    );
+}
+
+bool UdpTransport::receive(std::vector<uint8_t>& packet)
+{
+    uint8_t buffer[MAX_PACKET_SIZE];
+    for (;;)
+    {
+        sockaddr_in from{};
+        socklen_t fromLength = sizeof(from);
+        const auto received = recvfrom(
+            m_socket,
+            reinterpret_cast<char*>(buffer),
+            static_cast<int>(sizeof(buffer)),
+            0,
+            reinterpret_cast<sockaddr*>(&from),
+            &fromLength
+        );
+        if (received < 0)
+        {
+            // Would block, or an ICMP error from an earlier send
+            return false;
+        }
+        if (from.sin_addr.s_addr == m_remoteAddress &&
+            from.sin_port == m_remotePort)
+        {
+            packet.assign(buffer, buffer + received);
+            return true;
+        }
+    }
+}
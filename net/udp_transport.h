@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "net/transport.h"
+
+// Non-blocking UDP socket exchanging datagrams with one peer. Port 0 binds
+// an ephemeral port, see localPort(); the peer can be set later, so two
+// sockets on 127.0.0.1 can be wired to each other for loopback tests.
+// Setup errors throw; send errors are treated as packet loss.
+class UdpTransport : public Transport
+{
+  private:
+#if defined(_WIN32)
+    using Socket = uintptr_t;
+#else
+    using Socket = int;
+#endif
+
+    Socket m_socket;
+    // Network byte order; the port is 0 until connect()
+    uint32_t m_remoteAddress{ 0 };
+    uint16_t m_remotePort{ 0 };
+
+  public:
+    explicit UdpTransport(uint16_t localPort = 0);
+    ~UdpTransport() override;
+    UdpTransport(const UdpTransport&) = delete;
+    UdpTransport& operator=(const UdpTransport&) = delete;
+
+    // IPv4 dotted address, e.g. "127.0.0.1"
+    void connect(const std::string& host, uint16_t port);
+    uint16_t localPort() const;
+
+    void send(const uint8_t* data, size_t size) override;
+    // Only datagrams from the connected peer are returned
+    bool receive(std::vector<uint8_t>& packet) override;
+};
@@ -0,0 +1,219 @@
+#version 460
+#extension GL_EXT_buffer_reference : require
+
+// Forward shading for chunk meshes. Sky light comes baked into the
+// vertices and is shadowed from the sun by ShadowCascades; block lights are
+// the point lights binned by light_cluster.comp, and only those of the
+// fragment's own cluster are evaluated. With TRANSLUCENT set the result goes
+// to TransparencyPass's accumulation and revealage targets instead, for
+// weighted blended order-independent transparency.
+
+const uint CLUSTERS_X = 16u;
+const uint CLUSTERS_Y = 9u;
+const uint CLUSTERS_Z = 24u;
+const uint CLUSTER_COUNT = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+const uint MAX_LIGHTS_PER_CLUSTER = 128u;
+const uint CASCADE_COUNT = 4u;
+
+struct PointLight
+{
+    vec4 positionRadius;
+    vec4 color;
+};
+
+layout(buffer_reference, std430, buffer_reference_align = 4)
+readonly buffer ClusterBuffer
+{
+    uint lightCounts[CLUSTER_COUNT];
+    uint lightIndices[];
+};
+
+layout(buffer_reference, std430, buffer_reference_align = 16)
+readonly buffer LightFrame
+{
+    mat4 view;
+    vec2 tanHalfFov;
+    vec2 tileSize;
+    vec2 screenSize;
+    float sliceScale;
+    float sliceBias;
+    uint lightCount;
+    uint pad;
+    ClusterBuffer clusters;
+    PointLight lights[];
+};
+
+layout(buffer_reference, std430, buffer_reference_align = 16)
+readonly buffer ShadowFrame
+{
+    mat4 lightView;
+    vec4 sunDirection;
+    // Window origin in texels, texel size in blocks, unused
+    vec4 cascades[CASCADE_COUNT];
+    float depthAnchor;
+    float depthRange;
+    float resolution;
+    uint pad;
+};
+
+layout(buffer_reference) buffer VertexBuffer;
+
+layout(push_constant) uniform PushConstants
+{
+    mat4 viewProjection;
+    LightFrame frame;
+    ShadowFrame shadows;
+    ivec3 chunkOrigin;
+    VertexBuffer vertexBuffer;
+};
+
+// Cascades wrapped toroidally; REPEAT addressing unwraps them
+layout(set = 0, binding = 0) uniform sampler2DArrayShadow shadowMap;
+
+layout(location = 0) in vec3 inWorldPos;
+layout(location = 1) in vec2 inLight;
+layout(location = 2) flat in uint inFace;
+layout(location = 3) flat in uint inBlock;
+
+// The translucent pipeline of ChunkRenderer specializes this
+layout(constant_id = 0) const bool TRANSLUCENT = false;
+
+// Scene colour, or premultiplied colour times weight when TRANSLUCENT
+layout(location = 0) out vec4 outColor;
+// Only bound when TRANSLUCENT
+layout(location = 1) out float outRevealage;
+
+// BlockFace order
+const vec3 FACE_NORMAL[6] = vec3[](
+    vec3(1, 0, 0), vec3(-1, 0, 0), vec3(0, 1, 0),
+    vec3(0, -1, 0), vec3(0, 0, 1), vec3(0, 0, -1)
+);
+
+// Linear albedo by block id, Blocks::AIR to Blocks::GLOWSTONE
+const vec3 BLOCK_COLOR[12] = vec3[](
+    vec3(1.00, 0.00, 1.00), vec3(0.40, 0.40, 0.42), vec3(0.35, 0.22, 0.12),
+    vec3(0.25, 0.50, 0.15), vec3(0.85, 0.78, 0.55), vec3(0.45, 0.43, 0.42),
+    vec3(0.10, 0.25, 0.60), vec3(1.00, 0.40, 0.08), vec3(0.80, 0.90, 0.95),
+    vec3(0.15, 0.40, 0.10), vec3(1.00, 0.80, 0.45), vec3(1.00, 0.85, 0.50)
+);
+// Coverage of the translucent blocks; the others are opaque
+const float BLOCK_ALPHA[12] = float[](
+    1.00, 1.00, 1.00, 1.00, 1.00, 1.00,
+    0.55, 1.00, 0.25, 0.80, 1.00, 1.00
+);
+const uint LAVA = 7u;
+const uint TORCH = 10u;
+const uint GLOWSTONE = 11u;
+
+const vec3 SUN_COLOR = vec3(1.00, 0.95, 0.85);
+const vec3 AMBIENT = vec3(0.02, 0.02, 0.03);
+
+uint clusterIndex(vec3 worldPos)
+{
+    uvec2 tile = min(
+        uvec2(gl_FragCoord.xy / frame.tileSize),
+        uvec2(CLUSTERS_X - 1u, CLUSTERS_Y - 1u)
+    );
+    float depth = max(-(frame.view * vec4(worldPos, 1.0)).z, 1e-3);
+    uint slice = uint(clamp(
+        log(depth) * frame.sliceScale + frame.sliceBias,
+        0.0,
+        float(CLUSTERS_Z - 1u)
+    ));
+    return tile.x + tile.y * CLUSTERS_X + slice * CLUSTERS_X * CLUSTERS_Y;
+}
+
+// 1 where the sun reaches the fragment; the first cascade whose window
+// holds it wins, and beyond the last one everything is lit
+float sunVisibility(vec3 worldPos, vec3 normal)
+{
+    for (uint i = 0u; i < CASCADE_COUNT; i++)
+    {
+        vec4 cascade = shadows.cascades[i];
+        // Pushing out along the normal keeps flat ground from self-shadowing
+        vec3 lightPos = (shadows.lightView *
+                         vec4(worldPos + normal * cascade.z * 1.5, 1.0))
+                            .xyz;
+        vec2 texel = lightPos.xy / cascade.z;
+        vec2 window = texel - cascade.xy;
+        if (any(lessThan(window, vec2(2.0))) ||
+            any(greaterThanEqual(window, vec2(shadows.resolution - 2.0))))
+        {
+            continue;
+        }
+
+        float depth = (shadows.depthAnchor + shadows.depthRange - lightPos.z) /
+                      (2.0 * shadows.depthRange);
+        return texture(
+            shadowMap,
+            vec4(texel / shadows.resolution, float(i), depth)
+        );
+    }
+    return 1.0;
+}
+
+void writeColor(vec3 color)
+{
+    if (!TRANSLUCENT)
+    {
+        outColor = vec4(color, 1.0);
+        return;
+    }
+    // McGuire and Bavoil's depth weight: near layers dominate the blend
+    // without any sorting
+    float alpha = BLOCK_ALPHA[min(inBlock, 11u)];
+    float depth = -(frame.view * vec4(inWorldPos, 1.0)).z;
+    float weight = alpha * clamp(
+        10.0 / (1e-5 + pow(depth / 5.0, 2.0) + pow(depth / 200.0, 6.0)),
+        1e-2,
+        3e3
+    );
+    outColor = vec4(color * alpha, alpha) * weight;
+    outRevealage = alpha;
+}
+
+void main()
+{
+    vec3 albedo = BLOCK_COLOR[min(inBlock, 11u)];
+    if (inBlock == LAVA || inBlock == TORCH || inBlock == GLOWSTONE)
+    {
+        writeColor(albedo);
+        return;
+    }
+
+    vec3 normal = FACE_NORMAL[min(inFace, 5u)];
+    float sky = inLight.x;
+    float sunFacing = max(dot(normal, shadows.sunDirection.xyz), 0.0);
+    if (sunFacing > 0.0)
+    {
+        sunFacing *= sunVisibility(inWorldPos, normal);
+    }
+    vec3 lighting = AMBIENT + SUN_COLOR * sky * sky * (0.3 + 0.7 * sunFacing);
+
+    uint cluster = clusterIndex(inWorldPos);
+    uint count = frame.clusters.lightCounts[cluster];
+    uint base = cluster * MAX_LIGHTS_PER_CLUSTER;
+    vec3 blockLighting = vec3(0.0);
+    for (uint i = 0u; i < count; i++)
+    {
+        PointLight light = frame.lights[frame.clusters.lightIndices[base + i]];
+        vec3 toLight = light.positionRadius.xyz - inWorldPos;
+        float distance = length(toLight);
+        float radius = light.positionRadius.w;
+        if (distance >= radius)
+        {
+            continue;
+        }
+        float falloff = 1.0 - distance / radius;
+        float facing = distance > 1e-4
+                           ? max(dot(normal, toLight / distance), 0.0)
+                           : 1.0;
+        blockLighting += light.color.rgb * falloff * falloff * facing;
+    }
+    // Point lights cast no shadows; the flood-filled block light is zero
+    // wherever walls stop it, so it masks the leaks
+    lighting += blockLighting * smoothstep(0.0, 3.0 / 15.0, inLight.y);
+
+    vec3 color = albedo * lighting;
+    writeColor(1.0 - exp(-color * 1.5));
+}
@@ -0,0 +1,47 @@
+#version 460
+#extension GL_EXT_buffer_reference : require
+
+// Pulls ChunkVertex through the mesh's device address; see world/mesher.h
+// for the packing. The shared index buffer supplies gl_VertexIndex.
+
+layout(buffer_reference, std430, buffer_reference_align = 8)
+readonly buffer VertexBuffer
+{
+    uvec2 vertices[];
+};
+
+// Only read by the fragment shader
+layout(buffer_reference) buffer LightFrame;
+layout(buffer_reference) buffer ShadowFrame;
+
+layout(push_constant) uniform PushConstants
+{
+    mat4 viewProjection;
+    LightFrame frame;
+    ShadowFrame shadows;
+    ivec3 chunkOrigin;
+    VertexBuffer vertexBuffer;
+};
+
+layout(location = 0) out vec3 outWorldPos;
+layout(location = 1) out vec2 outLight; // sky, block in 0..1
+layout(location = 2) flat out uint outFace;
+layout(location = 3) flat out uint outBlock;
+
+void main()
+{
+    uvec2 vertex = vertexBuffer.vertices[gl_VertexIndex];
+    uvec3 local = uvec3(
+        vertex.x & 63u,
+        (vertex.x >> 6) & 63u,
+        (vertex.x >> 12) & 63u
+    );
+    vec3 worldPos = vec3(chunkOrigin) + vec3(local);
+
+    uint light = (vertex.y >> 16) & 0xFFu;
+    outWorldPos = worldPos;
+    outLight = vec2(light >> 4, light & 15u) / 15.0;
+    outFace = (vertex.x >> 18) & 7u;
+    outBlock = vertex.y & 0xFFFFu;
+    gl_Position = viewProjection * vec4(worldPos, 1.0);
+}
@@ -0,0 +1,12 @@
+#version 460
+
+// One triangle covering the screen, for the upscale and the transparency
+// composite; the vertex index alone places it, so nothing is bound.
+
+layout(location = 0) out vec2 screenUv;
+
+void main()
+{
+    screenUv = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+    gl_Position = vec4(screenUv * 2.0 - 1.0, 0.0, 1.0);
+}
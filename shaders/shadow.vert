@@ -0,0 +1,34 @@
+#version 460
+#extension GL_EXT_buffer_reference : require
+
+// Depth-only pass for ShadowCascades. Drawn without an index buffer:
+// every six vertices expand to one quad of the chunk mesh, using the same
+// 0-1-2 0-2-3 pattern as ChunkRenderer's index buffer.
+
+layout(buffer_reference, std430, buffer_reference_align = 8)
+readonly buffer VertexBuffer
+{
+    uvec2 vertices[];
+};
+
+layout(push_constant) uniform PushConstants
+{
+    mat4 viewProjection;
+    VertexBuffer vertexBuffer;
+    ivec3 chunkOrigin;
+};
+
+const uint QUAD_CORNER[6] = uint[](0u, 1u, 2u, 0u, 2u, 3u);
+
+void main()
+{
+    uint quad = uint(gl_VertexIndex) / 6u;
+    uint corner = QUAD_CORNER[uint(gl_VertexIndex) % 6u];
+    uvec2 vertex = vertexBuffer.vertices[quad * 4u + corner];
+    uvec3 local = uvec3(
+        vertex.x & 63u,
+        (vertex.x >> 6) & 63u,
+        (vertex.x >> 12) & 63u
+    );
+    gl_Position = viewProjection * vec4(vec3(chunkOrigin) + vec3(local), 1.0);
+}
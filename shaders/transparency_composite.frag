@@ -0,0 +1,30 @@
+#version 460
+
+// Resolves TransparencyPass over the opaque scene: the weighted average of
+// the translucent layers, blended by how much of the background they hide.
+// Both targets match the scene pixel for pixel, so texels are fetched
+// directly.
+
+layout(set = 0, binding = 0) uniform sampler2D accumulation;
+layout(set = 0, binding = 1) uniform sampler2D revealage;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float revealed = texelFetch(revealage, texel, 0).r;
+    if (revealed >= 1.0)
+    {
+        discard;
+    }
+
+    vec4 accum = texelFetch(accumulation, texel, 0);
+    // Half floats overflow under many near layers; saturate those pixels
+    if (any(isinf(accum.rgb)))
+    {
+        accum.rgb = vec3(accum.a);
+    }
+    vec3 average = accum.rgb / max(accum.a, 1e-5);
+    outColor = vec4(average, 1.0 - revealed);
+}
@@ -0,0 +1,44 @@
+#version 460
+
+// Stretches the scene's render extent over the swapchain image, then
+// sharpens with AMD's contrast-adaptive sharpening: a negative-lobe cross
+// filter whose strength falls off where the neighbourhood already spans
+// most of the range, so edges do not ring and flat areas stay noise free.
+
+layout(location = 0) in vec2 screenUv;
+layout(location = 0) out vec4 outColor;
+
+layout(set = 0, binding = 0) uniform sampler2D scene;
+
+layout(push_constant) uniform PushConstants
+{
+    vec2 uvScale;
+    vec2 uvMax;
+    vec2 texelSize;
+    float sharpness;
+};
+
+// Keeps bilinear taps off the unused part of the target
+vec3 fetch(vec2 uv)
+{
+    return texture(scene, min(uv, uvMax)).rgb;
+}
+
+void main()
+{
+    vec2 uv = screenUv * uvScale;
+    vec3 center = fetch(uv);
+    vec3 north = fetch(uv - vec2(0.0, texelSize.y));
+    vec3 south = fetch(uv + vec2(0.0, texelSize.y));
+    vec3 west = fetch(uv - vec2(texelSize.x, 0.0));
+    vec3 east = fetch(uv + vec2(texelSize.x, 0.0));
+
+    vec3 lo = min(center, min(min(north, south), min(west, east)));
+    vec3 hi = max(center, max(max(north, south), max(west, east)));
+    vec3 amount = sqrt(clamp(min(lo, 1.0 - hi) / max(hi, 1e-4), 0.0, 1.0));
+    vec3 weight = amount * mix(-0.125, -0.2, sharpness);
+
+    vec3 color = (center + (north + south + west + east) * weight) /
+                 (1.0 + 4.0 * weight);
+    outColor = vec4(clamp(color, 0.0, 1.0), 1.0);
+}
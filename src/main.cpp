@@ -1,9 +1,55 @@
+#include "../core/jobs/job_system.h"
 #include "../core/platform/window.h"
+#include "../core/profiling/profiler.h"
+#include "../core/profiling/startup_timeline.h"
+#include "../gfx/camera.h"
+#include "../gfx/vulkan/chunk_renderer.h"
+#include "../gfx/vulkan/clustered_lighting.h"
 #include "../gfx/vulkan/context.h"
+#include "../gfx/vulkan/dynamic_resolution.h"
+#include "../gfx/vulkan/gpu_mesher.h"
+#include "../gfx/vulkan/memory_manager.h"
+#include "../gfx/vulkan/mesh_arena.h"
+#include "../gfx/vulkan/shadow_cascades.h"
+#include "../gfx/vulkan/transparency_pass.h"
+#include "../world/block.h"
+#include "../world/lighting.h"
+#include "../world/simulation.h"
+#include "../world/simulation_thread.h"
+#include "../world/visibility.h"
+#include "../world/world.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+constexpr size_t MAX_CPU_MESHES_PER_FRAME{ 8 };
+constexpr float VERTICAL_FOV{ 1.2f }; // radians
+constexpr float NEAR_PLANE{ 0.1f };
+constexpr float FAR_PLANE{ 1024.0f };
+constexpr VkClearColorValue SKY_COLOR{ { 0.45f, 0.62f, 0.86f, 1.0f } };
+constexpr float TARGET_GPU_FRAME_MS{ 1000.0f / 60.0f };
+// Evicted chunks asked back per frame, so a burst of returns does not
+// overshoot the budget before the next sample
+constexpr size_t MAX_RETURNING_CHUNKS_PER_FRAME{ 16 };
+
+namespace
+{
+int64_t distanceSquared(const ChunkCoord& a, const ChunkCoord& b)
+{
+    const glm::ivec3 d = a - b;
+    return int64_t{ d.x } * d.x + int64_t{ d.y } * d.y + int64_t{ d.z } * d.z;
+}
+} // namespace
 
 int main()
 {
+    StartupTimeline::get();
     std::cout << "We are all alone on life's journey, held captive by the "
                  "limitations of human consciousness.\n";
 
@@ -12,14 +58,341 @@ int main()
         .height = 480,
         .title = "V12",
     };
-    Window window(windowConfig);
+    PROFILE_THREAD_NAME("main");
+    // Nothing registers block types yet, but the tables are final from here
+    freezeBlockRegistry();
 
+    // Workers create the Vulkan instance and read the pipeline cache while
+    // this thread opens the window
+    JobSystem jobs;
+    Window::initPlatform();
+    // The pipeline cache lives next to the executable rather than in
+    // whatever directory it was launched from
+    std::string pipelineCachePath;
+    if (const char* basePath = SDL_GetBasePath())
+    {
+        pipelineCachePath = std::string(basePath) + "pipeline_cache.bin";
+    }
     VulkanContext ctx;
+    ctx.beginInit(
+        jobs,
+        VulkanContextConfig{
+            .validation = validationFromEnvironment(),
+            .pipelineCachePath = pipelineCachePath,
+        }
+    );
+    Window window(windowConfig);
     ctx.init(window);
 
+    GpuMemoryManager gpuMemory;
+    MeshArena meshArena;
+    meshArena.init(ctx.getDevice(), ctx.getAllocator(), &gpuMemory);
+    gpuMemory.init(ctx.getAllocator(), meshArena);
+
+    // Meshes are evicted farthest-first from the viewer's chunk. Evicted
+    // chunks are remembered with their distance at the time and remeshed
+    // once the viewer has come nearer and there is room again.
+    ChunkCoord viewerChunk{ 0, 0, 0 };
+    std::vector<ChunkCoord> newlyEvicted;
+    std::unordered_map<ChunkCoord, int64_t, ChunkCoordHash> evictedChunks;
+    gpuMemory.setEvictionHandler([&](uint64_t bytesToFree) {
+        meshArena.evictFarthest(viewerChunk, bytesToFree, &newlyEvicted);
+    });
+
+    // VOXEL_GPU_MESHING=1 meshes chunks in a compute shader instead;
+    // VOXEL_GPU_MESHING=verify also checks every mesh against the CPU mesher
+    std::unique_ptr<GpuMesher> gpuMesher;
+    if (const char* gpuMeshing = std::getenv("VOXEL_GPU_MESHING"))
+    {
+        if (ctx.supportsSubgroupArithmetic())
+        {
+            gpuMesher = std::make_unique<GpuMesher>();
+            gpuMesher->init(
+                ctx.getDevice(),
+                ctx.getAllocator(),
+                ctx.getPipelineCache(),
+                meshArena,
+                GpuMesherConfig{
+                    .verify = std::strcmp(gpuMeshing, "verify") == 0,
+                }
+            );
+        }
+        else
+        {
+            std::cout << "GPU meshing needs subgroup arithmetic in compute "
+                         "shaders, using the CPU mesher\n";
+        }
+    }
+
+    ClusteredLighting clusteredLighting;
+    clusteredLighting.init(
+        ctx.getDevice(),
+        ctx.getAllocator(),
+        ctx.getPipelineCache()
+    );
+    ShadowCascades shadows;
+    shadows.init(ctx.getDevice(), ctx.getAllocator(), ctx.getPipelineCache());
+    // Scene targets are sized for the whole display up front, so resizing
+    // the window never reallocates them
+    const glm::ivec2 displaySize = window.displaySizeInPixels();
+    const VkExtent2D swapchainExtent = ctx.getSwapchainExtent();
+    const VkExtent2D maxSceneExtent{
+        .width = std::max(
+            static_cast<uint32_t>(displaySize.x),
+            swapchainExtent.width
+        ),
+        .height = std::max(
+            static_cast<uint32_t>(displaySize.y),
+            swapchainExtent.height
+        ),
+    };
+    DynamicResolution dynamicResolution;
+    dynamicResolution.init(
+        ctx.getDevice(),
+        ctx.getAllocator(),
+        ctx.getPipelineCache(),
+        ctx.getSwapchainFormat(),
+        ctx.getDepthFormat(),
+        maxSceneExtent,
+        DynamicResolutionConfig{ .targetFrameMs = TARGET_GPU_FRAME_MS }
+    );
+    TransparencyPass transparency;
+    transparency.init(
+        ctx.getDevice(),
+        ctx.getAllocator(),
+        ctx.getPipelineCache(),
+        ctx.getSwapchainFormat(),
+        maxSceneExtent
+    );
+    ChunkRenderer chunkRenderer;
+    chunkRenderer.init(
+        ctx.getDevice(),
+        ctx.getAllocator(),
+        ctx.getPipelineCache(),
+        ctx.getSwapchainFormat(),
+        ctx.getDepthFormat(),
+        shadows.descriptorSetLayout()
+    );
+
+    World world;
+    BlockSimulation simulation(world, jobs);
+    LightEngine lighting(world, jobs);
+
+    // The world belongs to the simulation thread from here on; this thread
+    // only sees snapshots and neighbourhood copies
+    InputQueue input;
+    SimulationThread simulationThread(
+        world,
+        simulation,
+        lighting,
+        jobs,
+        input
+    );
+    simulationThread.start();
+
+    std::deque<MeshRequest> remeshQueue;
+    ChunkNeighborhood neighborhood;
+    ChunkMesh mesh;
+    ChunkVisibility visibility;
+    // Chunks reachable from the camera this frame, nearest first; the draw
+    // list for chunk passes
+    std::vector<ChunkCoord> visibleChunks;
+    bool firstFrame{ true };
+
     while (!window.shouldClose())
     {
-        window.pollEvents();
+        PROFILE_ZONE("frame");
+        window.pollEvents(input);
+
+        const ViewerState viewer = simulationThread.interpolatedViewer(
+            std::chrono::steady_clock::now()
+        );
+        viewerChunk = toChunkCoord(glm::ivec3(glm::floor(viewer.position)));
+
+        for (MeshRequest& request : simulationThread.takeMeshRequests())
+        {
+            evictedChunks.erase(request.coord);
+            remeshQueue.push_back(std::move(request));
+        }
+
+        if (VkCommandBuffer cmd = ctx.beginFrame(window))
+        {
+            meshArena.beginFrame(ctx.getCurrentFrame());
+
+            // The GPU path takes a batch per frame, the CPU path a few
+            // chunks; the rest waits for later frames
+            for (size_t meshed = 0; !remeshQueue.empty(); meshed++)
+            {
+                MeshRequest& request = remeshQueue.front();
+                if (!request.neighborhood)
+                {
+                    meshArena.remove(request.coord);
+                    visibility.remove(request.coord);
+                    clusteredLighting.remove(request.coord);
+                    remeshQueue.pop_front();
+                    continue;
+                }
+                if (gpuMesher)
+                {
+                    neighborhood.gather(*request.neighborhood);
+                    if (!gpuMesher->submit(request.coord, neighborhood))
+                    {
+                        break;
+                    }
+                }
+                else if (meshed < MAX_CPU_MESHES_PER_FRAME)
+                {
+                    neighborhood.gather(*request.neighborhood);
+                    meshChunk(neighborhood, mesh);
+                    // Over budget: keep the request at the front and retry
+                    // once eviction has made room
+                    if (!meshArena.upload(cmd, request.coord, mesh))
+                    {
+                        break;
+                    }
+                }
+                else
+                {
+                    break;
+                }
+                visibility.update(
+                    request.coord,
+                    computeConnectivity(neighborhood)
+                );
+                clusteredLighting.update(request.coord, neighborhood);
+                remeshQueue.pop_front();
+            }
+            if (gpuMesher)
+            {
+                gpuMesher->record(cmd, ctx.getCurrentFrame());
+                // Refused bytes make the next update() evict, so the
+                // fresh requests find room
+                simulationThread.requestRemesh(gpuMesher->takeRefused());
+            }
+
+            // Evictions and defragmentation moves land before this frame's
+            // draws read the meshes
+            gpuMemory.update(cmd);
+            shadows.onMeshesChanged(meshArena, meshArena.takeChangedChunks());
+            for (const ChunkCoord& coord : newlyEvicted)
+            {
+                evictedChunks[coord] = distanceSquared(coord, viewerChunk);
+            }
+            newlyEvicted.clear();
+            if (!evictedChunks.empty() && gpuMemory.hasHeadroom())
+            {
+                std::vector<ChunkCoord> returning;
+                for (auto it = evictedChunks.begin();
+                     it != evictedChunks.end() &&
+                     returning.size() < MAX_RETURNING_CHUNKS_PER_FRAME;)
+                {
+                    if (distanceSquared(it->first, viewerChunk) < it->second)
+                    {
+                        returning.push_back(it->first);
+                        it = evictedChunks.erase(it);
+                    }
+                    else
+                    {
+                        ++it;
+                    }
+                }
+                simulationThread.requestRemesh(returning);
+            }
+
+            // Caves and sealed rooms the camera cannot see into are dropped
+            // before any GPU work is recorded for them
+            visibility.findVisible(viewer.position, visibleChunks);
+
+            // The scene is drawn at a fraction of the swapchain size and
+            // stretched back over it, so the aspect stays the swapchain's
+            const VkExtent2D extent = ctx.getSwapchainExtent();
+            dynamicResolution.update(ctx.getGpuFrameMs(), extent);
+            const Camera camera = Camera::perspective(
+                viewer.position,
+                viewer.yaw,
+                viewer.pitch,
+                static_cast<float>(extent.width) /
+                    static_cast<float>(extent.height),
+                VERTICAL_FOV,
+                NEAR_PLANE,
+                FAR_PLANE
+            );
+            const uint32_t frameIndex = ctx.getCurrentFrame();
+            {
+                PROFILE_GPU_ZONE(ctx.getGpuProfiler(), cmd, "shadows");
+                shadows.record(cmd, frameIndex, viewer.position, meshArena);
+            }
+            {
+                PROFILE_GPU_ZONE(ctx.getGpuProfiler(), cmd, "light clusters");
+                clusteredLighting.record(
+                    cmd,
+                    frameIndex,
+                    camera,
+                    dynamicResolution.renderExtent(),
+                    visibleChunks
+                );
+            }
+            {
+                PROFILE_GPU_ZONE(ctx.getGpuProfiler(), cmd, "chunks");
+                dynamicResolution.beginRendering(cmd, SKY_COLOR);
+                chunkRenderer.draw(
+                    cmd,
+                    meshArena,
+                    visibleChunks,
+                    camera,
+                    ChunkShading{
+                        .lights = clusteredLighting.frameAddress(frameIndex),
+                        .shadows = shadows.frameAddress(frameIndex),
+                        .shadowMap = shadows.descriptorSet(),
+                    }
+                );
+                dynamicResolution.endRendering(cmd);
+            }
+            {
+                PROFILE_GPU_ZONE(ctx.getGpuProfiler(), cmd, "translucency");
+                transparency.beginRendering(
+                    cmd,
+                    dynamicResolution.depthView(),
+                    dynamicResolution.renderExtent()
+                );
+                chunkRenderer.drawTranslucent(
+                    cmd,
+                    meshArena,
+                    visibleChunks,
+                    camera,
+                    ChunkShading{
+                        .lights = clusteredLighting.frameAddress(frameIndex),
+                        .shadows = shadows.frameAddress(frameIndex),
+                        .shadowMap = shadows.descriptorSet(),
+                    }
+                );
+                transparency.endRendering(cmd);
+                dynamicResolution.continueRendering(cmd);
+                transparency.composite(cmd);
+                dynamicResolution.endRendering(cmd);
+            }
+            {
+                PROFILE_GPU_ZONE(ctx.getGpuProfiler(), cmd, "upscale");
+                dynamicResolution.upscale(cmd, ctx);
+            }
+            ctx.endFrame(window);
+
+            if (firstFrame)
+            {
+                StartupTimeline::get().finish();
+                StartupTimeline::get().report(std::cout);
+                firstFrame = false;
+            }
+        }
+        Profiler::get().collect();
+    }
+    simulationThread.stop();
+    vkDeviceWaitIdle(ctx.getDevice());
+
+    // VOXEL_TRACE=trace.json dumps the session for chrome://tracing/Perfetto
+    if (const char* tracePath = std::getenv("VOXEL_TRACE"))
+    {
+        Profiler::get().writeChromeTrace(tracePath);
     }
 
     return 0;
@@ -0,0 +1,130 @@
+#include "block.h"
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+constexpr BlockTables builtinTables()
+{
+    BlockTables tables{ .count = Blocks::BUILTIN_COUNT };
+    for (BlockId id = 0; id < Blocks::BUILTIN_COUNT; id++)
+    {
+        tables.set(id, BUILTIN_BLOCKS[id]);
+    }
+    return tables;
+}
+
+struct RegisteredBlock
+{
+    std::string name;
+    BlockType type;
+};
+
+std::mutex g_blockMutex;
+// Ids from Blocks::BUILTIN_COUNT on
+std::vector<RegisteredBlock> g_registeredBlocks;
+bool g_blockRegistryFrozen{ false };
+} // namespace
+
+constinit BlockTables g_blockTables{ builtinTables() };
+
+BlockId registerBlockType(const BlockType& type)
+{
+    std::lock_guard lock(g_blockMutex);
+    if (g_blockRegistryFrozen)
+    {
+        throw std::runtime_error(
+            "block type registered after the registry was frozen"
+        );
+    }
+    if (Blocks::BUILTIN_COUNT + g_registeredBlocks.size() == MAX_BLOCKS)
+    {
+        throw std::runtime_error("Too many block types");
+    }
+    if (type.name.empty())
+    {
+        throw std::runtime_error("block type needs a name");
+    }
+    for (const BlockType& builtin : BUILTIN_BLOCKS)
+    {
+        if (builtin.name == type.name)
+        {
+            throw std::runtime_error(
+                "block type " + std::string(type.name) + " already exists"
+            );
+        }
+    }
+    for (const RegisteredBlock& block : g_registeredBlocks)
+    {
+        if (block.name == type.name)
+        {
+            throw std::runtime_error(
+                "block type " + std::string(type.name) + " already exists"
+            );
+        }
+    }
+
+    RegisteredBlock block{ .name = std::string(type.name), .type = type };
+    block.type.name = {};
+    g_registeredBlocks.push_back(std::move(block));
+    return static_cast<BlockId>(
+        Blocks::BUILTIN_COUNT + g_registeredBlocks.size() - 1
+    );
+}
+
+void freezeBlockRegistry()
+{
+    std::lock_guard lock(g_blockMutex);
+    if (g_blockRegistryFrozen)
+    {
+        return;
+    }
+
+    BlockTables tables{ builtinTables() };
+    for (size_t i = 0; i < g_registeredBlocks.size(); i++)
+    {
+        tables.set(
+            static_cast<BlockId>(Blocks::BUILTIN_COUNT + i),
+            g_registeredBlocks[i].type
+        );
+    }
+    tables.count = static_cast<uint32_t>(
+        Blocks::BUILTIN_COUNT + g_registeredBlocks.size()
+    );
+    g_blockTables = tables;
+    g_blockRegistryFrozen = true;
+}
+
+std::string_view blockName(BlockId id)
+{
+    if (id < Blocks::BUILTIN_COUNT)
+    {
+        return BUILTIN_BLOCKS[id].name;
+    }
+    std::lock_guard lock(g_blockMutex);
+    const size_t index = id - Blocks::BUILTIN_COUNT;
+    return index < g_registeredBlocks.size() ? g_registeredBlocks[index].name
+                                             : std::string_view{};
+}
+
+std::optional<BlockId> findBlock(std::string_view name)
+{
+    for (BlockId id = 0; id < Blocks::BUILTIN_COUNT; id++)
+    {
+        if (BUILTIN_BLOCKS[id].name == name)
+        {
+            return id;
+        }
+    }
+    std::lock_guard lock(g_blockMutex);
+    for (size_t i = 0; i < g_registeredBlocks.size(); i++)
+    {
+        if (g_registeredBlocks[i].name == name)
+        {
+            return static_cast<BlockId>(Blocks::BUILTIN_COUNT + i);
+        }
+    }
+    return std::nullopt;
+}
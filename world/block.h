@@ -0,0 +1,192 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+using BlockId = uint16_t;
+
+namespace Blocks
+{
+constexpr BlockId AIR{ 0 };
+constexpr BlockId STONE{ 1 };
+constexpr BlockId DIRT{ 2 };
+constexpr BlockId GRASS{ 3 };
+constexpr BlockId SAND{ 4 };
+constexpr BlockId GRAVEL{ 5 };
+constexpr BlockId WATER{ 6 };
+constexpr BlockId LAVA{ 7 };
+constexpr BlockId GLASS{ 8 };
+constexpr BlockId LEAVES{ 9 };
+constexpr BlockId TORCH{ 10 };
+constexpr BlockId GLOWSTONE{ 11 };
+// Registered types follow the built-in ones
+constexpr BlockId BUILTIN_COUNT{ 12 };
+} // namespace Blocks
+
+// Capacity of the block tables; the GPU mesher's opacity mask covers the
+// same ids
+constexpr uint32_t MAX_BLOCKS{ 128 };
+
+// Fluid metadata: low 3 bits hold the flow distance from a source
+// (0 = source, 7 = weakest), FLUID_FALLING marks a column fed from above.
+constexpr uint8_t FLUID_LEVEL_MASK{ 0x7 };
+constexpr uint8_t FLUID_FALLING{ 0x8 };
+constexpr uint8_t FLUID_MAX_LEVEL{ 7 };
+
+struct BlockType
+{
+    std::string_view name;
+    // Full cube that blocks light and hides the faces of its neighbours
+    bool opaque{ false };
+    // See-through faces, blended in the order-independent transparency
+    // pass instead of drawn with the opaque geometry
+    bool translucent{ false };
+    bool fluid{ false };
+    bool fallsWithGravity{ false };
+    // Fluids and falling blocks are allowed to overwrite it
+    bool replaceable{ false };
+    uint8_t lightEmission{ 0 };
+    // Extra attenuation on top of the one level lost per step
+    uint8_t lightFilter{ 0 };
+    // Ticks between fluid spreading steps (20 ticks per second)
+    uint32_t fluidFlowDelay{ 5 };
+    // Linear 0xRRGGBB colour of the emitted light at full strength
+    uint32_t lightColor{ 0xFFFFFF };
+};
+
+// Indexed by id
+constexpr std::array<BlockType, Blocks::BUILTIN_COUNT> BUILTIN_BLOCKS{ {
+    { .name = "air", .replaceable = true },
+    { .name = "stone", .opaque = true },
+    { .name = "dirt", .opaque = true },
+    { .name = "grass", .opaque = true },
+    { .name = "sand", .opaque = true, .fallsWithGravity = true },
+    { .name = "gravel", .opaque = true, .fallsWithGravity = true },
+    { .name = "water", .translucent = true, .fluid = true, .lightFilter = 2 },
+    { .name = "lava",
+      .opaque = true,
+      .fluid = true,
+      .lightEmission = 15,
+      .fluidFlowDelay = 30,
+      .lightColor = 0xFF6B1F },
+    { .name = "glass", .translucent = true },
+    { .name = "leaves", .translucent = true, .lightFilter = 1 },
+    { .name = "torch",
+      .replaceable = true,
+      .lightEmission = 14,
+      .lightColor = 0xFFB86B },
+    { .name = "glowstone",
+      .opaque = true,
+      .lightEmission = 15,
+      .lightColor = 0xFFDB8C },
+} };
+
+// Block properties flattened into one array per property, so the mesher
+// and light propagation index them directly per voxel. Flags are bitsets:
+// every opacity test of a meshing pass hits the same two words.
+struct BlockTables
+{
+    using Bits = std::array<uint64_t, MAX_BLOCKS / 64>;
+
+    uint32_t count{ 0 };
+    Bits opaque{};
+    Bits translucent{};
+    Bits fluid{};
+    Bits fallsWithGravity{};
+    Bits replaceable{};
+    std::array<uint8_t, MAX_BLOCKS> lightEmission{};
+    std::array<uint8_t, MAX_BLOCKS> lightFilter{};
+    std::array<uint32_t, MAX_BLOCKS> fluidFlowDelay{};
+    std::array<uint32_t, MAX_BLOCKS> lightColor{};
+
+    static constexpr bool test(const Bits& bits, BlockId id)
+    {
+        return (bits[id >> 6] >> (id & 63)) & 1;
+    }
+
+    constexpr void set(BlockId id, const BlockType& type)
+    {
+        const uint64_t bit{ uint64_t{ 1 } << (id & 63) };
+        auto assign = [&](Bits& bits, bool value) {
+            bits[id >> 6] = value ? bits[id >> 6] | bit : bits[id >> 6] & ~bit;
+        };
+        assign(opaque, type.opaque);
+        assign(translucent, type.translucent);
+        assign(fluid, type.fluid);
+        assign(fallsWithGravity, type.fallsWithGravity);
+        assign(replaceable, type.replaceable);
+        lightEmission[id] = type.lightEmission;
+        lightFilter[id] = type.lightFilter;
+        fluidFlowDelay[id] = type.fluidFlowDelay;
+        lightColor[id] = type.lightColor;
+    }
+};
+
+// Holds the built-in blocks from static initialization on; rewritten only
+// by freezeBlockRegistry()
+extern constinit BlockTables g_blockTables;
+
+// Adds a block type after the built-in ones and returns its id. Mods and
+// data files register during startup; the type becomes visible to the
+// tables below once freezeBlockRegistry() runs, and registering after that
+// throws.
+BlockId registerBlockType(const BlockType& type);
+// Publishes every registered type to g_blockTables. Call once at startup,
+// before any other thread touches blocks.
+void freezeBlockRegistry();
+
+std::string_view blockName(BlockId id);
+std::optional<BlockId> findBlock(std::string_view name);
+
+// Ids at or above this are invalid
+inline uint32_t blockCount()
+{
+    return g_blockTables.count;
+}
+
+inline bool isOpaque(BlockId id)
+{
+    return BlockTables::test(g_blockTables.opaque, id);
+}
+
+inline bool isTranslucent(BlockId id)
+{
+    return BlockTables::test(g_blockTables.translucent, id);
+}
+
+inline bool isFluid(BlockId id)
+{
+    return BlockTables::test(g_blockTables.fluid, id);
+}
+
+inline bool fallsWithGravity(BlockId id)
+{
+    return BlockTables::test(g_blockTables.fallsWithGravity, id);
+}
+
+inline bool isReplaceable(BlockId id)
+{
+    return BlockTables::test(g_blockTables.replaceable, id);
+}
+
+inline uint8_t lightEmission(BlockId id)
+{
+    return g_blockTables.lightEmission[id];
+}
+
+inline uint8_t lightFilter(BlockId id)
+{
+    return g_blockTables.lightFilter[id];
+}
+
+inline uint32_t fluidFlowDelay(BlockId id)
+{
+    return g_blockTables.fluidFlowDelay[id];
+}
+
+inline uint32_t lightColor(BlockId id)
+{
+    return g_blockTables.lightColor[id];
+}
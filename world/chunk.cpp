@@ -0,0 +1,131 @@
+#include "chunk.h"
+#include <utility>
+#include "core/jobs/epoch.h"
+
+namespace
+{
+// Drops the chunk's reference once no snapshot() can be mid-load
+void retireVersion(ChunkVersion* version)
+{
+    EpochReclaimer::get().retire(version, [](void* retired) {
+        ChunkVersion::release(static_cast<ChunkVersion*>(retired));
+    });
+}
+} // namespace
+
+void ChunkVersion::release(ChunkVersion* version)
+{
+    if (version->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        delete version;
+    }
+}
+
+ChunkSnapshot::~ChunkSnapshot()
+{
+    if (m_version)
+    {
+        ChunkVersion::release(m_version);
+    }
+}
+
+ChunkSnapshot::ChunkSnapshot(const ChunkSnapshot& other)
+    : m_version(other.m_version)
+{
+    if (m_version)
+    {
+        m_version->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+ChunkSnapshot& ChunkSnapshot::operator=(const ChunkSnapshot& other)
+{
+    ChunkSnapshot copy(other);
+    std::swap(m_version, copy.m_version);
+    return *this;
+}
+
+ChunkSnapshot::ChunkSnapshot(ChunkSnapshot&& other) noexcept
+    : m_version(std::exchange(other.m_version, nullptr))
+{
+}
+
+ChunkSnapshot& ChunkSnapshot::operator=(ChunkSnapshot&& other) noexcept
+{
+    std::swap(m_version, other.m_version);
+    return *this;
+}
+
+Chunk::Chunk(const ChunkCoord& coord)
+    : m_coord(coord), m_live(new ChunkVersion())
+{
+}
+
+Chunk::~Chunk()
+{
+    if (!m_liveShared)
+    {
+        delete m_live;
+    }
+    // Snapshots may be loading the pointer right now
+    if (ChunkVersion* published = m_published.load(std::memory_order_relaxed))
+    {
+        retireVersion(published);
+    }
+}
+
+const ChunkCoord& Chunk::coord() const
+{
+    return m_coord;
+}
+
+glm::ivec3 Chunk::worldOrigin() const
+{
+    return m_coord * CHUNK_SIZE;
+}
+
+void Chunk::unshare()
+{
+    ChunkVersion* copy = new ChunkVersion();
+    copy->data = m_live->data;
+    m_live = copy;
+    m_liveShared = false;
+}
+
+void Chunk::clearLight()
+{
+    writable().light.fill(0);
+}
+
+void Chunk::publish()
+{
+    if (m_liveShared)
+    {
+        return;
+    }
+    m_live->version = ++m_version;
+    m_liveShared = true;
+    ChunkVersion* previous =
+        m_published.exchange(m_live, std::memory_order_acq_rel);
+    if (previous)
+    {
+        retireVersion(previous);
+    }
+}
+
+ChunkSnapshot Chunk::snapshot() const
+{
+    ChunkSnapshot snapshot;
+    EpochGuard guard;
+    snapshot.m_version = m_published.load(std::memory_order_acquire);
+    if (snapshot.m_version)
+    {
+        snapshot.m_version->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+ChunkActivity& Chunk::activity()
+{
+    return m_activity;
+}
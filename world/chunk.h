@@ -0,0 +1,279 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "world/block.h"
+
+constexpr int CHUNK_SHIFT{ 5 };
+constexpr int CHUNK_SIZE{ 1 << CHUNK_SHIFT };
+constexpr int CHUNK_MASK{ CHUNK_SIZE - 1 };
+constexpr int CHUNK_AREA{ CHUNK_SIZE * CHUNK_SIZE };
+constexpr int CHUNK_VOLUME{ CHUNK_AREA * CHUNK_SIZE };
+constexpr uint8_t MAX_LIGHT_LEVEL{ 15 };
+
+using ChunkCoord = glm::ivec3;
+
+struct ChunkCoordHash
+{
+    size_t operator()(const ChunkCoord& coord) const
+    {
+        // Large odd multipliers spread neighbouring coordinates apart
+        uint64_t h = static_cast<uint32_t>(coord.x) * 0x9E3779B97F4A7C15ull;
+        h ^= static_cast<uint32_t>(coord.y) * 0xC2B2AE3D27D4EB4Full;
+        h ^= static_cast<uint32_t>(coord.z) * 0x165667B19E3779F9ull;
+        return static_cast<size_t>(h ^ (h >> 29));
+    }
+};
+
+// Arithmetic shift floors negative coordinates as required
+inline ChunkCoord toChunkCoord(const glm::ivec3& worldPos)
+{
+    return { worldPos.x >> CHUNK_SHIFT,
+             worldPos.y >> CHUNK_SHIFT,
+             worldPos.z >> CHUNK_SHIFT };
+}
+
+inline glm::ivec3 toLocalPos(const glm::ivec3& worldPos)
+{
+    return { worldPos.x & CHUNK_MASK,
+             worldPos.y & CHUNK_MASK,
+             worldPos.z & CHUNK_MASK };
+}
+
+// x varies fastest, then z, then y, so a horizontal layer is contiguous
+constexpr uint16_t localIndex(int x, int y, int z)
+{
+    return static_cast<uint16_t>(
+        x | (z << CHUNK_SHIFT) | (y << (2 * CHUNK_SHIFT))
+    );
+}
+
+inline uint16_t localIndex(const glm::ivec3& localPos)
+{
+    return localIndex(localPos.x, localPos.y, localPos.z);
+}
+
+inline glm::ivec3 localPosFromIndex(uint16_t index)
+{
+    return { index & CHUNK_MASK,
+             index >> (2 * CHUNK_SHIFT),
+             (index >> CHUNK_SHIFT) & CHUNK_MASK };
+}
+
+struct BlockChange
+{
+    glm::ivec3 pos{};
+    BlockId previous{ Blocks::AIR };
+    BlockId current{ Blocks::AIR };
+};
+
+struct ScheduledTick
+{
+    uint64_t dueTick{ 0 };
+    uint16_t index{ 0 };
+};
+
+// Per-chunk simulation work lists. Only the thread that owns the chunk's
+// phase in BlockSimulation::tick touches these, so they need no locking.
+struct ChunkActivity
+{
+    std::vector<uint16_t> pending;
+    std::bitset<CHUNK_VOLUME> pendingMask;
+    std::vector<uint16_t> processing;
+    std::vector<uint16_t> due;
+    std::vector<ScheduledTick> scheduled;
+    std::bitset<CHUNK_VOLUME> scheduledMask;
+    std::vector<BlockChange> changes;
+
+    bool hasWork() const
+    {
+        return !pending.empty() || !scheduled.empty();
+    }
+};
+
+// Block, metadata and light arrays of one chunk
+struct ChunkData
+{
+    std::array<BlockId, CHUNK_VOLUME> blocks{};
+    std::array<uint8_t, CHUNK_VOLUME> meta{};
+    // Sky light in the high nibble, block light in the low nibble
+    std::array<uint8_t, CHUNK_VOLUME> light{};
+};
+
+// Reference-counted ChunkData; immutable once published
+struct ChunkVersion
+{
+    ChunkData data;
+    uint64_t version{ 0 };
+    std::atomic<uint32_t> refs{ 1 };
+
+    static void release(ChunkVersion* version);
+};
+
+// Read-only handle to a published chunk version. Holding one keeps that
+// version alive however far the chunk moves on; copies share it.
+class ChunkSnapshot
+{
+  private:
+    ChunkVersion* m_version{ nullptr };
+
+    friend class Chunk;
+
+  public:
+    ChunkSnapshot() = default;
+    ~ChunkSnapshot();
+    ChunkSnapshot(const ChunkSnapshot& other);
+    ChunkSnapshot& operator=(const ChunkSnapshot& other);
+    ChunkSnapshot(ChunkSnapshot&& other) noexcept;
+    ChunkSnapshot& operator=(ChunkSnapshot&& other) noexcept;
+
+    // False for chunks that had nothing published yet
+    explicit operator bool() const
+    {
+        return m_version != nullptr;
+    }
+    const ChunkData& data() const
+    {
+        return m_version->data;
+    }
+    // Increases with every publish() of the chunk that changed it
+    uint64_t version() const
+    {
+        return m_version->version;
+    }
+
+    BlockId getBlock(uint16_t index) const
+    {
+        return m_version->data.blocks[index];
+    }
+    uint8_t getMeta(uint16_t index) const
+    {
+        return m_version->data.meta[index];
+    }
+    uint8_t getLight(uint16_t index) const
+    {
+        return m_version->data.light[index];
+    }
+};
+
+// Chunks are written by the simulation thread (or jobs it runs, one per
+// chunk at a time) and read anywhere through snapshots.
+//
+// publish() makes the live data the chunk's published version; the live
+// data is then shared and the next edit copies it first, so a chunk costs
+// one copy per tick in which it changes and nothing while it is idle.
+// Readers take snapshot() without a lock: an EpochGuard covers the window
+// between loading the published pointer and taking a reference, and
+// replaced versions are released through the EpochReclaimer.
+class Chunk
+{
+  private:
+    ChunkCoord m_coord;
+    // Owned by the chunk unless m_liveShared, when it is the published one
+    ChunkVersion* m_live;
+    bool m_liveShared{ false };
+    std::atomic<ChunkVersion*> m_published{ nullptr };
+    uint64_t m_version{ 0 };
+    ChunkActivity m_activity;
+    // Maintained by ChunkMap, in neighborIndex() order
+    std::array<std::atomic<Chunk*>, 27> m_neighbors{};
+
+    friend class ChunkMap;
+
+    void unshare();
+
+    ChunkData& writable()
+    {
+        if (m_liveShared) [[unlikely]]
+        {
+            unshare();
+        }
+        return m_live->data;
+    }
+
+  public:
+    explicit Chunk(const ChunkCoord& coord);
+    ~Chunk();
+    Chunk(const Chunk&) = delete;
+    Chunk& operator=(const Chunk&) = delete;
+
+    const ChunkCoord& coord() const;
+    glm::ivec3 worldOrigin() const;
+
+    // Live data, for the writing thread only
+    const ChunkData& data() const
+    {
+        return m_live->data;
+    }
+
+    BlockId getBlock(uint16_t index) const
+    {
+        return m_live->data.blocks[index];
+    }
+    uint8_t getMeta(uint16_t index) const
+    {
+        return m_live->data.meta[index];
+    }
+    void setBlock(uint16_t index, BlockId id, uint8_t meta = 0)
+    {
+        ChunkData& data = writable();
+        data.blocks[index] = id;
+        data.meta[index] = meta;
+    }
+
+    uint8_t getLight(uint16_t index) const
+    {
+        return m_live->data.light[index];
+    }
+    uint8_t getSkyLight(uint16_t index) const
+    {
+        return m_live->data.light[index] >> 4;
+    }
+    uint8_t getBlockLight(uint16_t index) const
+    {
+        return m_live->data.light[index] & 0x0F;
+    }
+    void setSkyLight(uint16_t index, uint8_t level)
+    {
+        uint8_t& light = writable().light[index];
+        light = static_cast<uint8_t>((light & 0x0F) | (level << 4));
+    }
+    void setBlockLight(uint16_t index, uint8_t level)
+    {
+        uint8_t& light = writable().light[index];
+        light = static_cast<uint8_t>((light & 0xF0) | (level & 0x0F));
+    }
+    void clearLight();
+
+    // Writer side: makes the edits since the last publish visible to new
+    // snapshots. Does nothing if there were none.
+    void publish();
+    // Any thread; empty until the first publish()
+    ChunkSnapshot snapshot() const;
+
+    ChunkActivity& activity();
+
+    // The chunk at coord() + offset while both are in the world's
+    // ChunkMap, null otherwise; offsets are in [-1, 1] and zero gives the
+    // chunk itself. Wait-free, from any thread.
+    Chunk* neighbor(const glm::ivec3& offset) const
+    {
+        return neighbor(neighborIndex(offset));
+    }
+    Chunk* neighbor(int index) const
+    {
+        return m_neighbors[index].load(std::memory_order_acquire);
+    }
+
+    // x varies fastest, then z, then y, like localIndex(); the opposite
+    // offset is 26 - index
+    static int neighborIndex(const glm::ivec3& offset)
+    {
+        return (offset.x + 1) + (offset.z + 1) * 3 + (offset.y + 1) * 9;
+    }
+};
@@ -0,0 +1,252 @@
+#include "chunk_codec.h"
+#include <array>
+#include <bit>
+#include "core/serialization/byte_stream.h"
+
+namespace
+{
+constexpr uint16_t NO_ENTRY{ 0xFFFF };
+constexpr uint32_t META_VALUES{ 256 };
+
+struct Run
+{
+    uint32_t length{ 0 };
+    uint16_t index{ 0 };
+};
+
+uint32_t stateKey(BlockId id, uint8_t meta)
+{
+    return static_cast<uint32_t>(id) * META_VALUES + meta;
+}
+
+uint8_t bitsFor(size_t paletteSize)
+{
+    return paletteSize <= 1 ? 0
+                            : static_cast<uint8_t>(std::bit_width(
+                                  static_cast<uint32_t>(paletteSize - 1)
+                              ));
+}
+
+size_t varintSize(uint32_t value)
+{
+    size_t size = 1;
+    for (; value >= 0x80; value >>= 7)
+    {
+        size++;
+    }
+    return size;
+}
+
+void writePacked(
+    ByteWriter& writer, const std::array<uint16_t, CHUNK_VOLUME>& indices,
+    uint8_t bits
+)
+{
+    writer.u8(bits);
+    if (bits == 0)
+    {
+        return;
+    }
+    uint64_t pending = 0;
+    uint32_t pendingBits = 0;
+    for (uint16_t index : indices)
+    {
+        pending |= static_cast<uint64_t>(index) << pendingBits;
+        pendingBits += bits;
+        while (pendingBits >= 8)
+        {
+            writer.u8(static_cast<uint8_t>(pending));
+            pending >>= 8;
+            pendingBits -= 8;
+        }
+    }
+    if (pendingBits > 0)
+    {
+        writer.u8(static_cast<uint8_t>(pending));
+    }
+}
+
+bool readPacked(
+    ByteReader& reader, size_t paletteSize,
+    std::array<uint16_t, CHUNK_VOLUME>& indices
+)
+{
+    const uint8_t bits = reader.u8();
+    if (bits != bitsFor(paletteSize))
+    {
+        return false;
+    }
+    const uint8_t* packed =
+        reader.bytes((static_cast<size_t>(CHUNK_VOLUME) * bits + 7) / 8);
+    if (!reader.ok())
+    {
+        return false;
+    }
+    if (bits == 0)
+    {
+        indices.fill(0);
+        return true;
+    }
+
+    const uint32_t mask = (1u << bits) - 1;
+    uint64_t pending = 0;
+    uint32_t pendingBits = 0;
+    size_t byte = 0;
+    for (uint16_t& index : indices)
+    {
+        while (pendingBits < bits)
+        {
+            pending |= static_cast<uint64_t>(packed[byte++]) << pendingBits;
+            pendingBits += 8;
+        }
+        index = static_cast<uint16_t>(pending & mask);
+        pending >>= bits;
+        pendingBits -= bits;
+        if (index >= paletteSize)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool readRuns(
+    ByteReader& reader, size_t paletteSize,
+    std::array<uint16_t, CHUNK_VOLUME>& indices
+)
+{
+    uint32_t filled = 0;
+    while (filled < CHUNK_VOLUME)
+    {
+        const uint32_t length = reader.varint();
+        const uint32_t index = reader.varint();
+        if (!reader.ok() || length == 0 || length > CHUNK_VOLUME - filled ||
+            index >= paletteSize)
+        {
+            return false;
+        }
+        std::fill_n(
+            indices.begin() + filled,
+            length,
+            static_cast<uint16_t>(index)
+        );
+        filled += length;
+    }
+    return true;
+}
+} // namespace
+
+void encodeChunk(const ChunkData& data, std::vector<uint8_t>& out)
+{
+    std::vector<uint16_t> lookup(blockCount() * META_VALUES, NO_ENTRY);
+    std::vector<uint32_t> palette;
+    std::array<uint16_t, CHUNK_VOLUME> indices;
+    std::vector<Run> runs;
+
+    for (int i = 0; i < CHUNK_VOLUME; i++)
+    {
+        const uint32_t key = stateKey(data.blocks[i], data.meta[i]);
+        if (lookup[key] == NO_ENTRY)
+        {
+            lookup[key] = static_cast<uint16_t>(palette.size());
+            palette.push_back(key);
+        }
+        indices[i] = lookup[key];
+
+        if (!runs.empty() && runs.back().index == indices[i])
+        {
+            runs.back().length++;
+        }
+        else
+        {
+            runs.push_back(Run{ .length = 1, .index = indices[i] });
+        }
+    }
+
+    ByteWriter writer(out);
+    writer.u8(CHUNK_CODEC_VERSION);
+    writer.u16(static_cast<uint16_t>(palette.size()));
+    for (uint32_t key : palette)
+    {
+        writer.u16(static_cast<uint16_t>(key / META_VALUES));
+        writer.u8(static_cast<uint8_t>(key % META_VALUES));
+    }
+
+    const uint8_t bits = bitsFor(palette.size());
+    const size_t packedSize =
+        (static_cast<size_t>(CHUNK_VOLUME) * bits + 7) / 8;
+    size_t runsSize = 0;
+    for (const Run& run : runs)
+    {
+        runsSize += varintSize(run.length) + varintSize(run.index);
+    }
+
+    if (runsSize < packedSize)
+    {
+        writer.u8(static_cast<uint8_t>(ChunkIndexEncoding::Runs));
+        for (const Run& run : runs)
+        {
+            writer.varint(run.length);
+            writer.varint(run.index);
+        }
+    }
+    else
+    {
+        writer.u8(static_cast<uint8_t>(ChunkIndexEncoding::Packed));
+        writePacked(writer, indices, bits);
+    }
+}
+
+bool decodeChunk(const uint8_t* data, size_t size, Chunk& chunk)
+{
+    ByteReader reader(data, size);
+    if (reader.u8() != CHUNK_CODEC_VERSION)
+    {
+        return false;
+    }
+
+    const uint16_t paletteSize = reader.u16();
+    if (paletteSize == 0 || paletteSize > CHUNK_VOLUME)
+    {
+        return false;
+    }
+    std::vector<BlockId> ids(paletteSize);
+    std::vector<uint8_t> metas(paletteSize);
+    for (uint16_t i = 0; i < paletteSize; i++)
+    {
+        ids[i] = reader.u16();
+        metas[i] = reader.u8();
+        if (ids[i] >= blockCount())
+        {
+            return false;
+        }
+    }
+
+    // Everything is validated before the chunk is touched
+    std::array<uint16_t, CHUNK_VOLUME> indices;
+    bool valid = false;
+    switch (static_cast<ChunkIndexEncoding>(reader.u8()))
+    {
+    case ChunkIndexEncoding::Packed:
+        valid = readPacked(reader, paletteSize, indices);
+        break;
+    case ChunkIndexEncoding::Runs:
+        valid = readRuns(reader, paletteSize, indices);
+        break;
+    }
+    if (!valid || !reader.ok())
+    {
+        return false;
+    }
+
+    for (int i = 0; i < CHUNK_VOLUME; i++)
+    {
+        chunk.setBlock(
+            static_cast<uint16_t>(i),
+            ids[indices[i]],
+            metas[indices[i]]
+        );
+    }
+    chunk.clearLight();
+    return true;
+}
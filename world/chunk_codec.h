@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "world/chunk.h"
+
+// Palette encoding of a chunk's blocks and metadata, the one serialized
+// chunk format: replication sends it and anything persisting chunks should
+// store it.
+//
+//   u8  version
+//   u16 palette size N, then N x (u16 block id, u8 meta)
+//   u8  index encoding, followed by the CHUNK_VOLUME palette indices in
+//       localIndex() order as either
+//         Packed: u8 bits per voxel (0 when N == 1), indices LSB-first
+//         Runs:   (varint run length, varint palette index) pairs
+//
+// Terrain has few distinct states and long horizontal runs, so most chunks
+// take a few hundred bytes to a few kilobytes instead of 96KB. The encoder
+// picks whichever index encoding is smaller. Light is not encoded; it is
+// derived data and the receiver relights.
+constexpr uint8_t CHUNK_CODEC_VERSION{ 1 };
+
+enum class ChunkIndexEncoding : uint8_t
+{
+    Packed,
+    Runs,
+};
+
+// Takes live data or a ChunkSnapshot's, so chunks can be saved or sent
+// from any thread
+void encodeChunk(const ChunkData& data, std::vector<uint8_t>& out);
+
+// Replaces the chunk's blocks and clears its light. Returns false and
+// leaves the chunk untouched if the data is truncated or invalid.
+bool decodeChunk(const uint8_t* data, size_t size, Chunk& chunk);
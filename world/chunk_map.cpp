@@ -0,0 +1,253 @@
+#include "chunk_map.h"
+#include <algorithm>
+#include <bit>
+
+namespace
+{
+// Chunk::neighborIndex() of the zero offset
+constexpr int CENTER{ 13 };
+
+glm::ivec3 neighborOffset(int index)
+{
+    return { index % 3 - 1, index / 9 - 1, (index / 3) % 3 - 1 };
+}
+} // namespace
+
+ChunkMap::Table::Table(uint64_t capacity)
+    : mask(capacity - 1), slots(std::make_unique<Slot[]>(capacity))
+{
+}
+
+ChunkMap::ChunkMap()
+{
+    for (Shard& shard : m_shards)
+    {
+        shard.table.store(new Table(MIN_CAPACITY), std::memory_order_relaxed);
+    }
+}
+
+ChunkMap::~ChunkMap()
+{
+    for (Shard& shard : m_shards)
+    {
+        delete shard.table.load(std::memory_order_relaxed);
+    }
+}
+
+uint64_t ChunkMap::packKey(const ChunkCoord& coord)
+{
+    // 21 bits per axis, which covers a million chunks either way
+    constexpr uint64_t AXIS_MASK{ (uint64_t{ 1 } << 21) - 1 };
+    return (static_cast<uint64_t>(coord.x) & AXIS_MASK) |
+           (static_cast<uint64_t>(coord.y) & AXIS_MASK) << 21 |
+           (static_cast<uint64_t>(coord.z) & AXIS_MASK) << 42;
+}
+
+uint64_t ChunkMap::hashKey(uint64_t key)
+{
+    // MurmurHash3 finalizer; neighbouring keys land far apart
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDull;
+    key ^= key >> 33;
+    key *= 0xC4CEB9FE1A85EC53ull;
+    key ^= key >> 33;
+    return key;
+}
+
+ChunkMap::Slot& ChunkMap::probe(
+    const Table& table, uint64_t key, uint64_t hash
+)
+{
+    // The load factor stays at or below one half, so an empty slot ends
+    // every probe
+    for (uint64_t index = hash & table.mask;; index = (index + 1) & table.mask)
+    {
+        Slot& slot = table.slots[index];
+        const uint64_t slotKey = slot.key.load(std::memory_order_acquire);
+        if (slotKey == key || slotKey == EMPTY_KEY)
+        {
+            return slot;
+        }
+    }
+}
+
+ChunkMap::Shard& ChunkMap::shardFor(uint64_t hash)
+{
+    // High bits pick the shard, low bits the slot
+    return m_shards[hash >> 60];
+}
+
+Chunk* ChunkMap::find(const ChunkCoord& coord) const
+{
+    EpochGuard guard;
+    const uint64_t key = packKey(coord);
+    const uint64_t hash = hashKey(key);
+    const Table* table =
+        m_shards[hash >> 60].table.load(std::memory_order_acquire);
+    for (uint64_t i = 0, index = hash & table->mask; i <= table->mask;
+         i++, index = (index + 1) & table->mask)
+    {
+        const Slot& slot = table->slots[index];
+        const uint64_t slotKey = slot.key.load(std::memory_order_acquire);
+        if (slotKey == key)
+        {
+            return slot.chunk.load(std::memory_order_acquire);
+        }
+        if (slotKey == EMPTY_KEY)
+        {
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+Chunk* ChunkMap::insert(Chunk* chunk)
+{
+    const uint64_t key = packKey(chunk->coord());
+    const uint64_t hash = hashKey(key);
+    Shard& shard = shardFor(hash);
+    chunk->m_neighbors[CENTER].store(chunk, std::memory_order_relaxed);
+    {
+        std::lock_guard lock(shard.mutex);
+        Table* table = shard.table.load(std::memory_order_relaxed);
+        Slot* slot = &probe(*table, key, hash);
+        if (slot->key.load(std::memory_order_relaxed) == key)
+        {
+            if (Chunk* existing = slot->chunk.load(std::memory_order_relaxed))
+            {
+                return existing;
+            }
+            slot->chunk.store(chunk, std::memory_order_release);
+        }
+        else
+        {
+            if ((shard.used + 1) * 2 > table->mask + 1)
+            {
+                rebuild(shard);
+                table = shard.table.load(std::memory_order_relaxed);
+                slot = &probe(*table, key, hash);
+            }
+            // Chunk before key: a reader that sees the key sees the chunk
+            slot->chunk.store(chunk, std::memory_order_relaxed);
+            slot->key.store(key, std::memory_order_release);
+            shard.used++;
+        }
+        shard.live++;
+    }
+    m_size.fetch_add(1, std::memory_order_relaxed);
+    link(*chunk);
+    return chunk;
+}
+
+Chunk* ChunkMap::remove(const ChunkCoord& coord)
+{
+    const uint64_t key = packKey(coord);
+    const uint64_t hash = hashKey(key);
+    Shard& shard = shardFor(hash);
+    Chunk* removed = nullptr;
+    {
+        std::lock_guard lock(shard.mutex);
+        Slot& slot =
+            probe(*shard.table.load(std::memory_order_relaxed), key, hash);
+        if (slot.key.load(std::memory_order_relaxed) != key)
+        {
+            return nullptr;
+        }
+        removed = slot.chunk.exchange(nullptr, std::memory_order_acq_rel);
+        if (!removed)
+        {
+            return nullptr;
+        }
+        shard.live--;
+    }
+    m_size.fetch_sub(1, std::memory_order_relaxed);
+    unlink(*removed);
+    return removed;
+}
+
+size_t ChunkMap::size() const
+{
+    return m_size.load(std::memory_order_relaxed);
+}
+
+void ChunkMap::rebuild(Shard& shard)
+{
+    // Sized for the live chunks alone, which also drops removed keys
+    const uint64_t capacity =
+        std::max(MIN_CAPACITY, std::bit_ceil((shard.live + 1) * 4));
+    Table* previous = shard.table.load(std::memory_order_relaxed);
+    auto* table = new Table(capacity);
+    uint64_t used = 0;
+    for (uint64_t i = 0; i <= previous->mask; i++)
+    {
+        const Slot& slot = previous->slots[i];
+        Chunk* chunk = slot.chunk.load(std::memory_order_relaxed);
+        if (!chunk)
+        {
+            continue;
+        }
+        const uint64_t key = slot.key.load(std::memory_order_relaxed);
+        Slot& target = probe(*table, key, hashKey(key));
+        target.chunk.store(chunk, std::memory_order_relaxed);
+        target.key.store(key, std::memory_order_relaxed);
+        used++;
+    }
+    shard.used = used;
+    shard.table.store(table, std::memory_order_release);
+    EpochReclaimer::get().retire(previous);
+}
+
+// Inserts and removals of neighbouring chunks can run concurrently on
+// different shards. Each side publishes itself, fences, then looks the
+// other up, so at least one of two racing inserts sees the other and sets
+// both links. A link to a chunk that is being removed is checked again
+// after it is stored, since the removal may already have cleared it.
+void ChunkMap::link(Chunk& chunk)
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (int i = 0; i < 27; i++)
+    {
+        if (i == CENTER)
+        {
+            continue;
+        }
+        const ChunkCoord coord = chunk.coord() + neighborOffset(i);
+        Chunk* neighbor = find(coord);
+        if (!neighbor)
+        {
+            continue;
+        }
+        chunk.m_neighbors[i].store(neighbor, std::memory_order_seq_cst);
+        neighbor->m_neighbors[26 - i].store(&chunk, std::memory_order_seq_cst);
+        if (find(coord) != neighbor)
+        {
+            chunk.m_neighbors[i].compare_exchange_strong(
+                neighbor,
+                nullptr,
+                std::memory_order_seq_cst
+            );
+        }
+    }
+}
+
+void ChunkMap::unlink(Chunk& chunk)
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (int i = 0; i < 27; i++)
+    {
+        chunk.m_neighbors[i].store(nullptr, std::memory_order_relaxed);
+        if (i == CENTER)
+        {
+            continue;
+        }
+        if (Chunk* neighbor = find(chunk.coord() + neighborOffset(i)))
+        {
+            Chunk* expected = &chunk;
+            neighbor->m_neighbors[26 - i].compare_exchange_strong(
+                expected,
+                nullptr,
+                std::memory_order_seq_cst
+            );
+        }
+    }
+}
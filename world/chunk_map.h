@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include "core/jobs/epoch.h"
+#include "world/chunk.h"
+
+// Chunk lookup shared by every thread that touches the world.
+//
+// Coordinates are packed into one 64-bit key and hashed into an
+// open-addressing table split into shards. Lookups take no lock: they probe
+// atomic slots under an EpochGuard and finish in a bounded number of steps
+// whatever writers are doing. Inserts and removals only lock their shard.
+// A slot keeps its key until the shard's table is rebuilt, and removal
+// just clears the chunk pointer, so a reader that matched a key can never
+// pick up another coordinate's chunk. Replaced tables are retired through
+// the EpochReclaimer.
+//
+// Each chunk caches pointers to its 26 neighbours (Chunk::neighbor()),
+// kept current by insert() and remove(), so neighbourhood walks skip the
+// table entirely.
+class ChunkMap
+{
+  public:
+    static constexpr uint32_t SHARD_COUNT{ 16 };
+
+  private:
+    // Packed keys use 63 bits, so no coordinate maps to this
+    static constexpr uint64_t EMPTY_KEY{ ~uint64_t{ 0 } };
+    static constexpr uint64_t MIN_CAPACITY{ 64 };
+
+    struct Slot
+    {
+        std::atomic<uint64_t> key{ EMPTY_KEY };
+        // Null once removed; the key stays until the next rebuild
+        std::atomic<Chunk*> chunk{ nullptr };
+    };
+
+    struct Table
+    {
+        uint64_t mask{ 0 };
+        std::unique_ptr<Slot[]> slots;
+
+        explicit Table(uint64_t capacity);
+    };
+
+    struct alignas(64) Shard
+    {
+        std::atomic<Table*> table{ nullptr };
+        // Serializes writers; readers never take it
+        std::mutex mutex;
+        // Slots holding a key, removed or not
+        uint64_t used{ 0 };
+        uint64_t live{ 0 };
+    };
+
+    std::array<Shard, SHARD_COUNT> m_shards;
+    std::atomic<size_t> m_size{ 0 };
+
+    static uint64_t packKey(const ChunkCoord& coord);
+    static uint64_t hashKey(uint64_t key);
+    // The slot holding `key`, or the empty slot that ends its probe
+    static Slot& probe(const Table& table, uint64_t key, uint64_t hash);
+
+    Shard& shardFor(uint64_t hash);
+    void rebuild(Shard& shard);
+    void link(Chunk& chunk);
+    void unlink(Chunk& chunk);
+
+  public:
+    ChunkMap();
+    ~ChunkMap();
+    ChunkMap(const ChunkMap&) = delete;
+    ChunkMap& operator=(const ChunkMap&) = delete;
+
+    // Wait-free, from any thread. The chunk stays valid while the caller
+    // holds an EpochGuard, or until the owner removes it.
+    Chunk* find(const ChunkCoord& coord) const;
+
+    // Returns the chunk already at chunk->coord() if there is one, else
+    // `chunk`. A chunk that was removed must not be inserted again.
+    Chunk* insert(Chunk* chunk);
+    // Returns the chunk that was removed, which the caller retires
+    // through the EpochReclaimer; inserts and removals of the same
+    // coordinate must not race each other
+    Chunk* remove(const ChunkCoord& coord);
+
+    size_t size() const;
+
+    // Visits the chunks in the map; ones inserted or removed concurrently
+    // may or may not be visited
+    template <typename Fn> void forEach(Fn&& fn) const
+    {
+        EpochGuard guard;
+        for (const Shard& shard : m_shards)
+        {
+            const Table* table = shard.table.load(std::memory_order_acquire);
+            for (uint64_t i = 0; i <= table->mask; i++)
+            {
+                if (Chunk* chunk = table->slots[i].chunk.load(
+                        std::memory_order_acquire
+                    ))
+                {
+                    fn(*chunk);
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,627 @@
+#include "lighting.h"
+#include <algorithm>
+#include <cstdlib>
+#include "core/profiling/profiler.h"
+
+namespace
+{
+const std::array<glm::ivec3, 6> DIRECTIONS{
+    glm::ivec3{ 1, 0, 0 },
+    glm::ivec3{ -1, 0, 0 },
+    glm::ivec3{ 0, 1, 0 },
+    glm::ivec3{ 0, -1, 0 },
+    glm::ivec3{ 0, 0, 1 },
+    glm::ivec3{ 0, 0, -1 },
+};
+
+constexpr std::array<LightChannel, 2> CHANNELS{
+    LightChannel::Sky,
+    LightChannel::Block,
+};
+
+// Light entering a voxel from a neighbour. Full sky light travels straight
+// down without losing strength so open columns stay fully lit.
+uint8_t attenuate(uint8_t level, BlockId into, bool skyDownward)
+{
+    uint8_t filter = lightFilter(into);
+    if (skyDownward && level == MAX_LIGHT_LEVEL && filter == 0)
+    {
+        return MAX_LIGHT_LEVEL;
+    }
+    uint8_t loss = static_cast<uint8_t>(1 + filter);
+    return level > loss ? static_cast<uint8_t>(level - loss) : 0;
+}
+
+bool insideChunk(const glm::ivec3& localPos)
+{
+    return localPos.x >= 0 && localPos.x < CHUNK_SIZE && localPos.y >= 0 &&
+           localPos.y < CHUNK_SIZE && localPos.z >= 0 &&
+           localPos.z < CHUNK_SIZE;
+}
+
+bool onChunkBorder(const glm::ivec3& localPos)
+{
+    return localPos.x == 0 || localPos.x == CHUNK_MASK || localPos.y == 0 ||
+           localPos.y == CHUNK_MASK || localPos.z == 0 ||
+           localPos.z == CHUNK_MASK;
+}
+
+uint8_t readLocal(const Chunk& chunk, uint16_t index, LightChannel channel)
+{
+    return channel == LightChannel::Sky ? chunk.getSkyLight(index)
+                                        : chunk.getBlockLight(index);
+}
+
+void writeLocal(
+    Chunk& chunk, uint16_t index, LightChannel channel, uint8_t level
+)
+{
+    if (channel == LightChannel::Sky)
+    {
+        chunk.setSkyLight(index, level);
+    }
+    else
+    {
+        chunk.setBlockLight(index, level);
+    }
+}
+
+// BFS that stays inside one chunk; light leaving it is picked up later by
+// the border pass
+void floodLocal(
+    Chunk& chunk, std::vector<uint16_t>& queue, LightChannel channel
+)
+{
+    for (size_t head = 0; head < queue.size(); head++)
+    {
+        uint16_t index = queue[head];
+        uint8_t level = readLocal(chunk, index, channel);
+        glm::ivec3 localPos = localPosFromIndex(index);
+
+        for (const auto& direction : DIRECTIONS)
+        {
+            glm::ivec3 neighborPos = localPos + direction;
+            if (!insideChunk(neighborPos))
+            {
+                continue;
+            }
+            uint16_t neighbor = localIndex(neighborPos);
+            BlockId id = chunk.getBlock(neighbor);
+            if (isOpaque(id))
+            {
+                continue;
+            }
+            uint8_t next = attenuate(
+                level,
+                id,
+                channel == LightChannel::Sky && direction.y < 0
+            );
+            if (next > readLocal(chunk, neighbor, channel))
+            {
+                writeLocal(chunk, neighbor, channel, next);
+                queue.push_back(neighbor);
+            }
+        }
+    }
+    queue.clear();
+}
+} // namespace
+
+LightEngine::LightEngine(World& world, JobSystem& jobs)
+    : m_world(world), m_jobs(jobs)
+{
+}
+
+Chunk* LightEngine::chunkAt(const glm::ivec3& pos)
+{
+    ChunkCoord coord = toChunkCoord(pos);
+    if (m_cachedChunk && m_cachedChunk->coord() == coord)
+    {
+        return m_cachedChunk;
+    }
+    // Propagation mostly steps into an adjacent chunk, which the cached
+    // one already points to
+    Chunk* neighbor = nullptr;
+    if (m_cachedChunk)
+    {
+        const glm::ivec3 step = coord - m_cachedChunk->coord();
+        if (std::abs(step.x) <= 1 && std::abs(step.y) <= 1 &&
+            std::abs(step.z) <= 1)
+        {
+            neighbor = m_cachedChunk->neighbor(step);
+        }
+    }
+    m_cachedChunk = neighbor ? neighbor : m_world.getChunk(coord);
+    return m_cachedChunk;
+}
+
+uint8_t LightEngine::getLight(
+    Chunk& chunk, uint16_t index, LightChannel channel
+) const
+{
+    return readLocal(chunk, index, channel);
+}
+
+void LightEngine::setLight(
+    Chunk& chunk, uint16_t index, LightChannel channel, uint8_t level
+)
+{
+    writeLocal(chunk, index, channel, level);
+}
+
+void LightEngine::markDirty(const glm::ivec3& pos)
+{
+    // Smooth lighting samples across borders, so edge voxels also dirty the
+    // chunks they touch
+    ChunkCoord coord = toChunkCoord(pos);
+    glm::ivec3 localPos = toLocalPos(pos);
+    glm::ivec3 low{ localPos.x == 0 ? -1 : 0,
+                    localPos.y == 0 ? -1 : 0,
+                    localPos.z == 0 ? -1 : 0 };
+    glm::ivec3 high{ localPos.x == CHUNK_MASK ? 1 : 0,
+                     localPos.y == CHUNK_MASK ? 1 : 0,
+                     localPos.z == CHUNK_MASK ? 1 : 0 };
+
+    for (int dy = low.y; dy <= high.y; dy++)
+    {
+        for (int dz = low.z; dz <= high.z; dz++)
+        {
+            for (int dx = low.x; dx <= high.x; dx++)
+            {
+                m_dirtyChunks.insert(coord + glm::ivec3(dx, dy, dz));
+            }
+        }
+    }
+}
+
+void LightEngine::onChunkLoaded(const ChunkCoord& coord)
+{
+    m_newChunks.push_back(coord);
+}
+
+void LightEngine::onBlocksChanged(const std::vector<BlockChange>& changes)
+{
+    m_changes.insert(m_changes.end(), changes.begin(), changes.end());
+}
+
+void LightEngine::update()
+{
+    PROFILE_ZONE("LightEngine::update");
+    m_cachedChunk = nullptr;
+    if (!m_newChunks.empty())
+    {
+        lightNewChunks();
+    }
+    if (!m_changes.empty())
+    {
+        applyChanges();
+    }
+}
+
+std::vector<ChunkCoord> LightEngine::takeDirtyChunks()
+{
+    std::vector<ChunkCoord> dirty(m_dirtyChunks.begin(), m_dirtyChunks.end());
+    m_dirtyChunks.clear();
+    return dirty;
+}
+
+void LightEngine::lightChunkLocal(
+    Chunk& chunk, const std::array<uint8_t, CHUNK_AREA>& skyFromAbove
+)
+{
+    PROFILE_ZONE("LightEngine::lightChunkLocal");
+    chunk.clearLight();
+    std::vector<uint16_t> queue;
+
+    // Sky: walk each column down from the top face while it stays full
+    for (int z = 0; z < CHUNK_SIZE; z++)
+    {
+        for (int x = 0; x < CHUNK_SIZE; x++)
+        {
+            uint8_t incoming = skyFromAbove[x + z * CHUNK_SIZE];
+            for (int y = CHUNK_SIZE - 1; y >= 0 && incoming > 0; y--)
+            {
+                uint16_t index = localIndex(x, y, z);
+                BlockId id = chunk.getBlock(index);
+                if (isOpaque(id))
+                {
+                    break;
+                }
+                uint8_t level = attenuate(incoming, id, true);
+                if (level == 0)
+                {
+                    break;
+                }
+                chunk.setSkyLight(index, level);
+                queue.push_back(index);
+                if (level < MAX_LIGHT_LEVEL)
+                {
+                    break;
+                }
+                incoming = level;
+            }
+        }
+    }
+    floodLocal(chunk, queue, LightChannel::Sky);
+
+    for (int index = 0; index < CHUNK_VOLUME; index++)
+    {
+        uint8_t emission = lightEmission(chunk.getBlock(index));
+        if (emission > 0)
+        {
+            chunk.setBlockLight(static_cast<uint16_t>(index), emission);
+            queue.push_back(static_cast<uint16_t>(index));
+        }
+    }
+    floodLocal(chunk, queue, LightChannel::Block);
+}
+
+void LightEngine::seedBorders(Chunk& chunk, LightChannel channel)
+{
+    glm::ivec3 origin = chunk.worldOrigin();
+    for (int index = 0; index < CHUNK_VOLUME; index++)
+    {
+        glm::ivec3 localPos = localPosFromIndex(static_cast<uint16_t>(index));
+        if (!onChunkBorder(localPos))
+        {
+            continue;
+        }
+
+        uint8_t level =
+            getLight(chunk, static_cast<uint16_t>(index), channel);
+        if (level > 0)
+        {
+            m_addQueue.push_back(
+                LightNode{ .pos = origin + localPos, .level = level }
+            );
+        }
+
+        // Light already present on the other side flows in as well
+        for (const auto& direction : DIRECTIONS)
+        {
+            glm::ivec3 neighborLocal = localPos + direction;
+            if (insideChunk(neighborLocal))
+            {
+                continue;
+            }
+            glm::ivec3 neighborPos = origin + neighborLocal;
+            Chunk* neighbor = chunkAt(neighborPos);
+            if (!neighbor)
+            {
+                continue;
+            }
+            uint8_t neighborLevel = getLight(
+                *neighbor,
+                localIndex(toLocalPos(neighborPos)),
+                channel
+            );
+            if (neighborLevel > 0)
+            {
+                m_addQueue.push_back(
+                    LightNode{ .pos = neighborPos, .level = neighborLevel }
+                );
+            }
+        }
+    }
+}
+
+void LightEngine::unlightColumnsBelow(
+    Chunk& chunk, const std::unordered_set<ChunkCoord, ChunkCoordHash>& pending
+)
+{
+    // A chunk below that loaded first was lit as if open to the sky. Where
+    // this chunk lets less through, queue the full columns for removal; the
+    // border pass adds the real light back
+    const ChunkCoord belowCoord = chunk.coord() - glm::ivec3(0, 1, 0);
+    Chunk* below = m_world.getChunk(belowCoord);
+    if (!below || pending.contains(belowCoord))
+    {
+        return;
+    }
+    const glm::ivec3 origin = below->worldOrigin();
+    for (int z = 0; z < CHUNK_SIZE; z++)
+    {
+        for (int x = 0; x < CHUNK_SIZE; x++)
+        {
+            const uint16_t top = localIndex(x, CHUNK_MASK, z);
+            if (below->getSkyLight(top) < MAX_LIGHT_LEVEL)
+            {
+                continue;
+            }
+            const uint16_t bottom = localIndex(x, 0, z);
+            const uint8_t entering =
+                isOpaque(chunk.getBlock(bottom))
+                    ? 0
+                    : attenuate(
+                          chunk.getSkyLight(bottom),
+                          below->getBlock(top),
+                          true
+                      );
+            if (entering == MAX_LIGHT_LEVEL)
+            {
+                continue;
+            }
+            const glm::ivec3 pos = origin + glm::ivec3(x, CHUNK_MASK, z);
+            below->setSkyLight(top, 0);
+            markDirty(pos);
+            m_removeQueue.push_back(
+                LightNode{ .pos = pos, .level = MAX_LIGHT_LEVEL }
+            );
+        }
+    }
+}
+
+void LightEngine::lightNewChunks()
+{
+    std::unordered_set<ChunkCoord, ChunkCoordHash> pending;
+    std::vector<Chunk*> chunks;
+    for (const auto& coord : m_newChunks)
+    {
+        Chunk* chunk = m_world.getChunk(coord);
+        if (chunk && pending.insert(coord).second)
+        {
+            chunks.push_back(chunk);
+        }
+    }
+    m_newChunks.clear();
+
+    // Capture sky light entering from above before any worker writes. If
+    // the chunk above is new as well, the border pass fills the column in.
+    std::vector<std::array<uint8_t, CHUNK_AREA>> skyFromAbove(chunks.size());
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        ChunkCoord aboveCoord = chunks[i]->coord() + glm::ivec3(0, 1, 0);
+        Chunk* above = m_world.getChunk(aboveCoord);
+        if (!above)
+        {
+            // Open sky until that chunk loads and unlightColumnsBelow()
+            // corrects the columns it shades
+            skyFromAbove[i].fill(MAX_LIGHT_LEVEL);
+        }
+        else if (pending.contains(aboveCoord))
+        {
+            skyFromAbove[i].fill(0);
+        }
+        else
+        {
+            for (int z = 0; z < CHUNK_SIZE; z++)
+            {
+                for (int x = 0; x < CHUNK_SIZE; x++)
+                {
+                    skyFromAbove[i][x + z * CHUNK_SIZE] =
+                        above->getSkyLight(localIndex(x, 0, z));
+                }
+            }
+        }
+    }
+
+    m_jobs.parallelFor(
+        static_cast<uint32_t>(chunks.size()),
+        1,
+        [&chunks, &skyFromAbove](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                lightChunkLocal(*chunks[i], skyFromAbove[i]);
+            }
+        }
+    );
+
+    // The border pass only ever raises light, so sky light assumed for
+    // chunks below is taken away first; the cells still lit by other
+    // sources stay queued for the sky add pass
+    for (Chunk* chunk : chunks)
+    {
+        unlightColumnsBelow(*chunk, pending);
+    }
+    propagateRemove(LightChannel::Sky);
+
+    for (LightChannel channel : CHANNELS)
+    {
+        for (Chunk* chunk : chunks)
+        {
+            seedBorders(*chunk, channel);
+        }
+        propagateAdd(channel);
+    }
+
+    for (Chunk* chunk : chunks)
+    {
+        m_dirtyChunks.insert(chunk->coord());
+        for (const auto& direction : DIRECTIONS)
+        {
+            m_dirtyChunks.insert(chunk->coord() + direction);
+        }
+    }
+}
+
+void LightEngine::applyChanges()
+{
+    // The edited blocks need new meshes whether or not any light changes,
+    // e.g. sand falling through an unlit cave
+    for (const auto& change : m_changes)
+    {
+        markDirty(change.pos);
+    }
+
+    for (LightChannel channel : CHANNELS)
+    {
+        // Darken everything the previous light at the edited cells reached
+        for (const auto& change : m_changes)
+        {
+            Chunk* chunk = chunkAt(change.pos);
+            if (!chunk)
+            {
+                continue;
+            }
+            uint16_t index = localIndex(toLocalPos(change.pos));
+            uint8_t level = getLight(*chunk, index, channel);
+            if (level > 0)
+            {
+                setLight(*chunk, index, channel, 0);
+                markDirty(change.pos);
+                m_removeQueue.push_back(
+                    LightNode{ .pos = change.pos, .level = level }
+                );
+            }
+        }
+        propagateRemove(channel);
+
+        // Relight from new emitters and from whatever surrounds the edits
+        for (const auto& change : m_changes)
+        {
+            Chunk* chunk = chunkAt(change.pos);
+            if (!chunk)
+            {
+                continue;
+            }
+            uint16_t index = localIndex(toLocalPos(change.pos));
+            BlockId id = chunk->getBlock(index);
+
+            uint8_t emission =
+                channel == LightChannel::Block ? lightEmission(id) : 0;
+            if (emission > getLight(*chunk, index, channel))
+            {
+                setLight(*chunk, index, channel, emission);
+                markDirty(change.pos);
+                m_addQueue.push_back(
+                    LightNode{ .pos = change.pos, .level = emission }
+                );
+            }
+
+            if (isOpaque(id))
+            {
+                continue;
+            }
+            for (const auto& direction : DIRECTIONS)
+            {
+                glm::ivec3 neighborPos = change.pos + direction;
+                Chunk* neighbor = chunkAt(neighborPos);
+                if (!neighbor)
+                {
+                    continue;
+                }
+                uint8_t level = getLight(
+                    *neighbor,
+                    localIndex(toLocalPos(neighborPos)),
+                    channel
+                );
+                if (level > 0)
+                {
+                    m_addQueue.push_back(
+                        LightNode{ .pos = neighborPos, .level = level }
+                    );
+                }
+            }
+        }
+        propagateAdd(channel);
+    }
+    m_changes.clear();
+}
+
+void LightEngine::propagateRemove(LightChannel channel)
+{
+    for (size_t head = 0; head < m_removeQueue.size(); head++)
+    {
+        LightNode node = m_removeQueue[head];
+
+        for (const auto& direction : DIRECTIONS)
+        {
+            glm::ivec3 neighborPos = node.pos + direction;
+            Chunk* neighbor = chunkAt(neighborPos);
+            if (!neighbor)
+            {
+                continue;
+            }
+            uint16_t index = localIndex(toLocalPos(neighborPos));
+            uint8_t level = getLight(*neighbor, index, channel);
+            if (level == 0)
+            {
+                continue;
+            }
+
+            bool skyColumn = channel == LightChannel::Sky &&
+                             direction.y < 0 &&
+                             node.level == MAX_LIGHT_LEVEL &&
+                             level == MAX_LIGHT_LEVEL;
+            if (level < node.level || skyColumn)
+            {
+                setLight(*neighbor, index, channel, 0);
+                markDirty(neighborPos);
+                m_removeQueue.push_back(
+                    LightNode{ .pos = neighborPos, .level = level }
+                );
+
+                // Emitters caught in the dark region relight themselves
+                uint8_t emission =
+                    channel == LightChannel::Block
+                        ? lightEmission(neighbor->getBlock(index))
+                        : 0;
+                if (emission > 0)
+                {
+                    setLight(*neighbor, index, channel, emission);
+                    m_addQueue.push_back(
+                        LightNode{ .pos = neighborPos, .level = emission }
+                    );
+                }
+            }
+            else
+            {
+                // Lit by another source; it refills the darkened region
+                m_addQueue.push_back(
+                    LightNode{ .pos = neighborPos, .level = level }
+                );
+            }
+        }
+    }
+    m_removeQueue.clear();
+}
+
+void LightEngine::propagateAdd(LightChannel channel)
+{
+    for (size_t head = 0; head < m_addQueue.size(); head++)
+    {
+        LightNode node = m_addQueue[head];
+        Chunk* chunk = chunkAt(node.pos);
+        if (!chunk)
+        {
+            continue;
+        }
+        // The cell may have been raised again since it was queued
+        uint8_t level =
+            getLight(*chunk, localIndex(toLocalPos(node.pos)), channel);
+        if (level <= 1)
+        {
+            continue;
+        }
+
+        for (const auto& direction : DIRECTIONS)
+        {
+            glm::ivec3 neighborPos = node.pos + direction;
+            Chunk* neighbor = chunkAt(neighborPos);
+            if (!neighbor)
+            {
+                continue;
+            }
+            uint16_t index = localIndex(toLocalPos(neighborPos));
+            BlockId id = neighbor->getBlock(index);
+            if (isOpaque(id))
+            {
+                continue;
+            }
+            uint8_t next = attenuate(
+                level,
+                id,
+                channel == LightChannel::Sky && direction.y < 0
+            );
+            if (next > getLight(*neighbor, index, channel))
+            {
+                setLight(*neighbor, index, channel, next);
+                markDirty(neighborPos);
+                m_addQueue.push_back(
+                    LightNode{ .pos = neighborPos, .level = next }
+                );
+            }
+        }
+    }
+    m_addQueue.clear();
+}
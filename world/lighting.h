@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+#include <glm/glm.hpp>
+#include "core/jobs/job_system.h"
+#include "world/chunk.h"
+#include "world/world.h"
+
+enum class LightChannel : uint8_t
+{
+    Sky,
+    Block,
+};
+
+// Sky and block light flood fill.
+//
+// Newly loaded chunks are lit chunk-locally in parallel on the job system,
+// then a serial pass propagates light across their borders. Block edits are
+// applied incrementally with the usual pair of BFS queues: a removal pass
+// darkens everything the old light reached and collects the cells lit by
+// other sources, then an add pass refills from those cells and any new
+// emitters. Only the voxels whose light actually changes are visited.
+class LightEngine
+{
+  private:
+    struct LightNode
+    {
+        glm::ivec3 pos{};
+        uint8_t level{ 0 };
+    };
+
+    World& m_world;
+    JobSystem& m_jobs;
+
+    std::vector<ChunkCoord> m_newChunks;
+    std::vector<BlockChange> m_changes;
+    std::vector<LightNode> m_addQueue;
+    std::vector<LightNode> m_removeQueue;
+    std::unordered_set<ChunkCoord, ChunkCoordHash> m_dirtyChunks;
+
+    // BFS touches neighbouring voxels, which are usually in the same chunk
+    Chunk* m_cachedChunk{ nullptr };
+
+    Chunk* chunkAt(const glm::ivec3& pos);
+    uint8_t getLight(Chunk& chunk, uint16_t index, LightChannel channel) const;
+    void setLight(
+        Chunk& chunk, uint16_t index, LightChannel channel, uint8_t level
+    );
+    void markDirty(const glm::ivec3& pos);
+
+    static void lightChunkLocal(
+        Chunk& chunk, const std::array<uint8_t, CHUNK_AREA>& skyFromAbove
+    );
+    void lightNewChunks();
+    void applyChanges();
+    void seedBorders(Chunk& chunk, LightChannel channel);
+    void unlightColumnsBelow(
+        Chunk& chunk,
+        const std::unordered_set<ChunkCoord, ChunkCoordHash>& pending
+    );
+
+    void propagateRemove(LightChannel channel);
+    void propagateAdd(LightChannel channel);
+
+  public:
+    LightEngine(World& world, JobSystem& jobs);
+
+    void onChunkLoaded(const ChunkCoord& coord);
+    void onBlocksChanged(const std::vector<BlockChange>& changes);
+
+    // Processes everything queued since the last call. The world must not
+    // be edited while this runs.
+    void update();
+
+    // Chunks whose blocks or light changed since the last call and need
+    // remeshing
+    std::vector<ChunkCoord> takeDirtyChunks();
+};
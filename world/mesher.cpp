@@ -0,0 +1,268 @@
+#include "mesher.h"
+#include <array>
+#include "core/jobs/epoch.h"
+#include "core/profiling/profiler.h"
+
+namespace
+{
+struct FaceInfo
+{
+    glm::ivec3 normal;
+    // Tangents chosen so that u x v points along the normal, which makes
+    // the corner order below counter-clockwise seen from outside
+    glm::ivec3 u;
+    glm::ivec3 v;
+};
+
+const std::array<FaceInfo, 6> FACES{
+    FaceInfo{ { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } },
+    FaceInfo{ { -1, 0, 0 }, { 0, 0, 1 }, { 0, 1, 0 } },
+    FaceInfo{ { 0, 1, 0 }, { 0, 0, 1 }, { 1, 0, 0 } },
+    FaceInfo{ { 0, -1, 0 }, { 1, 0, 0 }, { 0, 0, 1 } },
+    FaceInfo{ { 0, 0, 1 }, { 1, 0, 0 }, { 0, 1, 0 } },
+    FaceInfo{ { 0, 0, -1 }, { 0, 1, 0 }, { 1, 0, 0 } },
+};
+
+const std::array<glm::ivec2, 4> CORNERS{
+    glm::ivec2{ 0, 0 },
+    glm::ivec2{ 1, 0 },
+    glm::ivec2{ 1, 1 },
+    glm::ivec2{ 0, 1 },
+};
+
+int neighborSlot(int local)
+{
+    return local < 0 ? 0 : (local >= CHUNK_SIZE ? 2 : 1);
+}
+
+// Averages the four voxels in front of a face corner. The diagonal is
+// skipped when both sides are opaque, since light cannot reach it.
+uint8_t smoothLight(
+    const ChunkNeighborhood& neighborhood, const glm::ivec3& front,
+    const glm::ivec3& side1, const glm::ivec3& side2
+)
+{
+    const glm::ivec3 diagonal = side1 + side2 - front;
+    const bool side1Open =
+        !isOpaque(neighborhood.block(side1.x, side1.y, side1.z));
+    const bool side2Open =
+        !isOpaque(neighborhood.block(side2.x, side2.y, side2.z));
+
+    uint32_t sky{ 0 };
+    uint32_t block{ 0 };
+    uint32_t count{ 0 };
+    auto sample = [&](const glm::ivec3& p) {
+        uint8_t light = neighborhood.light(p.x, p.y, p.z);
+        sky += light >> 4;
+        block += light & 0x0F;
+        count++;
+    };
+
+    sample(front);
+    if (side1Open)
+    {
+        sample(side1);
+    }
+    if (side2Open)
+    {
+        sample(side2);
+    }
+    if ((side1Open || side2Open) &&
+        !isOpaque(neighborhood.block(diagonal.x, diagonal.y, diagonal.z)))
+    {
+        sample(diagonal);
+    }
+
+    sky = (sky + count / 2) / count;
+    block = (block + count / 2) / count;
+    return static_cast<uint8_t>((sky << 4) | block);
+}
+
+// Appends the faces of the translucent or of all other blocks
+void meshBlocks(
+    const ChunkNeighborhood& neighborhood, ChunkMesh& mesh, bool translucent
+)
+{
+    for (int y = 0; y < CHUNK_SIZE; y++)
+    {
+        for (int z = 0; z < CHUNK_SIZE; z++)
+        {
+            for (int x = 0; x < CHUNK_SIZE; x++)
+            {
+                BlockId id = neighborhood.block(x, y, z);
+                if (id == Blocks::AIR || isTranslucent(id) != translucent)
+                {
+                    continue;
+                }
+                const glm::ivec3 pos{ x, y, z };
+
+                for (uint32_t f = 0; f < FACES.size(); f++)
+                {
+                    const FaceInfo& face = FACES[f];
+                    const glm::ivec3 front = pos + face.normal;
+                    BlockId neighbor =
+                        neighborhood.block(front.x, front.y, front.z);
+                    if (isOpaque(neighbor) || neighbor == id)
+                    {
+                        continue;
+                    }
+
+                    const glm::ivec3 base{
+                        pos.x + (face.normal.x > 0 ? 1 : 0),
+                        pos.y + (face.normal.y > 0 ? 1 : 0),
+                        pos.z + (face.normal.z > 0 ? 1 : 0),
+                    };
+                    for (const auto& corner : CORNERS)
+                    {
+                        const glm::ivec3 cornerPos =
+                            base + face.u * corner.x + face.v * corner.y;
+                        const glm::ivec3 side1 =
+                            front + (corner.x ? face.u : -face.u);
+                        const glm::ivec3 side2 =
+                            front + (corner.y ? face.v : -face.v);
+
+                        mesh.vertices.push_back(ChunkVertex{
+                            .position = packVertexPosition(
+                                cornerPos.x,
+                                cornerPos.y,
+                                cornerPos.z,
+                                static_cast<BlockFace>(f)
+                            ),
+                            .data = packVertexData(
+                                id,
+                                smoothLight(neighborhood, front, side1, side2)
+                            ),
+                        });
+                    }
+                }
+            }
+        }
+    }
+}
+} // namespace
+
+ChunkNeighborhood::ChunkNeighborhood()
+    : m_blocks(PADDED_VOLUME, Blocks::AIR), m_light(PADDED_VOLUME, 0)
+{
+}
+
+NeighborhoodSnapshot snapshotNeighborhood(
+    const World& world, const ChunkCoord& coord
+)
+{
+    NeighborhoodSnapshot snapshot;
+    EpochGuard guard;
+    const Chunk* center = world.getChunk(coord);
+    for (int dy = -1; dy <= 1; dy++)
+    {
+        for (int dz = -1; dz <= 1; dz++)
+        {
+            for (int dx = -1; dx <= 1; dx++)
+            {
+                const glm::ivec3 offset{ dx, dy, dz };
+                // The neighbour cache saves 26 table lookups
+                if (const Chunk* chunk = center
+                                             ? center->neighbor(offset)
+                                             : world.getChunk(coord + offset))
+                {
+                    snapshot[Chunk::neighborIndex(offset)] = chunk->snapshot();
+                }
+            }
+        }
+    }
+    return snapshot;
+}
+
+void ChunkNeighborhood::gather(const World& world, const ChunkCoord& coord)
+{
+    std::array<const ChunkData*, 27> chunks{};
+    const Chunk* center = world.getChunk(coord);
+    for (int dy = -1; dy <= 1; dy++)
+    {
+        for (int dz = -1; dz <= 1; dz++)
+        {
+            for (int dx = -1; dx <= 1; dx++)
+            {
+                const glm::ivec3 offset{ dx, dy, dz };
+                if (const Chunk* chunk = center
+                                             ? center->neighbor(offset)
+                                             : world.getChunk(coord + offset))
+                {
+                    chunks[Chunk::neighborIndex(offset)] = &chunk->data();
+                }
+            }
+        }
+    }
+    gather(chunks);
+}
+
+void ChunkNeighborhood::gather(const NeighborhoodSnapshot& snapshot)
+{
+    std::array<const ChunkData*, 27> chunks{};
+    for (size_t i = 0; i < snapshot.size(); i++)
+    {
+        if (snapshot[i])
+        {
+            chunks[i] = &snapshot[i].data();
+        }
+    }
+    gather(chunks);
+}
+
+void ChunkNeighborhood::gather(const std::array<const ChunkData*, 27>& chunks)
+{
+    for (int y = -1; y <= CHUNK_SIZE; y++)
+    {
+        for (int z = -1; z <= CHUNK_SIZE; z++)
+        {
+            for (int x = -1; x <= CHUNK_SIZE; x++)
+            {
+                const ChunkData* chunk =
+                    chunks[neighborSlot(x) + neighborSlot(z) * 3 +
+                           neighborSlot(y) * 9];
+                int index = paddedIndex(x, y, z);
+                if (!chunk)
+                {
+                    m_blocks[index] = Blocks::AIR;
+                    m_light[index] = MAX_LIGHT_LEVEL << 4;
+                    continue;
+                }
+                uint16_t local = localIndex(
+                    x & CHUNK_MASK,
+                    y & CHUNK_MASK,
+                    z & CHUNK_MASK
+                );
+                m_blocks[index] = chunk->blocks[local];
+                m_light[index] = chunk->light[local];
+            }
+        }
+    }
+}
+
+void ChunkNeighborhood::pack(uint32_t* voxels) const
+{
+    for (int i = 0; i < PADDED_VOLUME; i++)
+    {
+        voxels[i] = static_cast<uint32_t>(m_blocks[i]) |
+                    (static_cast<uint32_t>(m_light[i]) << 16);
+    }
+}
+
+void ChunkNeighborhood::unpack(const uint32_t* voxels)
+{
+    for (int i = 0; i < PADDED_VOLUME; i++)
+    {
+        m_blocks[i] = static_cast<BlockId>(voxels[i] & 0xFFFF);
+        m_light[i] = static_cast<uint8_t>(voxels[i] >> 16);
+    }
+}
+
+void meshChunk(const ChunkNeighborhood& neighborhood, ChunkMesh& mesh)
+{
+    PROFILE_ZONE("meshChunk");
+    mesh.vertices.clear();
+    meshBlocks(neighborhood, mesh, false);
+    const uint32_t opaqueQuads = mesh.quadCount();
+    meshBlocks(neighborhood, mesh, true);
+    mesh.translucentQuads = mesh.quadCount() - opaqueQuads;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "world/chunk.h"
+#include "world/world.h"
+
+enum class BlockFace : uint8_t
+{
+    PosX,
+    NegX,
+    PosY,
+    NegY,
+    PosZ,
+    NegZ,
+};
+
+// 8 bytes per vertex, pulled in the vertex shader through the buffer device
+// address of the chunk's mesh allocation.
+//   position: x | y << 6 | z << 12 | face << 18 (corner in 0..32 per axis)
+//   data:     block id | smoothed light << 16 (sky << 4 | block)
+struct ChunkVertex
+{
+    uint32_t position{ 0 };
+    uint32_t data{ 0 };
+};
+
+constexpr uint32_t packVertexPosition(int x, int y, int z, BlockFace face)
+{
+    return static_cast<uint32_t>(x) | (static_cast<uint32_t>(y) << 6) |
+           (static_cast<uint32_t>(z) << 12) |
+           (static_cast<uint32_t>(face) << 18);
+}
+
+constexpr uint32_t packVertexData(BlockId id, uint8_t light)
+{
+    return static_cast<uint32_t>(id) | (static_cast<uint32_t>(light) << 16);
+}
+
+// Quads are emitted as four vertices each; every chunk draw shares one
+// 0-1-2 0-2-3 index pattern. The quads of translucent blocks come last, so
+// the opaque and the transparency pass each draw one range.
+struct ChunkMesh
+{
+    std::vector<ChunkVertex> vertices;
+    uint32_t translucentQuads{ 0 };
+
+    uint32_t quadCount() const
+    {
+        return static_cast<uint32_t>(vertices.size() / 4);
+    }
+};
+
+// Published versions of a chunk and its 26 neighbours, in
+// (dx + 1) + (dz + 1) * 3 + (dy + 1) * 9 order. Taking one only bumps
+// reference counts, so the simulation thread can hand chunks to meshing
+// without copying voxels and without holding readers back.
+using NeighborhoodSnapshot = std::array<ChunkSnapshot, 27>;
+
+NeighborhoodSnapshot snapshotNeighborhood(
+    const World& world, const ChunkCoord& coord
+);
+
+// Blocks and light of one chunk plus a one voxel border from its neighbours,
+// copied up front so meshing can run on a worker without touching the world.
+class ChunkNeighborhood
+{
+  public:
+    static constexpr int PADDED_SIZE{ CHUNK_SIZE + 2 };
+    static constexpr int PADDED_VOLUME{ PADDED_SIZE * PADDED_SIZE *
+                                        PADDED_SIZE };
+
+  private:
+    std::vector<BlockId> m_blocks;
+    std::vector<uint8_t> m_light;
+
+    static int paddedIndex(int x, int y, int z)
+    {
+        return (x + 1) + (z + 1) * PADDED_SIZE +
+               (y + 1) * PADDED_SIZE * PADDED_SIZE;
+    }
+
+    // Null entries are unloaded chunks
+    void gather(const std::array<const ChunkData*, 27>& chunks);
+
+  public:
+    ChunkNeighborhood();
+
+    // Unloaded neighbours read as air with full sky light
+    void gather(const World& world, const ChunkCoord& coord);
+    void gather(const NeighborhoodSnapshot& snapshot);
+
+    // PADDED_VOLUME words of block id | light << 16, in padded index order;
+    // the layout the compute mesher reads
+    void pack(uint32_t* voxels) const;
+    void unpack(const uint32_t* voxels);
+
+    // Local coordinates in -1..CHUNK_SIZE
+    BlockId block(int x, int y, int z) const
+    {
+        return m_blocks[paddedIndex(x, y, z)];
+    }
+    uint8_t light(int x, int y, int z) const
+    {
+        return m_light[paddedIndex(x, y, z)];
+    }
+};
+
+// Emits one quad per block face that borders a non-opaque voxel of a
+// different type, in x-fastest voxel order and BlockFace order per voxel;
+// first for every block that is not translucent, then for the translucent
+// ones.
+void meshChunk(const ChunkNeighborhood& neighborhood, ChunkMesh& mesh);
@@ -0,0 +1,431 @@
+#include "simulation.h"
+#include <algorithm>
+#include "core/profiling/profiler.h"
+
+namespace
+{
+const glm::ivec3 UP{ 0, 1, 0 };
+
+const std::array<glm::ivec3, 4> HORIZONTAL_DIRECTIONS{
+    glm::ivec3{ 1, 0, 0 },
+    glm::ivec3{ -1, 0, 0 },
+    glm::ivec3{ 0, 0, 1 },
+    glm::ivec3{ 0, 0, -1 },
+};
+
+const std::array<glm::ivec3, 7> SELF_AND_NEIGHBORS{
+    glm::ivec3{ 0, 0, 0 },
+    glm::ivec3{ 1, 0, 0 },
+    glm::ivec3{ -1, 0, 0 },
+    glm::ivec3{ 0, 1, 0 },
+    glm::ivec3{ 0, -1, 0 },
+    glm::ivec3{ 0, 0, 1 },
+    glm::ivec3{ 0, 0, -1 },
+};
+
+uint32_t positiveMod3(int value)
+{
+    return static_cast<uint32_t>(((value % 3) + 3) % 3);
+}
+} // namespace
+
+BlockSimulation::BlockSimulation(World& world, JobSystem& jobs)
+    : m_world(world), m_jobs(jobs)
+{
+}
+
+uint32_t BlockSimulation::phaseOf(const ChunkCoord& coord)
+{
+    return positiveMod3(coord.x) + 3 * positiveMod3(coord.y) +
+           9 * positiveMod3(coord.z);
+}
+
+void BlockSimulation::trackChunk(const ChunkCoord& coord)
+{
+    if (m_activeSet.insert(coord).second)
+    {
+        m_activeChunks.push_back(coord);
+    }
+}
+
+void BlockSimulation::activate(const glm::ivec3& worldPos)
+{
+    activateAround(worldPos);
+    for (const auto& offset : SELF_AND_NEIGHBORS)
+    {
+        trackChunk(toChunkCoord(worldPos + offset));
+    }
+}
+
+void BlockSimulation::scheduleTick(const glm::ivec3& worldPos, uint32_t delay)
+{
+    schedule(worldPos, delay);
+    trackChunk(toChunkCoord(worldPos));
+}
+
+bool BlockSimulation::readCell(
+    const glm::ivec3& pos, BlockId& id, uint8_t& meta
+) const
+{
+    Chunk* chunk = m_world.getChunk(toChunkCoord(pos));
+    if (!chunk)
+    {
+        return false;
+    }
+    uint16_t index = localIndex(toLocalPos(pos));
+    id = chunk->getBlock(index);
+    meta = chunk->getMeta(index);
+    return true;
+}
+
+bool BlockSimulation::placeBlock(
+    const glm::ivec3& pos, BlockId id, uint8_t meta
+)
+{
+    Chunk* chunk = m_world.getChunk(toChunkCoord(pos));
+    if (!chunk)
+    {
+        return false;
+    }
+    uint16_t index = localIndex(toLocalPos(pos));
+    BlockId previous = chunk->getBlock(index);
+    chunk->setBlock(index, id, meta);
+    if (previous != id)
+    {
+        chunk->activity().changes.push_back(
+            BlockChange{ .pos = pos, .previous = previous, .current = id }
+        );
+    }
+    activateAround(pos);
+    return true;
+}
+
+void BlockSimulation::activateCell(const glm::ivec3& pos)
+{
+    Chunk* chunk = m_world.getChunk(toChunkCoord(pos));
+    if (!chunk)
+    {
+        return;
+    }
+    uint16_t index = localIndex(toLocalPos(pos));
+    ChunkActivity& activity = chunk->activity();
+    if (!activity.pendingMask.test(index))
+    {
+        activity.pendingMask.set(index);
+        activity.pending.push_back(index);
+    }
+}
+
+void BlockSimulation::activateAround(const glm::ivec3& pos)
+{
+    for (const auto& offset : SELF_AND_NEIGHBORS)
+    {
+        activateCell(pos + offset);
+    }
+}
+
+void BlockSimulation::schedule(const glm::ivec3& pos, uint32_t delay)
+{
+    Chunk* chunk = m_world.getChunk(toChunkCoord(pos));
+    if (!chunk)
+    {
+        return;
+    }
+    uint16_t index = localIndex(toLocalPos(pos));
+    ChunkActivity& activity = chunk->activity();
+    if (activity.scheduledMask.test(index))
+    {
+        return;
+    }
+    activity.scheduledMask.set(index);
+    activity.scheduled.push_back(
+        ScheduledTick{ .dueTick = m_tick + delay, .index = index }
+    );
+}
+
+void BlockSimulation::gatherWork(Chunk& chunk)
+{
+    ChunkActivity& activity = chunk.activity();
+
+    // Cells activated while this tick runs land in `pending` and are
+    // processed next tick, which keeps the result independent of ordering
+    activity.processing.swap(activity.pending);
+    activity.pending.clear();
+    for (uint16_t index : activity.processing)
+    {
+        activity.pendingMask.reset(index);
+    }
+
+    activity.due.clear();
+    auto firstDue = std::stable_partition(
+        activity.scheduled.begin(),
+        activity.scheduled.end(),
+        [this](const ScheduledTick& tick) {
+            return tick.dueTick > m_tick;
+        }
+    );
+    for (auto it = firstDue; it != activity.scheduled.end(); ++it)
+    {
+        activity.due.push_back(it->index);
+        activity.scheduledMask.reset(it->index);
+    }
+    activity.scheduled.erase(firstDue, activity.scheduled.end());
+}
+
+void BlockSimulation::processChunk(Chunk& chunk)
+{
+    PROFILE_ZONE("BlockSimulation::processChunk");
+    ChunkActivity& activity = chunk.activity();
+    for (uint16_t index : activity.processing)
+    {
+        updateCell(chunk, index, false);
+    }
+    for (uint16_t index : activity.due)
+    {
+        updateCell(chunk, index, true);
+    }
+    activity.processing.clear();
+    activity.due.clear();
+}
+
+void BlockSimulation::rebuildActiveChunks()
+{
+    // Work and edits can only spread into direct neighbours of chunks that
+    // ran
+    std::vector<ChunkCoord> previous;
+    previous.swap(m_activeChunks);
+    m_activeSet.clear();
+    m_changes.clear();
+
+    for (const auto& coord : previous)
+    {
+        const Chunk* center = m_world.getChunk(coord);
+        for (int dy = -1; dy <= 1; dy++)
+        {
+            for (int dz = -1; dz <= 1; dz++)
+            {
+                for (int dx = -1; dx <= 1; dx++)
+                {
+                    const glm::ivec3 offset{ dx, dy, dz };
+                    ChunkCoord neighbor = coord + offset;
+                    Chunk* chunk = center ? center->neighbor(offset)
+                                          : m_world.getChunk(neighbor);
+                    if (!chunk)
+                    {
+                        continue;
+                    }
+                    ChunkActivity& activity = chunk->activity();
+                    m_changes.insert(
+                        m_changes.end(),
+                        activity.changes.begin(),
+                        activity.changes.end()
+                    );
+                    activity.changes.clear();
+                    if (activity.hasWork())
+                    {
+                        trackChunk(neighbor);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void BlockSimulation::tick()
+{
+    PROFILE_ZONE("BlockSimulation::tick");
+    m_tick++;
+
+    for (auto& phase : m_phases)
+    {
+        phase.clear();
+    }
+    for (const auto& coord : m_activeChunks)
+    {
+        Chunk* chunk = m_world.getChunk(coord);
+        if (!chunk)
+        {
+            continue;
+        }
+        gatherWork(*chunk);
+        m_phases[phaseOf(coord)].push_back(chunk);
+    }
+
+    for (auto& phase : m_phases)
+    {
+        m_jobs.parallelFor(
+            static_cast<uint32_t>(phase.size()),
+            1,
+            [this, &phase](uint32_t begin, uint32_t end) {
+                for (uint32_t i = begin; i < end; i++)
+                {
+                    processChunk(*phase[i]);
+                }
+            }
+        );
+    }
+
+    rebuildActiveChunks();
+}
+
+void BlockSimulation::updateCell(Chunk& chunk, uint16_t index, bool scheduled)
+{
+    BlockId id = chunk.getBlock(index);
+    glm::ivec3 pos = chunk.worldOrigin() + localPosFromIndex(index);
+
+    if (fallsWithGravity(id))
+    {
+        updateFalling(pos, id);
+    }
+    else if (isFluid(id))
+    {
+        // Neighbour changes only wake the fluid up; it moves at its own rate
+        if (scheduled)
+        {
+            flowFluid(pos, id, chunk.getMeta(index));
+        }
+        else
+        {
+            schedule(pos, fluidFlowDelay(id));
+        }
+    }
+}
+
+void BlockSimulation::updateFalling(const glm::ivec3& pos, BlockId id)
+{
+    BlockId belowId;
+    uint8_t belowMeta;
+    if (!readCell(pos - UP, belowId, belowMeta))
+    {
+        return;
+    }
+
+    if (isReplaceable(belowId))
+    {
+        placeBlock(pos - UP, id, 0);
+        placeBlock(pos, Blocks::AIR, 0);
+    }
+    else if (isFluid(belowId))
+    {
+        // Sink through fluids by swapping places
+        placeBlock(pos - UP, id, 0);
+        placeBlock(pos, belowId, belowMeta);
+    }
+}
+
+int BlockSimulation::feedingMeta(const glm::ivec3& pos, BlockId id) const
+{
+    BlockId neighborId;
+    uint8_t neighborMeta;
+
+    if (readCell(pos + UP, neighborId, neighborMeta) && neighborId == id)
+    {
+        return FLUID_FALLING;
+    }
+
+    int best = -1;
+    for (const auto& direction : HORIZONTAL_DIRECTIONS)
+    {
+        if (!readCell(pos + direction, neighborId, neighborMeta) ||
+            neighborId != id)
+        {
+            continue;
+        }
+        int level = (neighborMeta & FLUID_FALLING)
+                        ? 0
+                        : (neighborMeta & FLUID_LEVEL_MASK);
+        int candidate = level + 1;
+        if (candidate <= FLUID_MAX_LEVEL && (best < 0 || candidate < best))
+        {
+            best = candidate;
+        }
+    }
+    return best;
+}
+
+bool BlockSimulation::canFlowInto(
+    const glm::ivec3& pos, BlockId id, uint8_t meta
+) const
+{
+    BlockId targetId;
+    uint8_t targetMeta;
+    if (!readCell(pos, targetId, targetMeta))
+    {
+        return false;
+    }
+    if (isReplaceable(targetId))
+    {
+        return true;
+    }
+    if (targetId != id || targetMeta == 0)
+    {
+        return false;
+    }
+    if (meta & FLUID_FALLING)
+    {
+        return !(targetMeta & FLUID_FALLING);
+    }
+    return !(targetMeta & FLUID_FALLING) &&
+           (targetMeta & FLUID_LEVEL_MASK) > (meta & FLUID_LEVEL_MASK);
+}
+
+void BlockSimulation::flowFluid(const glm::ivec3& pos, BlockId id, uint8_t meta)
+{
+    // Flowing cells recede once nothing feeds them anymore
+    if (meta != 0)
+    {
+        int fed = feedingMeta(pos, id);
+        if (fed < 0)
+        {
+            placeBlock(pos, Blocks::AIR, 0);
+            return;
+        }
+        if (fed != meta)
+        {
+            meta = static_cast<uint8_t>(fed);
+            placeBlock(pos, id, meta);
+        }
+    }
+
+    if (canFlowInto(pos - UP, id, FLUID_FALLING))
+    {
+        placeBlock(pos - UP, id, FLUID_FALLING);
+        return;
+    }
+
+    BlockId belowId;
+    uint8_t belowMeta;
+    if (!readCell(pos - UP, belowId, belowMeta) || belowId == id)
+    {
+        return;
+    }
+
+    uint8_t level = (meta & FLUID_FALLING) ? 0 : (meta & FLUID_LEVEL_MASK);
+    if (level >= FLUID_MAX_LEVEL)
+    {
+        return;
+    }
+    uint8_t spreadMeta = static_cast<uint8_t>(level + 1);
+    for (const auto& direction : HORIZONTAL_DIRECTIONS)
+    {
+        if (canFlowInto(pos + direction, id, spreadMeta))
+        {
+            placeBlock(pos + direction, id, spreadMeta);
+        }
+    }
+}
+
+const std::vector<BlockChange>& BlockSimulation::changes() const
+{
+    return m_changes;
+}
+
+uint64_t BlockSimulation::currentTick() const
+{
+    return m_tick;
+}
+
+size_t BlockSimulation::activeChunkCount() const
+{
+    return m_activeChunks.size();
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+#include <glm/glm.hpp>
+#include "core/jobs/job_system.h"
+#include "world/chunk.h"
+#include "world/world.h"
+
+// Block update simulation (fluids, falling blocks, scheduled ticks).
+//
+// Only cells that were marked dirty are visited, so the cost of a tick
+// follows the amount of activity rather than the number of loaded chunks.
+// A cell update reads and writes at most one voxel away and activates at
+// most two voxels away, which always stays inside the 3x3x3 block of chunks
+// around the one being processed. Chunks are therefore split into 27
+// phases by (x, y, z) mod 3: chunks in the same phase are three apart, their
+// neighbourhoods never overlap, and each phase runs in parallel on the job
+// system without locks.
+class BlockSimulation
+{
+  private:
+    static constexpr uint32_t PHASE_COUNT{ 27 };
+
+    World& m_world;
+    JobSystem& m_jobs;
+    uint64_t m_tick{ 0 };
+
+    std::vector<ChunkCoord> m_activeChunks;
+    std::unordered_set<ChunkCoord, ChunkCoordHash> m_activeSet;
+    std::array<std::vector<Chunk*>, PHASE_COUNT> m_phases;
+    std::vector<BlockChange> m_changes;
+
+    static uint32_t phaseOf(const ChunkCoord& coord);
+
+    void trackChunk(const ChunkCoord& coord);
+    void gatherWork(Chunk& chunk);
+    void processChunk(Chunk& chunk);
+    void rebuildActiveChunks();
+
+    // Cell helpers; positions are in world space
+    bool readCell(const glm::ivec3& pos, BlockId& id, uint8_t& meta) const;
+    bool placeBlock(const glm::ivec3& pos, BlockId id, uint8_t meta);
+    void activateCell(const glm::ivec3& pos);
+    void activateAround(const glm::ivec3& pos);
+    void schedule(const glm::ivec3& pos, uint32_t delay);
+
+    void updateCell(Chunk& chunk, uint16_t index, bool scheduled);
+    void updateFalling(const glm::ivec3& pos, BlockId id);
+    void flowFluid(const glm::ivec3& pos, BlockId id, uint8_t meta);
+    int feedingMeta(const glm::ivec3& pos, BlockId id) const;
+    bool canFlowInto(const glm::ivec3& pos, BlockId id, uint8_t meta) const;
+
+  public:
+    BlockSimulation(World& world, JobSystem& jobs);
+
+    // Marks a cell and its six neighbours dirty, e.g. after a player edit.
+    // Must not be called while tick() is running.
+    void activate(const glm::ivec3& worldPos);
+    void scheduleTick(const glm::ivec3& worldPos, uint32_t delay);
+
+    void tick();
+
+    // Block edits made during the last tick, for lighting and remeshing
+    const std::vector<BlockChange>& changes() const;
+
+    uint64_t currentTick() const;
+    size_t activeChunkCount() const;
+};
@@ -0,0 +1,232 @@
+#include "simulation_thread.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include "core/profiling/profiler.h"
+
+namespace
+{
+uint64_t toNs(std::chrono::steady_clock::time_point time)
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            time.time_since_epoch()
+        )
+            .count()
+    );
+}
+} // namespace
+
+SimulationThread::SimulationThread(
+    World& world, BlockSimulation& simulation, LightEngine& lighting,
+    JobSystem& jobs, InputQueue& input
+)
+    : m_world(world), m_simulation(simulation), m_lighting(lighting),
+      m_jobs(jobs), m_input(input)
+{
+}
+
+SimulationThread::~SimulationThread()
+{
+    stop();
+}
+
+void SimulationThread::start()
+{
+    if (m_running.exchange(true))
+    {
+        return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    m_previous = SimulationSnapshot{ .time = now, .viewer = m_viewer };
+    m_current = m_previous;
+    m_thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop()
+{
+    m_running.store(false, std::memory_order_release);
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+void SimulationThread::run()
+{
+    PROFILE_THREAD_NAME("simulation");
+
+    auto nextTick = std::chrono::steady_clock::now() + TICK;
+    while (m_running.load(std::memory_order_acquire))
+    {
+        auto now = std::chrono::steady_clock::now();
+        if (now < nextTick)
+        {
+            std::this_thread::sleep_until(nextTick);
+            continue;
+        }
+
+        for (uint32_t i = 0; i < MAX_CATCH_UP_TICKS && now >= nextTick; i++)
+        {
+            step(nextTick);
+            nextTick += TICK;
+        }
+        // Still behind: let simulated time slip instead of spiralling
+        if (now >= nextTick)
+        {
+            nextTick = now + TICK;
+        }
+    }
+}
+
+void SimulationThread::step(std::chrono::steady_clock::time_point tickEnd)
+{
+    PROFILE_ZONE("SimulationThread::step");
+
+    InputEvent event;
+    while (m_input.pop(event))
+    {
+        m_pendingInput.push_back(event);
+    }
+    const uint64_t tickEndNs = toNs(tickEnd);
+    while (!m_pendingInput.empty() &&
+           m_pendingInput.front().timestampNs < tickEndNs)
+    {
+        applyInput(m_pendingInput.front());
+        m_pendingInput.pop_front();
+    }
+    moveViewer();
+
+    m_simulation.tick();
+    m_lighting.onBlocksChanged(m_simulation.changes());
+    m_lighting.update();
+    m_world.publish();
+    std::vector<MeshRequest> requests = gatherMeshRequests();
+    m_tick++;
+
+    std::lock_guard lock(m_sharedMutex);
+    m_previous = m_current;
+    m_current = SimulationSnapshot{
+        .tick = m_tick,
+        .time = tickEnd,
+        .viewer = m_viewer,
+    };
+    for (auto& request : requests)
+    {
+        m_meshRequests.push_back(std::move(request));
+    }
+}
+
+void SimulationThread::applyInput(const InputEvent& event)
+{
+    switch (event.type)
+    {
+    case InputEventType::ActionPressed:
+    case InputEventType::ActionReleased:
+        m_actions[static_cast<size_t>(event.action)] =
+            event.type == InputEventType::ActionPressed;
+        break;
+    case InputEventType::Look:
+        m_viewer.yaw += event.x * LOOK_SENSITIVITY;
+        m_viewer.pitch = std::clamp(
+            m_viewer.pitch - event.y * LOOK_SENSITIVITY,
+            -1.55f,
+            1.55f
+        );
+        break;
+    }
+}
+
+void SimulationThread::moveViewer()
+{
+    auto held = [&](InputAction action) {
+        return m_actions[static_cast<size_t>(action)] ? 1.0f : 0.0f;
+    };
+    const glm::vec3 forward{ std::sin(m_viewer.yaw),
+                             0.0f,
+                             -std::cos(m_viewer.yaw) };
+    const glm::vec3 right{ std::cos(m_viewer.yaw),
+                           0.0f,
+                           std::sin(m_viewer.yaw) };
+
+    glm::vec3 direction =
+        forward * (held(InputAction::MoveForward) -
+                   held(InputAction::MoveBack)) +
+        right * (held(InputAction::MoveRight) - held(InputAction::MoveLeft)) +
+        glm::vec3(0.0f, 1.0f, 0.0f) *
+            (held(InputAction::MoveUp) - held(InputAction::MoveDown));
+    if (glm::dot(direction, direction) > 0.0f)
+    {
+        const float tickSeconds =
+            std::chrono::duration<float>(TICK).count();
+        m_viewer.position +=
+            glm::normalize(direction) * VIEWER_SPEED * tickSeconds;
+    }
+}
+
+std::vector<MeshRequest> SimulationThread::gatherMeshRequests()
+{
+    PROFILE_ZONE("SimulationThread::gatherMeshRequests");
+    std::vector<ChunkCoord> dirty = m_lighting.takeDirtyChunks();
+    {
+        std::lock_guard lock(m_sharedMutex);
+        dirty.insert(dirty.end(), m_remeshCoords.begin(), m_remeshCoords.end());
+        m_remeshCoords.clear();
+    }
+    std::vector<MeshRequest> requests(dirty.size());
+    for (size_t i = 0; i < dirty.size(); i++)
+    {
+        requests[i].coord = dirty[i];
+        if (m_world.getChunk(dirty[i]))
+        {
+            requests[i].neighborhood = snapshotNeighborhood(m_world, dirty[i]);
+        }
+    }
+    return requests;
+}
+
+ViewerState SimulationThread::interpolatedViewer(
+    std::chrono::steady_clock::time_point now
+)
+{
+    SimulationSnapshot previous;
+    SimulationSnapshot current;
+    {
+        std::lock_guard lock(m_sharedMutex);
+        previous = m_previous;
+        current = m_current;
+    }
+    if (current.time <= previous.time)
+    {
+        return current.viewer;
+    }
+
+    // Rendering one tick behind keeps the blend between two known states
+    const auto renderTime = now - TICK;
+    float alpha = std::chrono::duration<float>(renderTime - previous.time) /
+                  std::chrono::duration<float>(current.time - previous.time);
+    alpha = std::clamp(alpha, 0.0f, 1.0f);
+
+    return ViewerState{
+        .position = glm::mix(
+            previous.viewer.position,
+            current.viewer.position,
+            alpha
+        ),
+        .yaw = glm::mix(previous.viewer.yaw, current.viewer.yaw, alpha),
+        .pitch = glm::mix(previous.viewer.pitch, current.viewer.pitch, alpha),
+    };
+}
+
+std::vector<MeshRequest> SimulationThread::takeMeshRequests()
+{
+    std::lock_guard lock(m_sharedMutex);
+    return std::exchange(m_meshRequests, {});
+}
+
+void SimulationThread::requestRemesh(const std::vector<ChunkCoord>& coords)
+{
+    std::lock_guard lock(m_sharedMutex);
+    m_remeshCoords.insert(m_remeshCoords.end(), coords.begin(), coords.end());
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include "core/jobs/job_system.h"
+#include "core/platform/input.h"
+#include "world/lighting.h"
+#include "world/mesher.h"
+#include "world/simulation.h"
+#include "world/world.h"
+
+struct ViewerState
+{
+    glm::vec3 position{ 0.0f };
+    // Radians; yaw is left unwrapped so interpolation never goes the long
+    // way round
+    float yaw{ 0.0f };
+    float pitch{ 0.0f };
+};
+
+struct SimulationSnapshot
+{
+    uint64_t tick{ 0 };
+    // Nominal time at which the tick ended
+    std::chrono::steady_clock::time_point time{};
+    ViewerState viewer;
+};
+
+struct MeshRequest
+{
+    ChunkCoord coord{ 0 };
+    // Empty when the chunk has been unloaded and its mesh should go
+    std::optional<NeighborhoodSnapshot> neighborhood;
+};
+
+// Runs the world at a fixed rate on its own thread.
+//
+// Input arrives through a lock-free SPSC queue. Events are applied in
+// timestamp order at the start of the first tick that runs after they
+// were enqueued, and no earlier than the tick whose end follows their
+// timestamp. Ticks do not wait for input, so an event enqueued late lands
+// in a later tick than its timestamp alone would pick. The render thread
+// never waits on a tick: it reads the last two snapshots and interpolates
+// between them one tick in the past. Each tick ends by publishing the edited chunks; the
+// render thread receives the chunks to remesh as neighbourhood snapshots,
+// so it never touches the live world.
+class SimulationThread
+{
+  public:
+    static constexpr std::chrono::milliseconds TICK{ 50 };
+
+  private:
+    // After a stall, at most this many ticks are run back to back before
+    // simulated time is allowed to slip
+    static constexpr uint32_t MAX_CATCH_UP_TICKS{ 5 };
+    static constexpr float VIEWER_SPEED{ 10.0f };      // blocks per second
+    static constexpr float LOOK_SENSITIVITY{ 0.0025f }; // radians per pixel
+
+    World& m_world;
+    BlockSimulation& m_simulation;
+    LightEngine& m_lighting;
+    JobSystem& m_jobs;
+    InputQueue& m_input;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{ false };
+
+    // Owned by the simulation thread
+    std::deque<InputEvent> m_pendingInput;
+    std::array<bool, static_cast<size_t>(InputAction::Count)> m_actions{};
+    ViewerState m_viewer;
+    uint64_t m_tick{ 0 };
+
+    // Shared with the render thread
+    std::mutex m_sharedMutex;
+    SimulationSnapshot m_previous;
+    SimulationSnapshot m_current;
+    std::vector<MeshRequest> m_meshRequests;
+    std::vector<ChunkCoord> m_remeshCoords;
+
+    void run();
+    void step(std::chrono::steady_clock::time_point tickEnd);
+    void applyInput(const InputEvent& event);
+    void moveViewer();
+    std::vector<MeshRequest> gatherMeshRequests();
+
+  public:
+    SimulationThread(
+        World& world, BlockSimulation& simulation, LightEngine& lighting,
+        JobSystem& jobs, InputQueue& input
+    );
+    ~SimulationThread();
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    void start();
+    void stop();
+
+    // Viewer as of one tick before `now`, blended between the two latest
+    // snapshots
+    ViewerState interpolatedViewer(std::chrono::steady_clock::time_point now);
+
+    // Chunks remeshed since the last call, oldest first
+    std::vector<MeshRequest> takeMeshRequests();
+    // Asks for fresh mesh requests for chunks whose meshes the render
+    // thread dropped; they arrive after the next tick
+    void requestRemesh(const std::vector<ChunkCoord>& coords);
+};
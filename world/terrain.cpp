@@ -0,0 +1,158 @@
+#include "terrain.h"
+#include <cmath>
+
+namespace
+{
+// splitmix64 finaliser; cheap and well mixed for lattice hashing
+uint64_t mix(uint64_t h)
+{
+    h ^= h >> 30;
+    h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBull;
+    return h ^ (h >> 31);
+}
+
+float latticeValue(uint64_t seed, int x, int y, int z)
+{
+    uint64_t h = seed;
+    h = mix(h ^ static_cast<uint32_t>(x));
+    h = mix(h ^ static_cast<uint32_t>(y));
+    h = mix(h ^ static_cast<uint32_t>(z));
+    return static_cast<float>(h >> 40) / static_cast<float>(1 << 24);
+}
+
+float smooth(float t)
+{
+    return t * t * (3.0f - 2.0f * t);
+}
+
+float lerp(float a, float b, float t)
+{
+    return a + (b - a) * t;
+}
+
+// Floor division that also works for negative coordinates
+int floorDiv(int value, int divisor)
+{
+    return value >= 0 ? value / divisor : (value - divisor + 1) / divisor;
+}
+} // namespace
+
+TerrainGenerator::TerrainGenerator(uint64_t seed) : m_seed(mix(seed))
+{
+}
+
+float TerrainGenerator::valueNoise2D(
+    int x, int z, int cell, uint64_t salt
+) const
+{
+    const int cx = floorDiv(x, cell);
+    const int cz = floorDiv(z, cell);
+    const float tx = smooth(static_cast<float>(x - cx * cell) / cell);
+    const float tz = smooth(static_cast<float>(z - cz * cell) / cell);
+    const uint64_t seed = m_seed ^ salt;
+
+    return lerp(
+        lerp(
+            latticeValue(seed, cx, 0, cz),
+            latticeValue(seed, cx + 1, 0, cz),
+            tx
+        ),
+        lerp(
+            latticeValue(seed, cx, 0, cz + 1),
+            latticeValue(seed, cx + 1, 0, cz + 1),
+            tx
+        ),
+        tz
+    );
+}
+
+float TerrainGenerator::valueNoise3D(
+    int x, int y, int z, int cell, uint64_t salt
+) const
+{
+    const int cx = floorDiv(x, cell);
+    const int cy = floorDiv(y, cell);
+    const int cz = floorDiv(z, cell);
+    const float tx = smooth(static_cast<float>(x - cx * cell) / cell);
+    const float ty = smooth(static_cast<float>(y - cy * cell) / cell);
+    const float tz = smooth(static_cast<float>(z - cz * cell) / cell);
+    const uint64_t seed = m_seed ^ salt;
+
+    float layers[2];
+    for (int dy = 0; dy < 2; dy++)
+    {
+        layers[dy] = lerp(
+            lerp(
+                latticeValue(seed, cx, cy + dy, cz),
+                latticeValue(seed, cx + 1, cy + dy, cz),
+                tx
+            ),
+            lerp(
+                latticeValue(seed, cx, cy + dy, cz + 1),
+                latticeValue(seed, cx + 1, cy + dy, cz + 1),
+                tx
+            ),
+            tz
+        );
+    }
+    return lerp(layers[0], layers[1], ty);
+}
+
+int TerrainGenerator::surfaceHeight(int x, int z) const
+{
+    const float noise = valueNoise2D(x, z, 64, 1) * 0.6f +
+                        valueNoise2D(x, z, 24, 2) * 0.3f +
+                        valueNoise2D(x, z, 8, 3) * 0.1f;
+    return static_cast<int>(
+        std::floor(BASE_HEIGHT + (noise - 0.5f) * HEIGHT_RANGE)
+    );
+}
+
+bool TerrainGenerator::isCave(int x, int y, int z) const
+{
+    return valueNoise3D(x, y, z, 16, 4) > 0.72f;
+}
+
+void TerrainGenerator::generate(Chunk& chunk) const
+{
+    const glm::ivec3 origin = chunk.worldOrigin();
+    for (int z = 0; z < CHUNK_SIZE; z++)
+    {
+        for (int x = 0; x < CHUNK_SIZE; x++)
+        {
+            const int worldX = origin.x + x;
+            const int worldZ = origin.z + z;
+            const int height = surfaceHeight(worldX, worldZ);
+            const bool beach = height <= SEA_LEVEL + 1;
+
+            for (int y = 0; y < CHUNK_SIZE; y++)
+            {
+                const int worldY = origin.y + y;
+                BlockId id = Blocks::AIR;
+                if (worldY > height)
+                {
+                    id = worldY <= SEA_LEVEL ? Blocks::WATER : Blocks::AIR;
+                }
+                else if (worldY < height - 3 && isCave(worldX, worldY, worldZ))
+                {
+                    id = Blocks::AIR;
+                }
+                else if (worldY == height)
+                {
+                    id = beach ? Blocks::SAND : Blocks::GRASS;
+                }
+                else if (worldY > height - 4)
+                {
+                    id = beach ? Blocks::SAND : Blocks::DIRT;
+                }
+                else
+                {
+                    id = Blocks::STONE;
+                }
+                chunk.setBlock(localIndex(x, y, z), id);
+            }
+        }
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include "world/chunk.h"
+
+// Seeded heightmap terrain with caves and a water level. Output depends only
+// on the seed and the chunk coordinate, so chunks can be generated in any
+// order and on any thread.
+class TerrainGenerator
+{
+  private:
+    static constexpr int SEA_LEVEL{ 0 };
+    static constexpr float BASE_HEIGHT{ 4.0f };
+    static constexpr float HEIGHT_RANGE{ 40.0f };
+
+    uint64_t m_seed;
+
+    // Smooth noise in [0, 1] on a lattice of the given cell size
+    float valueNoise2D(int x, int z, int cell, uint64_t salt) const;
+    float valueNoise3D(int x, int y, int z, int cell, uint64_t salt) const;
+    int surfaceHeight(int x, int z) const;
+    bool isCave(int x, int y, int z) const;
+
+  public:
+    explicit TerrainGenerator(uint64_t seed);
+
+    // Fills blocks only; lighting is left to LightEngine::onChunkLoaded()
+    void generate(Chunk& chunk) const;
+};
@@ -0,0 +1,215 @@
+#include "visibility.h"
+#include <bitset>
+#include "core/profiling/profiler.h"
+
+namespace
+{
+constexpr uint8_t ALL_FACES{ 0x3F };
+
+const std::array<glm::ivec3, 6> FACE_DIRECTIONS{
+    glm::ivec3{ 1, 0, 0 },
+    glm::ivec3{ -1, 0, 0 },
+    glm::ivec3{ 0, 1, 0 },
+    glm::ivec3{ 0, -1, 0 },
+    glm::ivec3{ 0, 0, 1 },
+    glm::ivec3{ 0, 0, -1 },
+};
+
+// BlockFace pairs each direction with its opposite
+uint32_t opposite(uint32_t face)
+{
+    return face ^ 1;
+}
+
+uint8_t boundaryFaces(int x, int y, int z)
+{
+    uint8_t faces = 0;
+    faces |= x == CHUNK_SIZE - 1 ? 1 << static_cast<int>(BlockFace::PosX) : 0;
+    faces |= x == 0 ? 1 << static_cast<int>(BlockFace::NegX) : 0;
+    faces |= y == CHUNK_SIZE - 1 ? 1 << static_cast<int>(BlockFace::PosY) : 0;
+    faces |= y == 0 ? 1 << static_cast<int>(BlockFace::NegY) : 0;
+    faces |= z == CHUNK_SIZE - 1 ? 1 << static_cast<int>(BlockFace::PosZ) : 0;
+    faces |= z == 0 ? 1 << static_cast<int>(BlockFace::NegZ) : 0;
+    return faces;
+}
+} // namespace
+
+ChunkConnectivity ChunkConnectivity::all()
+{
+    ChunkConnectivity connectivity;
+    connectivity.connect(ALL_FACES);
+    return connectivity;
+}
+
+void ChunkConnectivity::connect(uint8_t faceMask)
+{
+    for (uint32_t face = 0; face < 6; face++)
+    {
+        if ((faceMask >> face) & 1)
+        {
+            m_reachable[face] |= faceMask;
+        }
+    }
+}
+
+ChunkConnectivity computeConnectivity(const ChunkNeighborhood& neighborhood)
+{
+    PROFILE_ZONE("computeConnectivity");
+    std::bitset<CHUNK_VOLUME> visited;
+    uint32_t open = 0;
+    for (int y = 0; y < CHUNK_SIZE; y++)
+    {
+        for (int z = 0; z < CHUNK_SIZE; z++)
+        {
+            for (int x = 0; x < CHUNK_SIZE; x++)
+            {
+                if (isOpaque(neighborhood.block(x, y, z)))
+                {
+                    visited.set(localIndex(x, y, z));
+                }
+                else
+                {
+                    open++;
+                }
+            }
+        }
+    }
+
+    ChunkConnectivity connectivity;
+    if (open == CHUNK_VOLUME)
+    {
+        return ChunkConnectivity::all();
+    }
+    if (open == 0)
+    {
+        return connectivity;
+    }
+
+    // One flood fill per region of connected open voxels; each region links
+    // the faces it touches
+    constexpr int STRIDE_Z{ CHUNK_SIZE };
+    constexpr int STRIDE_Y{ CHUNK_AREA };
+    std::vector<uint16_t> stack;
+    auto push = [&](int index) {
+        if (!visited.test(index))
+        {
+            visited.set(index);
+            stack.push_back(static_cast<uint16_t>(index));
+        }
+    };
+    for (int start = 0; start < CHUNK_VOLUME; start++)
+    {
+        if (visited.test(start))
+        {
+            continue;
+        }
+        push(start);
+        uint8_t faces = 0;
+        while (!stack.empty())
+        {
+            const int index = stack.back();
+            stack.pop_back();
+            const int x = index & CHUNK_MASK;
+            const int z = (index >> CHUNK_SHIFT) & CHUNK_MASK;
+            const int y = index >> (2 * CHUNK_SHIFT);
+            faces |= boundaryFaces(x, y, z);
+
+            if (x < CHUNK_SIZE - 1)
+            {
+                push(index + 1);
+            }
+            if (x > 0)
+            {
+                push(index - 1);
+            }
+            if (y < CHUNK_SIZE - 1)
+            {
+                push(index + STRIDE_Y);
+            }
+            if (y > 0)
+            {
+                push(index - STRIDE_Y);
+            }
+            if (z < CHUNK_SIZE - 1)
+            {
+                push(index + STRIDE_Z);
+            }
+            if (z > 0)
+            {
+                push(index - STRIDE_Z);
+            }
+        }
+        connectivity.connect(faces);
+    }
+    return connectivity;
+}
+
+void ChunkVisibility::update(
+    const ChunkCoord& coord, const ChunkConnectivity& connectivity
+)
+{
+    m_chunks[coord] = connectivity;
+}
+
+void ChunkVisibility::remove(const ChunkCoord& coord)
+{
+    m_chunks.erase(coord);
+}
+
+void ChunkVisibility::findVisible(
+    const glm::vec3& cameraPos, std::vector<ChunkCoord>& visible
+)
+{
+    PROFILE_ZONE("ChunkVisibility::findVisible");
+    visible.clear();
+    m_queue.clear();
+    m_visited.clear();
+
+    const ChunkCoord start = toChunkCoord(glm::ivec3(glm::floor(cameraPos)));
+    m_queue.push_back(Step{ .coord = start });
+    m_visited.insert(start);
+
+    // m_queue doubles as the FIFO; BFS order is nearest first
+    for (size_t head = 0; head < m_queue.size(); head++)
+    {
+        const Step step = m_queue[head];
+        visible.push_back(step.coord);
+
+        // The camera's own chunk is left through any face
+        const bool isStart = step.entry >= 6;
+        const ChunkConnectivity* connectivity =
+            isStart ? nullptr : &m_chunks.at(step.coord);
+
+        for (uint32_t exit = 0; exit < 6; exit++)
+        {
+            if ((step.directions >> opposite(exit)) & 1)
+            {
+                continue;
+            }
+            if (!isStart &&
+                !connectivity->connects(
+                    static_cast<BlockFace>(step.entry),
+                    static_cast<BlockFace>(exit)
+                ))
+            {
+                continue;
+            }
+            const ChunkCoord next = step.coord + FACE_DIRECTIONS[exit];
+            if (!m_chunks.contains(next) || !m_visited.insert(next).second)
+            {
+                continue;
+            }
+            m_queue.push_back(Step{
+                .coord = next,
+                .entry = static_cast<uint8_t>(opposite(exit)),
+                .directions = static_cast<uint8_t>(step.directions |
+                                                   (1 << exit)),
+            });
+        }
+    }
+}
+
+size_t ChunkVisibility::chunkCount() const
+{
+    return m_chunks.size();
+}
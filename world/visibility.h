@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <glm/glm.hpp>
+#include "world/chunk.h"
+#include "world/mesher.h"
+
+// Which pairs of a chunk's six faces are linked by a path through
+// non-opaque voxels inside the chunk. Faces are indexed by BlockFace.
+class ChunkConnectivity
+{
+  private:
+    // Bit j of m_reachable[i] is set when face i connects to face j
+    std::array<uint8_t, 6> m_reachable{};
+
+  public:
+    static ChunkConnectivity all();
+
+    // Links every face in the mask with every other one
+    void connect(uint8_t faceMask);
+    bool connects(BlockFace from, BlockFace to) const
+    {
+        return (m_reachable[static_cast<size_t>(from)] >>
+                static_cast<uint32_t>(to)) &
+               1;
+    }
+};
+
+// Flood fills the chunk's non-opaque voxels once per region; a few tenths
+// of a millisecond, so it runs next to meshing on the same neighbourhood
+ChunkConnectivity computeConnectivity(const ChunkNeighborhood& neighborhood);
+
+// CPU occlusion culling through chunk connectivity.
+//
+// findVisible() walks chunks breadth-first from the camera's chunk. A step
+// from one chunk into the next is only taken if the face it entered
+// through connects to the face it leaves through, and never in a direction
+// opposite to one already taken, so the walk always moves away from the
+// camera. Caves and sealed rooms that no open path reaches from the camera
+// are never visited, which usually removes most chunks underground before
+// any GPU work, and it needs nothing from the GPU.
+//
+// Only chunks with known connectivity are entered; a chunk not meshed yet
+// hides what is behind it until its first mesh is done.
+class ChunkVisibility
+{
+  private:
+    struct Step
+    {
+        ChunkCoord coord{ 0 };
+        // Face of this chunk the walk came in through; 6 for the start
+        uint8_t entry{ 6 };
+        // BlockFace bits of every direction taken so far
+        uint8_t directions{ 0 };
+    };
+
+    std::unordered_map<ChunkCoord, ChunkConnectivity, ChunkCoordHash>
+        m_chunks;
+    std::vector<Step> m_queue;
+    std::unordered_set<ChunkCoord, ChunkCoordHash> m_visited;
+
+  public:
+    void update(const ChunkCoord& coord, const ChunkConnectivity& connectivity);
+    void remove(const ChunkCoord& coord);
+
+    // Replaces `visible` with the reachable chunks, nearest first
+    void findVisible(
+        const glm::vec3& cameraPos, std::vector<ChunkCoord>& visible
+    );
+
+    size_t chunkCount() const;
+};
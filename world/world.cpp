@@ -0,0 +1,85 @@
+#include "world.h"
+#include <vector>
+#include "core/jobs/epoch.h"
+
+World::~World()
+{
+    std::vector<Chunk*> chunks;
+    chunks.reserve(m_chunks.size());
+    m_chunks.forEach([&](Chunk& chunk) { chunks.push_back(&chunk); });
+    for (Chunk* chunk : chunks)
+    {
+        delete m_chunks.remove(chunk->coord());
+    }
+}
+
+Chunk* World::getChunk(const ChunkCoord& coord) const
+{
+    return m_chunks.find(coord);
+}
+
+Chunk& World::createChunk(const ChunkCoord& coord)
+{
+    if (Chunk* chunk = m_chunks.find(coord))
+    {
+        return *chunk;
+    }
+    auto* chunk = new Chunk(coord);
+    Chunk* inserted = m_chunks.insert(chunk);
+    if (inserted != chunk)
+    {
+        // Another thread created it first
+        delete chunk;
+    }
+    return *inserted;
+}
+
+void World::removeChunk(const ChunkCoord& coord)
+{
+    if (Chunk* chunk = m_chunks.remove(coord))
+    {
+        EpochReclaimer::get().retire(chunk);
+    }
+}
+
+size_t World::chunkCount() const
+{
+    return m_chunks.size();
+}
+
+void World::publish()
+{
+    m_chunks.forEach([](Chunk& chunk) { chunk.publish(); });
+    EpochReclaimer::get().reclaim();
+}
+
+BlockId World::getBlock(const glm::ivec3& worldPos) const
+{
+    Chunk* chunk = getChunk(toChunkCoord(worldPos));
+    if (!chunk)
+    {
+        return Blocks::AIR;
+    }
+    return chunk->getBlock(localIndex(toLocalPos(worldPos)));
+}
+
+uint8_t World::getMeta(const glm::ivec3& worldPos) const
+{
+    Chunk* chunk = getChunk(toChunkCoord(worldPos));
+    if (!chunk)
+    {
+        return 0;
+    }
+    return chunk->getMeta(localIndex(toLocalPos(worldPos)));
+}
+
+bool World::setBlock(const glm::ivec3& worldPos, BlockId id, uint8_t meta)
+{
+    Chunk* chunk = getChunk(toChunkCoord(worldPos));
+    if (!chunk)
+    {
+        return false;
+    }
+    chunk->setBlock(localIndex(toLocalPos(worldPos)), id, meta);
+    return true;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include "world/chunk.h"
+#include "world/chunk_map.h"
+
+class World
+{
+  private:
+    ChunkMap m_chunks;
+
+  public:
+    World() = default;
+    ~World();
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    // Wait-free from any thread. Removed chunks are retired through the
+    // EpochReclaimer, so a chunk stays valid while the caller holds an
+    // EpochGuard; without one, only while nothing removes chunks.
+    Chunk* getChunk(const ChunkCoord& coord) const;
+    Chunk& createChunk(const ChunkCoord& coord);
+    void removeChunk(const ChunkCoord& coord);
+    size_t chunkCount() const;
+
+    // Publishes every chunk edited since the last call and frees chunk
+    // versions no reader can reach any more; once per tick, after all
+    // edits and lighting
+    void publish();
+
+    // Unloaded positions read as air and ignore writes
+    BlockId getBlock(const glm::ivec3& worldPos) const;
+    uint8_t getMeta(const glm::ivec3& worldPos) const;
+    bool setBlock(const glm::ivec3& worldPos, BlockId id, uint8_t meta = 0);
+
+    template <typename Fn> void forEachChunk(Fn&& fn)
+    {
+        m_chunks.forEach(fn);
+    }
+};